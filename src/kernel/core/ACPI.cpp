@@ -0,0 +1,207 @@
+#include "ACPI.h"
+
+#include "fb.h"
+#include "Kmap.h"
+#include "memory.h"
+#include "../utils/comparison.h"
+
+uint ACPI::lapic_address = 0;
+uint ACPI::num_cpus = 1;
+uint8_t ACPI::apic_ids[MAX_CPUS]{};
+uint ACPI::io_apic_address = 0;
+uint ACPI::io_apic_gsi_base = 0;
+uint ACPI::isa_irq_gsis[ISA_IRQS] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}; // Identity unless overridden
+uint16_t ACPI::isa_irq_flags[ISA_IRQS]{};
+
+void ACPI::read_physical(void* dst, uint phys_addr, uint n)
+{
+    auto d = (char*)dst;
+    while (n)
+    {
+        const uint offset = phys_addr & (PAGE_SIZE - 1);
+        const uint count = min(n, PAGE_SIZE - offset);
+        const auto page = (const char*)Memory::Kmap::map(ADDR_PAGE(phys_addr));
+        memcpy(d, page + offset, count);
+        Memory::Kmap::unmap(page);
+
+        d += count;
+        phys_addr += count;
+        n -= count;
+    }
+}
+
+bool ACPI::checksum_is_valid(const void* data, uint n)
+{
+    uint8_t sum = 0;
+    for (uint i = 0; i < n; i++)
+        sum += ((const uint8_t*)data)[i];
+
+    return sum == 0;
+}
+
+uint ACPI::find_rsdp()
+{
+    uint16_t ebda_segment;
+    read_physical(&ebda_segment, ACPI_EBDA_SEGMENT_PTR, sizeof(ebda_segment));
+    const uint ebda = (uint)ebda_segment << 4;
+
+    // Regions to scan, [start, end[. The RSDP is 16 bytes aligned
+    const uint regions[2][2] = {{ebda, ebda + 1024}, {ACPI_BIOS_AREA_START, ACPI_BIOS_AREA_END}};
+    for (const auto& region : regions)
+    {
+        if (!region[0])
+            continue;
+        for (uint addr = region[0] & ~0xF; addr < region[1]; addr += 16)
+        {
+            rsdp r;
+            read_physical(&r, addr, sizeof(r));
+            if (!memcmp(r.signature, ACPI_RSDP_SIGNATURE, sizeof(r.signature)) && checksum_is_valid(&r, sizeof(r)))
+                return addr;
+        }
+    }
+
+    return 0;
+}
+
+ACPI::sdt_header* ACPI::load_table(uint phys_addr)
+{
+    sdt_header header;
+    read_physical(&header, phys_addr, sizeof(header));
+
+    auto table = (sdt_header*)malloc(header.length);
+    if (!table)
+        return nullptr;
+    read_physical(table, phys_addr, header.length);
+    if (!checksum_is_valid(table, header.length))
+    {
+        printf_warn("ACPI table at 0x%x has an invalid checksum, ignoring it", phys_addr);
+        free(table);
+        return nullptr;
+    }
+
+    return table;
+}
+
+void ACPI::parse_madt(const madt* madt)
+{
+    lapic_address = madt->lapic_address;
+    num_cpus = 0;
+
+    auto entry = (const madt_entry*)(madt + 1);
+    const auto end = (const madt_entry*)((uint)madt + madt->header.length);
+    for (; entry < end && entry->length; entry = (const madt_entry*)((uint)entry + entry->length))
+    {
+        if (entry->type == MADT_IO_APIC)
+        {
+            const auto io_apic = (const madt_io_apic*)entry;
+            if (io_apic_address)
+                printf_warn("Ignoring I/O APIC with ID %u, only one is supported", io_apic->io_apic_id);
+            else
+            {
+                io_apic_address = io_apic->io_apic_address;
+                io_apic_gsi_base = io_apic->gsi_base;
+            }
+            continue;
+        }
+        if (entry->type == MADT_INTERRUPT_SOURCE_OVERRIDE)
+        {
+            const auto source_override = (const madt_interrupt_source_override*)entry;
+            if (source_override->source < ISA_IRQS)
+            {
+                isa_irq_gsis[source_override->source] = source_override->gsi;
+                isa_irq_flags[source_override->source] = source_override->flags;
+            }
+            continue;
+        }
+        if (entry->type != MADT_LOCAL_APIC)
+            continue;
+
+        const auto lapic = (const madt_local_apic*)entry;
+        if (!(lapic->flags & (MADT_LOCAL_APIC_ENABLED | MADT_LOCAL_APIC_ONLINE_CAPABLE)))
+            continue;
+        if (num_cpus == MAX_CPUS)
+        {
+            printf_warn("More than %u processors, ignoring processor with APIC ID %u", MAX_CPUS, lapic->apic_id);
+            continue;
+        }
+        apic_ids[num_cpus++] = lapic->apic_id;
+    }
+
+    // A MADT without any processor is broken, carry on with the bootstrap processor only
+    if (!num_cpus)
+    {
+        lapic_address = io_apic_address = 0;
+        num_cpus = 1;
+    }
+}
+
+void ACPI::init()
+{
+    const uint rsdp_addr = find_rsdp();
+    if (!rsdp_addr)
+    {
+        printf_warn("ACPI RSDP not found, only the bootstrap processor and the PIC will be used");
+        return;
+    }
+
+    rsdp r;
+    read_physical(&r, rsdp_addr, sizeof(r));
+    sdt_header* rsdt = load_table(r.rsdt_address);
+    if (!rsdt)
+        return;
+
+    // The RSDT is followed by the physical addresses of the other tables
+    const uint num_tables = (rsdt->length - sizeof(sdt_header)) / sizeof(uint32_t);
+    const auto tables = (const uint32_t*)(rsdt + 1);
+    for (uint i = 0; i < num_tables; i++)
+    {
+        sdt_header header;
+        read_physical(&header, tables[i], sizeof(header));
+        if (memcmp(header.signature, ACPI_MADT_SIGNATURE, sizeof(header.signature)))
+            continue;
+
+        if (auto madt = (ACPI::madt*)load_table(tables[i]))
+        {
+            parse_madt(madt);
+            free(madt);
+        }
+        break;
+    }
+
+    free(rsdt);
+}
+
+uint ACPI::get_lapic_address()
+{
+    return lapic_address;
+}
+
+uint ACPI::get_num_cpus()
+{
+    return num_cpus;
+}
+
+uint8_t ACPI::get_apic_id(uint i)
+{
+    return apic_ids[i];
+}
+
+uint ACPI::get_io_apic_address()
+{
+    return io_apic_address;
+}
+
+uint ACPI::get_io_apic_gsi_base()
+{
+    return io_apic_gsi_base;
+}
+
+uint ACPI::get_isa_irq_gsi(uint8_t irq)
+{
+    return isa_irq_gsis[irq];
+}
+
+uint16_t ACPI::get_isa_irq_flags(uint8_t irq)
+{
+    return isa_irq_flags[irq];
+}
@@ -0,0 +1,164 @@
+#ifndef CUSTOM_OS_ACPI_H
+#define CUSTOM_OS_ACPI_H
+
+#include <kstddef.h>
+#include <stdint.h>
+
+#include "SMP.h"
+
+#define ACPI_RSDP_SIGNATURE "RSD PTR "
+#define ACPI_MADT_SIGNATURE "APIC"
+#define ACPI_BIOS_AREA_START 0xE0000 // RSDP lies in the BIOS read-only area, or in the first KiB of the EBDA
+#define ACPI_BIOS_AREA_END 0x100000
+#define ACPI_EBDA_SEGMENT_PTR 0x40E // BIOS data area word holding the EBDA real mode segment
+
+#define MADT_LOCAL_APIC 0
+#define MADT_IO_APIC 1
+#define MADT_INTERRUPT_SOURCE_OVERRIDE 2
+#define MADT_LOCAL_APIC_ENABLED 0x1
+#define MADT_LOCAL_APIC_ONLINE_CAPABLE 0x2
+
+#define ISA_IRQS 16
+
+// Interrupt source override flags (MPS INTI flags). "Conforms" means the default of the bus
+#define MADT_POLARITY_MASK 0x3
+#define MADT_POLARITY_ACTIVE_HIGH 0x1
+#define MADT_POLARITY_ACTIVE_LOW 0x3
+#define MADT_TRIGGER_MASK 0xC
+#define MADT_TRIGGER_EDGE 0x4
+#define MADT_TRIGGER_LEVEL 0xC
+
+//https://wiki.osdev.org/RSDP
+//https://wiki.osdev.org/MADT
+
+class ACPI
+{
+	// Root System Description Pointer, ACPI 1.0 part (enough to get the RSDT)
+	struct rsdp
+	{
+		char signature[8];
+		uint8_t checksum;
+		char oem_id[6];
+		uint8_t revision;
+		uint32_t rsdt_address;
+	} __attribute__((packed));
+
+	// Header of every System Description Table
+	struct sdt_header
+	{
+		char signature[4];
+		uint32_t length;
+		uint8_t revision;
+		uint8_t checksum;
+		char oem_id[6];
+		char oem_table_id[8];
+		uint32_t oem_revision;
+		uint32_t creator_id;
+		uint32_t creator_revision;
+	} __attribute__((packed));
+
+	// Multiple APIC Description Table, followed by variable length entries
+	struct madt
+	{
+		sdt_header header;
+		uint32_t lapic_address;
+		uint32_t flags;
+	} __attribute__((packed));
+
+	struct madt_entry
+	{
+		uint8_t type;
+		uint8_t length;
+	} __attribute__((packed));
+
+	struct madt_local_apic
+	{
+		madt_entry entry;
+		uint8_t processor_id;
+		uint8_t apic_id;
+		uint32_t flags;
+	} __attribute__((packed));
+
+	struct madt_io_apic
+	{
+		madt_entry entry;
+		uint8_t io_apic_id;
+		uint8_t reserved;
+		uint32_t io_apic_address;
+		uint32_t gsi_base; // First global system interrupt handled by this I/O APIC
+	} __attribute__((packed));
+
+	// ISA IRQ wired to another I/O APIC input than the one of the same number, or with non-ISA polarity/trigger
+	struct madt_interrupt_source_override
+	{
+		madt_entry entry;
+		uint8_t bus;
+		uint8_t source; // ISA IRQ
+		uint32_t gsi;
+		uint16_t flags;
+	} __attribute__((packed));
+
+	static uint lapic_address; // Physical address of the local APICs registers, 0 if there is no MADT
+	static uint num_cpus;
+	static uint8_t apic_ids[MAX_CPUS]; // Local APIC ID of each usable processor, in MADT order
+	static uint io_apic_address; // Physical address of the first I/O APIC registers, 0 if there is none
+	static uint io_apic_gsi_base;
+	static uint isa_irq_gsis[ISA_IRQS]; // Global system interrupt of each ISA IRQ
+	static uint16_t isa_irq_flags[ISA_IRQS]; // Polarity and trigger mode of each ISA IRQ, 0 if they conform to ISA
+
+	/**
+	 * Copies physical memory, which may not be mapped, into a kernel buffer
+	 * @param dst buffer to copy to
+	 * @param phys_addr physical address to copy from
+	 * @param n number of bytes to copy
+	 */
+	static void read_physical(void* dst, uint phys_addr, uint n);
+
+	static bool checksum_is_valid(const void* data, uint n);
+
+	/**
+	 * Looks for the RSDP in the EBDA and in the BIOS read-only area
+	 * @return RSDP physical address, 0 if not found
+	 */
+	static uint find_rsdp();
+
+	/**
+	 * Copies a table and checks it
+	 * @param phys_addr physical address of the table
+	 * @return the table, to be freed by the caller. nullptr if its checksum is wrong or memory is full
+	 */
+	static sdt_header* load_table(uint phys_addr);
+
+	static void parse_madt(const madt* madt);
+
+public:
+	/**
+	 * Looks for the tables describing the processors and interrupt controllers, and parses them.
+	 * Shall be called early: the frame allocator is not aware of the memory holding ACPI tables, they have to be read
+	 * before their frames are handed out.
+	 */
+	static void init();
+
+	/** Physical address of the local APICs registers, 0 if unknown */
+	[[nodiscard]] static uint get_lapic_address();
+
+	/** Number of usable processors, at least 1 */
+	[[nodiscard]] static uint get_num_cpus();
+
+	/** Local APIC ID of the i-th usable processor */
+	[[nodiscard]] static uint8_t get_apic_id(uint i);
+
+	/** Physical address of the I/O APIC registers, 0 if unknown. Only the first I/O APIC is used */
+	[[nodiscard]] static uint get_io_apic_address();
+
+	/** First global system interrupt handled by the I/O APIC */
+	[[nodiscard]] static uint get_io_apic_gsi_base();
+
+	/** Global system interrupt an ISA IRQ is wired to */
+	[[nodiscard]] static uint get_isa_irq_gsi(uint8_t irq);
+
+	/** Polarity and trigger mode of an ISA IRQ (MADT_POLARITY_* | MADT_TRIGGER_*), 0 if they conform to the bus */
+	[[nodiscard]] static uint16_t get_isa_irq_flags(uint8_t irq);
+};
+
+#endif //CUSTOM_OS_ACPI_H
@@ -0,0 +1,164 @@
+#include "BuddyAllocator.h"
+
+#include "RawMemory.h"
+#include "../utils/comparison.h"
+
+[[noreturn]]
+extern __attribute__ ((format (printf, 1, 2))) int irrecoverable_error(const char* format, ...);
+
+#define TREE_HEIGHT 20 // log2(NUM_FRAMES)
+#define LEAF(frame_id) ((frame_id) + NUM_FRAMES)
+
+namespace Memory
+{
+    uint8_t* BuddyAllocator::tree = nullptr;
+    uint BuddyAllocator::first_allocatable_frame = 0;
+    uint BuddyAllocator::free_blocks[MAX_ORDER + 1]{};
+    uint BuddyAllocator::num_free_frames = 0;
+
+    static_assert(1U << TREE_HEIGHT == BuddyAllocator::NUM_FRAMES);
+
+    bool BuddyAllocator::is_fully_free(uint node, uint level)
+    {
+        return level <= MAX_ORDER && tree[node] == level + 1;
+    }
+
+    bool BuddyAllocator::is_free_block(uint node, uint level)
+    {
+        return is_fully_free(node, level) && (level == MAX_ORDER || !is_fully_free(node >> 1, level + 1));
+    }
+
+    void BuddyAllocator::update_node(uint node, uint level)
+    {
+        const uint8_t l = tree[2 * node];
+        const uint8_t r = tree[2 * node + 1];
+
+        // Both children are fully free and can be merged into a block of order level
+        if (level <= MAX_ORDER && l == level && r == level)
+            tree[node] = level + 1;
+        else
+            tree[node] = max(l, r);
+    }
+
+    void BuddyAllocator::account_path(uint leaf, int sign)
+    {
+        uint node = leaf;
+        for (uint level = 0; level <= MAX_ORDER; level++, node >>= 1)
+        {
+            free_blocks[level] += sign * is_free_block(node, level);
+            free_blocks[level] += sign * is_free_block(node ^ 1, level);
+        }
+    }
+
+    void BuddyAllocator::set_leaf(uint frame_id, uint8_t val)
+    {
+        const uint leaf = LEAF(frame_id);
+        if (tree[leaf] == val)
+            return;
+
+        account_path(leaf, -1);
+
+        num_free_frames += val ? 1 : -1;
+        tree[leaf] = val;
+        uint node = leaf >> 1;
+        for (uint level = 1; node; level++, node >>= 1)
+        {
+            const uint8_t prev = tree[node];
+            update_node(node, level);
+            if (tree[node] == prev) // Ancestors are not affected anymore
+                break;
+        }
+
+        account_path(leaf, 1);
+    }
+
+    void BuddyAllocator::init(void* tree_mem, uint first_allocatable)
+    {
+        tree = static_cast<uint8_t*>(tree_mem);
+        first_allocatable_frame = first_allocatable;
+
+        // Leaves
+        num_free_frames = 0;
+        for (uint frame_id = 0; frame_id < NUM_FRAMES; frame_id++)
+        {
+            const bool free = frame_id >= first_allocatable_frame && FRAME_FREE(frame_id);
+            tree[LEAF(frame_id)] = free;
+            num_free_frames += free;
+        }
+
+        // Inner nodes, bottom-up
+        for (uint level = 1; level <= TREE_HEIGHT; level++)
+            for (uint node = NUM_FRAMES >> level; node < (NUM_FRAMES >> level) << 1; node++)
+                update_node(node, level);
+
+        // Free blocks
+        for (uint level = 0; level <= MAX_ORDER; level++)
+        {
+            free_blocks[level] = 0;
+            for (uint node = NUM_FRAMES >> level; node < (NUM_FRAMES >> level) << 1; node++)
+                free_blocks[level] += is_free_block(node, level);
+        }
+    }
+
+    uint BuddyAllocator::get_free_frame()
+    {
+        const uint frame_id = get_free_block(0);
+
+        return frame_id == (uint)-1 ? NUM_FRAMES : frame_id;
+    }
+
+    uint BuddyAllocator::get_free_block(uint order)
+    {
+        if (order > MAX_ORDER || tree[1] < order + 1)
+            return (uint)-1;
+
+        // Walk down to the leftmost node of the requested order which is entirely free
+        uint node = 1;
+        for (uint level = TREE_HEIGHT; level > order; level--)
+            node = tree[2 * node] >= order + 1 ? 2 * node : 2 * node + 1;
+
+        return (node << order) - NUM_FRAMES;
+    }
+
+    uint BuddyAllocator::get_contiguous_frames(uint n)
+    {
+        if (!n)
+            return (uint)-1;
+
+        const uint order = n == 1 ? 0 : 32 - __builtin_clz(n - 1);
+        return get_free_block(order);
+    }
+
+    void BuddyAllocator::mark_used(uint frame_id)
+    {
+        if (frame_id >= NUM_FRAMES)
+            irrecoverable_error("%s: invalid frame id 0x%x", __PRETTY_FUNCTION__, frame_id);
+        if (!tree) // Not initialized yet, init will read frame_to_page
+            return;
+        set_leaf(frame_id, 0);
+    }
+
+    void BuddyAllocator::mark_free(uint frame_id)
+    {
+        if (frame_id >= NUM_FRAMES)
+            irrecoverable_error("%s: invalid frame id 0x%x", __PRETTY_FUNCTION__, frame_id);
+
+        if (!tree)
+            return;
+
+        // Reserved frames can be mapped and unmapped (cf. register_physical_data), but must never be handed out
+        if (frame_id < first_allocatable_frame)
+            return;
+        set_leaf(frame_id, 1);
+    }
+
+    uint BuddyAllocator::get_num_free_blocks(uint order)
+    {
+        return order > MAX_ORDER ? 0 : free_blocks[order];
+    }
+
+    uint BuddyAllocator::get_num_free_frames()
+    {
+        return num_free_frames;
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdint.h>
+#include "MemoryDefines.h"
+
+namespace Memory
+{
+    /**
+     * Physical frame allocator.
+     *
+     * Frames are tracked by a complete binary tree stored as an array (node 1 is the root, node i has children 2i and
+     * 2i + 1, frame f is leaf f + NUM_FRAMES). Each node stores 1 + the order of the largest free block lying in its
+     * subtree, 0 meaning that there is no free frame below it. Two fully free buddies of order k < MAX_ORDER merge into
+     * a free block of order k + 1, blocks never grow bigger than MAX_ORDER.
+     *
+     * Finding the lowest free block of a given order is then a single root to leaf walk, and freeing a frame is a
+     * single leaf to root walk. Lowest addresses are always preferred, as the actual RAM size is not known (yet).
+     *
+     * The allocator only tells which frames are free. Frame ownership (frame_to_page, frame_rc) is still handled by
+     * the callers, which report every state change through mark_used and mark_free (cf. MARK_FRAME_USED and
+     * MARK_FRAME_FREE).
+     */
+    class BuddyAllocator
+    {
+    public:
+        static constexpr uint MAX_ORDER = 10;
+        static constexpr uint NUM_FRAMES = PDT_ENTRIES * PT_ENTRIES;
+        static constexpr uint TREE_SIZE = 2 * NUM_FRAMES; // In bytes
+    private:
+        static uint8_t* tree;
+        static uint first_allocatable_frame; // Frames below it are never handed out (kernel, BIOS, memory metadata)
+        static uint free_blocks[MAX_ORDER + 1]; // Number of free blocks per order
+        static uint num_free_frames;
+
+        /** Whether a node covering 2^level frames is entirely free */
+        static bool is_fully_free(uint node, uint level);
+
+        /** Whether a node is a free block on its own, ie it is fully free and cannot be merged with its buddy */
+        static bool is_free_block(uint node, uint level);
+
+        /** Recomputes a node value from its children */
+        static void update_node(uint node, uint level);
+
+        /** Adds (or removes) the free blocks found on the path from a leaf to the biggest block containing it */
+        static void account_path(uint leaf, int sign);
+
+        /** Sets a leaf value and propagates the change to its ancestors */
+        static void set_leaf(uint frame_id, uint8_t val);
+
+    public:
+        /**
+         * Builds the tree from frame_to_page
+         * @param tree_mem TREE_SIZE bytes of memory to store the tree in
+         * @param first_allocatable frames below that one will never be returned
+         */
+        static void init(void* tree_mem, uint first_allocatable);
+
+        /**
+         * Gets the lowest free frame. Frame is not marked as used.
+         * @return frame id, NUM_FRAMES if memory is full
+         */
+        static uint get_free_frame();
+
+        /**
+         * Gets the lowest free naturally aligned block of 2^order frames. Frames are not marked as used.
+         * @return id of the first frame of the block, (uint)-1 if there is none
+         */
+        static uint get_free_block(uint order);
+
+        /**
+         * Gets n physically contiguous free frames. Frames are not marked as used.
+         * @return id of the first frame of the block, (uint)-1 if there is none or if n > 2^MAX_ORDER
+         */
+        static uint get_contiguous_frames(uint n);
+
+        /** Registers a frame as allocated */
+        static void mark_used(uint frame_id);
+
+        /** Registers a frame as free */
+        static void mark_free(uint frame_id);
+
+        /** Number of free blocks of a given order. Helps watching fragmentation */
+        [[nodiscard]] static uint get_num_free_blocks(uint order);
+
+        [[nodiscard]] static uint get_num_free_frames();
+    };
+}
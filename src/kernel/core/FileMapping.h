@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+#include "MemoryDefines.h"
+#include "../file_management/dentry.h"
+#include "../utils/shared_pointer.h"
+
+namespace Memory
+{
+    /**
+     * Range of a process address space whose content comes from a file.
+     * Its pages are mapped PAGE_LAZY_ZERO | PAGE_FILE and only get read, FILE_READAHEAD_N_PAGES at a time, when they
+     * are first accessed.
+     */
+    struct file_mapping
+    {
+        uintptr_t start, end; // Page aligned
+        SharedPointer<Dentry> file;
+        uint offset; // Offset in the file of the first byte of the range
+        uint file_size; // Bytes of the range that come from the file, the remaining ones read as zeroes
+
+        /** Mappings of a process do not overlap, a mapping is identified by its range */
+        bool operator==(const file_mapping& other) const
+        {
+            return start == other.start && end == other.end;
+        }
+    };
+}
@@ -1,17 +1,19 @@
 #include "GDT.h"
 
-tss_entry_t tss;
+tss_entry_t GDT::tss[MAX_CPUS];
 
-gdt_entry_t GDT::gdt[GDT_ENTRIES];
+gdt_entry_t GDT::gdt[MAX_CPUS][GDT_ENTRIES];
 
-gdt_descriptor_t GDT::gdt_descriptor;
+gdt_descriptor_t GDT::gdt_descriptor[MAX_CPUS];
 
 extern "C" void load_gdt_asm_(struct gdt_descriptor* gdt);
 
 extern "C" void load_tss_asm_();
 
-void GDT::set_entry(uint num, uint base, uint limit, char access, char granularity)
+void GDT::set_entry(uint cpu, uint num, uint base, uint limit, char access, char granularity)
 {
+	gdt_entry_t* gdt = GDT::gdt[cpu];
+
 	gdt[num].base_low = (base & 0xFFFF); // NOLINT(*-narrowing-conversions)
 	gdt[num].base_middle = (base >> 16) & 0xFF; // NOLINT(*-narrowing-conversions)
 	gdt[num].base_high = (base >> 24) & 0xFF; // NOLINT(*-narrowing-conversions)
@@ -23,12 +25,13 @@ void GDT::set_entry(uint num, uint base, uint limit, char access, char granulari
 	gdt[num].access = access;
 }
 
-void GDT::setup_tss(uint gdt_entry, uint ss0, uint esp0)
+void GDT::setup_tss(uint cpu, uint gdt_entry, uint ss0, uint esp0)
 {
+	tss_entry_t& tss = GDT::tss[cpu];
 	uint base = (uint) &tss;
 	uint limit = base + sizeof(tss_entry_t);
 
-	set_entry(gdt_entry, base, limit, (char) TSS_SEGMENT_ACCESS, 0x00);
+	set_entry(cpu, gdt_entry, base, limit, (char) TSS_SEGMENT_ACCESS, 0x00);
 
 	for (uint i = 0; i < sizeof(tss_entry_t); ++i)
 		*(((unsigned char*) &tss) + i) = 0;
@@ -42,11 +45,12 @@ void GDT::setup_tss(uint gdt_entry, uint ss0, uint esp0)
 
 void GDT::set_tss_kernel_stack(uint esp0)
 {
-	tss.esp0 = esp0;
+	tss[SMP::get_cpu_id()].esp0 = esp0;
 }
 
 void GDT::set_tls(void* tls)
 {
+	gdt_entry_t* gdt = GDT::gdt[SMP::get_cpu_id()];
 	uint base = (uint)tls;
 	gdt[TLS_ENTRY].base_low = (base & 0xFFFF); // NOLINT(*-narrowing-conversions)
 	gdt[TLS_ENTRY].base_middle = (base >> 16) & 0xFF; // NOLINT(*-narrowing-conversions)
@@ -57,30 +61,32 @@ void GDT::set_tls(void* tls)
 
 void GDT::init()
 {
+	const uint cpu = SMP::get_cpu_id();
+
 	// Set up the GDT descriptor
-	gdt_descriptor.size = (sizeof(struct gdt_entry) * GDT_ENTRIES) - 1;
-	gdt_descriptor.address = (void*) gdt;
+	gdt_descriptor[cpu].size = (sizeof(struct gdt_entry) * GDT_ENTRIES) - 1;
+	gdt_descriptor[cpu].address = (void*) gdt[cpu];
 
 	// Set up the GDT entries - When adding an entry, don't forget to update GDT_ENTRIES
 	// Null segment
-	set_entry(0, 0, 0, 0, 0);
+	set_entry(cpu, 0, 0, 0, 0, 0);
 
 	// Kernel code segment
-	set_entry(1, 0, 0xFFFFFFFF, (char) K_CODE_SEGMENT_ACCESS, (char) GRANULARITY);
+	set_entry(cpu, 1, 0, 0xFFFFFFFF, (char) K_CODE_SEGMENT_ACCESS, (char) GRANULARITY);
 
 	// Kernel data segment
-	set_entry(2, 0, 0xFFFFFFFF, (char) K_DATA_SEGMENT_ACCESS, (char) GRANULARITY);
+	set_entry(cpu, 2, 0, 0xFFFFFFFF, (char) K_DATA_SEGMENT_ACCESS, (char) GRANULARITY);
 
 	// User code segment
-	set_entry(3, 0, 0xFFFFFFFF, (char) U_CODE_SEGMENT_ACCESS, (char) GRANULARITY);
+	set_entry(cpu, 3, 0, 0xFFFFFFFF, (char) U_CODE_SEGMENT_ACCESS, (char) GRANULARITY);
 
 	// User data segment
-	set_entry(4, 0, 0xFFFFFFFF, (char) U_DATA_SEGMENT_ACCESS, (char) GRANULARITY);
+	set_entry(cpu, 4, 0, 0xFFFFFFFF, (char) U_DATA_SEGMENT_ACCESS, (char) GRANULARITY);
 
 	// TSS
-	setup_tss(5, 0x10, 0x00);
+	setup_tss(cpu, 5, 0x10, 0x00);
 
-	set_entry(TLS_ENTRY, 0, 0xFFFFFFFF, (char) U_DATA_SEGMENT_ACCESS, (char) GRANULARITY);
+	set_entry(cpu, TLS_ENTRY, 0, 0xFFFFFFFF, (char) U_DATA_SEGMENT_ACCESS, (char) GRANULARITY);
 
 	// Load the GDT
 	load_asm();
@@ -89,7 +95,7 @@ void GDT::init()
 
 void GDT::load_asm()
 {
-	load_gdt_asm_(&gdt_descriptor);
+	load_gdt_asm_(&gdt_descriptor[SMP::get_cpu_id()]);
 }
 
 void GDT::load_tss_asm()
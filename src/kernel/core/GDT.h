@@ -3,6 +3,8 @@
 
 #include <kstddef.h>
 
+#include "SMP.h"
+
 #define PL0 0x00
 #define PL1 0x20
 #define PL2 0x40
@@ -85,16 +87,19 @@ typedef struct tss_entry tss_entry_t;
 class GDT
 {
 private:
-	static gdt_entry_t gdt[GDT_ENTRIES];
+	// Each processor has its own GDT, as it has its own TSS and TLS segment
+	static gdt_entry_t gdt[MAX_CPUS][GDT_ENTRIES];
+
+	static gdt_descriptor_t gdt_descriptor[MAX_CPUS];
 
-	static gdt_descriptor_t gdt_descriptor;
+	static tss_entry_t tss[MAX_CPUS];
 
-	static void setup_tss(uint gdt_entry, uint ss0, uint esp0);
+	static void setup_tss(uint cpu, uint gdt_entry, uint ss0, uint esp0);
 
 	/**
 	 * Write a GDT entry
 	 *
-	 * @param gdt GDT
+	 * @param cpu Processor whose GDT to write
 	 * @param num Entry number
 	 * @param base Base address
 	 * @param limit Segment limit
@@ -102,7 +107,7 @@ private:
 	 * @param granularity Granularity flags
 	 */
 	static void
-	set_entry(uint num, uint base, uint limit, char access, char granularity);
+	set_entry(uint cpu, uint num, uint base, uint limit, char access, char granularity);
 
 	/**
 	 * Load the GDT
@@ -121,7 +126,7 @@ private:
 public:
 
 	/**
-	 * Initialize the GDT and TSS
+	 * Initialize and load the GDT and TSS of the calling processor
 	 *
 	 * @param gdt_descriptor GDT descriptor
 	 * @param gdt GDT
@@ -129,14 +134,14 @@ public:
 	static void init();
 
 	/**
-	 * Define kernel stack location for handling interrupts / traps
+	 * Define kernel stack location for handling interrupts / traps on the calling processor
 	 *
 	 * @param esp0 Stack pointer
 	 */
 	static void set_tss_kernel_stack(uint esp0);
 
 	/**
-	 * Sets TLS base address
+	 * Sets TLS base address on the calling processor
 	 * @param tls TLS base address
 	 */
 	static void set_tls(void* tls);
@@ -803,4 +803,9 @@ void IDT::set_entry(int num, uint base, unsigned short select, unsigned short ty
 void IDT::load_idt_asm()
 {
 	load_idt_asm_(&idt_descriptor);
+}
+
+void IDT::load()
+{
+	load_idt_asm();
 }
\ No newline at end of file
@@ -59,6 +59,11 @@ public:
 	 * @param idt IDT table
 	 */
 	static void init();
+
+	/**
+	 * Loads the IDT on the calling processor. init already does it for the bootstrap processor
+	 */
+	static void load();
 };
 
 
@@ -0,0 +1,109 @@
+#include "IOAPIC.h"
+
+#include "ACPI.h"
+#include "fb.h"
+#include "interrupts.h"
+#include "LAPIC.h"
+#include "memory.h"
+#include "PIC.h"
+
+volatile uint32_t* IOAPIC::registers = nullptr;
+uint IOAPIC::gsi_base = 0;
+uint IOAPIC::num_entries = 0;
+uint8_t IOAPIC::destination = 0;
+
+uint32_t IOAPIC::read(uint reg)
+{
+    registers[IOAPIC_REGSEL / sizeof(uint32_t)] = reg;
+    return registers[IOAPIC_WINDOW / sizeof(uint32_t)];
+}
+
+void IOAPIC::write(uint reg, uint32_t value)
+{
+    registers[IOAPIC_REGSEL / sizeof(uint32_t)] = reg;
+    registers[IOAPIC_WINDOW / sizeof(uint32_t)] = value;
+}
+
+void IOAPIC::route(uint gsi, uint8_t vector, uint32_t flags)
+{
+    if (gsi < gsi_base || gsi - gsi_base >= num_entries)
+    {
+        printf_error("Global system interrupt %u is not handled by the I/O APIC", gsi);
+        return;
+    }
+
+    // Fixed delivery, physical destination. Write the destination first, as the low half unmasks the entry
+    const uint reg = IOAPIC_REDIRECTION_TABLE + (gsi - gsi_base) * 2;
+    write(reg + 1, (uint32_t)destination << 24);
+    write(reg, vector | flags);
+}
+
+uint32_t IOAPIC::get_irq_flags(uint8_t irq, bool pci)
+{
+    const uint16_t acpi_flags = ACPI::get_isa_irq_flags(irq);
+    uint32_t flags = pci ? IOAPIC_ACTIVE_LOW | IOAPIC_LEVEL_TRIGGERED : 0;
+
+    if ((acpi_flags & MADT_POLARITY_MASK) == MADT_POLARITY_ACTIVE_HIGH)
+        flags &= ~IOAPIC_ACTIVE_LOW;
+    else if ((acpi_flags & MADT_POLARITY_MASK) == MADT_POLARITY_ACTIVE_LOW)
+        flags |= IOAPIC_ACTIVE_LOW;
+
+    if ((acpi_flags & MADT_TRIGGER_MASK) == MADT_TRIGGER_EDGE)
+        flags &= ~IOAPIC_LEVEL_TRIGGERED;
+    else if ((acpi_flags & MADT_TRIGGER_MASK) == MADT_TRIGGER_LEVEL)
+        flags |= IOAPIC_LEVEL_TRIGGERED;
+
+    return flags;
+}
+
+void IOAPIC::init()
+{
+    const uint phys_addr = ACPI::get_io_apic_address();
+    if (!phys_addr || !LAPIC::is_enabled())
+    {
+        printf_info("No I/O APIC, legacy IRQs go through the PIC");
+        return;
+    }
+
+    // Registers are accessed at their physical address, in the higher half like the local APIC ones
+    if (!Memory::identity_map(phys_addr, PAGE_SIZE))
+    {
+        printf_error("Couldn't identity map I/O APIC registers");
+        return;
+    }
+
+    // Switch from the PIC atomically, so that no IRQ is acknowledged to the wrong controller
+    Interrupts::disable_asm();
+    registers = (volatile uint32_t*)phys_addr;
+    gsi_base = ACPI::get_io_apic_gsi_base();
+    num_entries = IOAPIC_MAX_REDIRECTION_ENTRY(read(IOAPIC_VERSION)) + 1;
+    destination = LAPIC::get_bsp_id();
+
+    for (uint i = 0; i < num_entries; i++)
+        write(IOAPIC_REDIRECTION_TABLE + i * 2, IOAPIC_MASKED);
+
+    PIC::disable();
+    LAPIC::disable_pic_interrupts();
+    // The PIT is left masked, local APIC timers are used as soon as there is a local APIC
+    route(ACPI::get_isa_irq_gsi(1), PIC1_START_INTERRUPT + 1, get_irq_flags(1, false)); // Keyboard
+    Interrupts::enable_asm();
+}
+
+void IOAPIC::route_pci_irq(uint8_t line, uint8_t vector)
+{
+    if (!is_enabled())
+        return;
+    if (line >= ISA_IRQS)
+    {
+        printf_error("PCI interrupt line %u is not an ISA IRQ", line);
+        return;
+    }
+
+    // Chipsets wire PCI interrupt links to the I/O APIC input of the ISA IRQ the BIOS assigned them
+    route(ACPI::get_isa_irq_gsi(line), vector, get_irq_flags(line, true));
+}
+
+bool IOAPIC::is_enabled()
+{
+    return registers != nullptr;
+}
@@ -0,0 +1,71 @@
+#ifndef CUSTOM_OS_IOAPIC_H
+#define CUSTOM_OS_IOAPIC_H
+
+#include <kstddef.h>
+#include <stdint.h>
+
+// Memory mapped registers, the other ones are reached through them
+#define IOAPIC_REGSEL 0x00
+#define IOAPIC_WINDOW 0x10
+
+// Indirect registers
+#define IOAPIC_VERSION 0x01
+#define IOAPIC_REDIRECTION_TABLE 0x10 // Two registers per entry, low half first
+
+#define IOAPIC_MAX_REDIRECTION_ENTRY(version) (((version) >> 16) & 0xFF)
+#define IOAPIC_ACTIVE_LOW 0x2000
+#define IOAPIC_LEVEL_TRIGGERED 0x8000
+#define IOAPIC_MASKED 0x10000
+
+//https://wiki.osdev.org/IOAPIC
+
+/**
+ * I/O APIC, which replaces the PIC when ACPI describes one. Legacy IRQs keep their vectors (PIC1_START_INTERRUPT + IRQ)
+ * and are delivered to the bootstrap processor, but are acknowledged through its local APIC, with a single memory
+ * write instead of port writes to the PIC.
+ */
+class IOAPIC
+{
+	static volatile uint32_t* registers; // nullptr until init
+	static uint gsi_base; // First global system interrupt handled
+	static uint num_entries; // Number of redirection entries, i.e. of inputs
+	static uint8_t destination; // Local APIC ID of the processor interrupts are delivered to
+
+	static uint32_t read(uint reg);
+
+	static void write(uint reg, uint32_t value);
+
+	/**
+	 * Unmasks an input and delivers it to the bootstrap processor
+	 * @param gsi global system interrupt
+	 * @param vector interrupt vector
+	 * @param flags IOAPIC_ACTIVE_LOW and/or IOAPIC_LEVEL_TRIGGERED
+	 */
+	static void route(uint gsi, uint8_t vector, uint32_t flags);
+
+	/**
+	 * Redirection entry flags of an ISA IRQ, as described by ACPI
+	 * @param irq ISA IRQ
+	 * @param pci whether the IRQ is used by a PCI device, whose interrupts default to level triggered, active low
+	 */
+	static uint32_t get_irq_flags(uint8_t irq, bool pci);
+
+public:
+	/**
+	 * Takes over legacy IRQs from the PIC if ACPI describes an I/O APIC. The local APIC has to be set up beforehand.
+	 * Otherwise, the PIC keeps delivering them
+	 */
+	static void init();
+
+	/**
+	 * Routes the legacy interrupt line of a PCI device. No-op if the PIC is used
+	 * @param line ISA IRQ of the line, as set by the BIOS in the PCI configuration space
+	 * @param vector interrupt vector
+	 */
+	static void route_pci_irq(uint8_t line, uint8_t vector);
+
+	/** Whether legacy IRQs go through the I/O APIC rather than the PIC */
+	[[nodiscard]] static bool is_enabled();
+};
+
+#endif //CUSTOM_OS_IOAPIC_H
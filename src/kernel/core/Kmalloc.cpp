@@ -0,0 +1,80 @@
+#include "Kmalloc.h"
+
+#include "KmemCache.h"
+
+namespace Memory
+{
+    const char* const Kmalloc::class_names[NUM_CLASSES] = {
+        "kmalloc-8", "kmalloc-16", "kmalloc-32", "kmalloc-48", "kmalloc-64", "kmalloc-80", "kmalloc-96",
+        "kmalloc-112", "kmalloc-128", "kmalloc-160", "kmalloc-192", "kmalloc-224", "kmalloc-256", "kmalloc-320",
+        "kmalloc-384", "kmalloc-448", "kmalloc-512", "kmalloc-640", "kmalloc-768", "kmalloc-896", "kmalloc-1024",
+        "kmalloc-1280", "kmalloc-1536", "kmalloc-1792", "kmalloc-2032"
+    };
+    KmemCache* Kmalloc::caches[NUM_CLASSES]{};
+    uint Kmalloc::num_allocations = 0;
+    uint Kmalloc::requested_bytes = 0;
+    uint Kmalloc::allocated_bytes = 0;
+
+    uint Kmalloc::class_index(uint size)
+    {
+        if (size <= 16)
+            return size > 8;
+        if (size <= 128)
+            return (size + 15) / 16;
+
+        // Four classes per power of 2: size lies in (2^k, 2^(k + 1)], classes are 2^(k - 2) bytes apart
+        const uint k = 31 - __builtin_clz(size - 1);
+        return 9 + (k - 7) * 4 + ((size - 1) >> (k - 2)) - 4;
+    }
+
+    void* Kmalloc::alloc(uint size)
+    {
+        const uint idx = class_index(size);
+        KmemCache*& cache = caches[idx];
+        if (!cache)
+            cache = KmemCache::create(class_names[idx], class_sizes[idx], 8);
+
+        void* ptr = cache->alloc();
+        if (!ptr)
+            return nullptr;
+
+        num_allocations++;
+        requested_bytes += size;
+        allocated_bytes += class_sizes[idx];
+
+        return ptr;
+    }
+
+    bool Kmalloc::free(void* ptr)
+    {
+        KmemCache* cache = KmemCache::of(ptr);
+        if (!cache)
+            return false;
+
+        cache->free(ptr);
+
+        return true;
+    }
+
+    uint Kmalloc::size_of(const void* ptr)
+    {
+        const KmemCache* cache = KmemCache::of(ptr);
+
+        return cache ? cache->get_object_size() : 0;
+    }
+
+    uint Kmalloc::get_num_allocations()
+    {
+        return num_allocations;
+    }
+
+    uint Kmalloc::get_requested_bytes()
+    {
+        return requested_bytes;
+    }
+
+    uint Kmalloc::get_allocated_bytes()
+    {
+        return allocated_bytes;
+    }
+}
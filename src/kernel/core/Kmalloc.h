@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include "MemoryDefines.h"
+
+namespace Memory
+{
+    class KmemCache;
+
+    /**
+     * General purpose allocator for small kernel blocks.
+     *
+     * Sizes are rounded up to a size class, each class being backed by an object cache. Classes are spaced like
+     * jemalloc's: 8, 16, then 16 bytes apart up to 128, then four classes per power of 2 (160, 192, 224, 256, 320...).
+     * Above 128 bytes, rounding then wastes less than 20% of a block.
+     * The biggest class is the biggest size of which two objects fit in a slab, bigger blocks being left to the memory
+     * tree.
+     */
+    class Kmalloc
+    {
+    public:
+        static constexpr uint NUM_CLASSES = 25;
+        static constexpr uint MAX_SIZE = 2032; // Biggest block handled, a bit less than 2 KiB because of slab headers
+
+    private:
+        static constexpr uint class_sizes[NUM_CLASSES] = {
+            8, 16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512, 640, 768, 896, 1024, 1280,
+            1536, 1792, MAX_SIZE
+        };
+        static const char* const class_names[NUM_CLASSES];
+        static KmemCache* caches[NUM_CLASSES]; // Created on first use
+
+        static uint num_allocations;
+        static uint requested_bytes; // Sum of the sizes asked for
+        static uint allocated_bytes; // Sum of the sizes actually handed out
+
+        /** Gets the index of the smallest class a block of a given size fits in, size being in [1, MAX_SIZE] */
+        static uint class_index(uint size);
+
+    public:
+        /**
+         * Allocates a block
+         * @param size size of the block, in [1, MAX_SIZE]
+         * @return block, nullptr if memory is full
+         */
+        static void* alloc(uint size);
+
+        /**
+         * Frees a block if it has been allocated by an object cache
+         * @param ptr block to free
+         * @return whether the block lay in a slab and has been freed
+         */
+        static bool free(void* ptr);
+
+        /**
+         * Gets the usable size of a block
+         * @return usable size, 0 if ptr was not allocated by an object cache
+         */
+        [[nodiscard]] static uint size_of(const void* ptr);
+
+        [[nodiscard]] static uint get_num_allocations();
+
+        [[nodiscard]] static uint get_requested_bytes();
+
+        [[nodiscard]] static uint get_allocated_bytes();
+    };
+}
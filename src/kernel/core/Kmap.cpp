@@ -0,0 +1,95 @@
+#include "Kmap.h"
+
+#include <sys/mman.h>
+
+#include "fb.h"
+#include "memory.h"
+#include "TLB.h"
+
+namespace Memory
+{
+    uint Kmap::first_page_id = 0;
+    uint Kmap::reserved_pte = 0;
+    uint Kmap::frames[KMAP_N_SLOTS]{};
+    uint Kmap::users[KMAP_N_SLOTS]{};
+    uint Kmap::next_slot = 0;
+    uint Kmap::hits = 0;
+    uint Kmap::flushes = 0;
+
+    void Kmap::init()
+    {
+        // Only reserve the virtual pages, frames are mapped in them by hand
+        int err;
+        void* slots = mmap((void*)KERNEL_VIRTUAL_BASE, KMAP_N_SLOTS * PAGE_SIZE, DEFAULT_K_PROT, DEFAULT_K_FLAGS, 0, 0,
+                           err, kernel_process, true, false);
+        if (!slots)
+            irrecoverable_error("%s: cannot reserve slots", __PRETTY_FUNCTION__);
+        first_page_id = ADDR_PAGE((uint)slots);
+        reserved_pte = PTE(page_tables, first_page_id);
+        for (uint& frame_id : frames)
+            frame_id = BuddyAllocator::NUM_FRAMES;
+    }
+
+    void Kmap::reclaim()
+    {
+        for (uint slot = 0; slot < KMAP_N_SLOTS; slot++)
+        {
+            if (users[slot])
+                continue;
+            PTE(page_tables, first_page_id + slot) = reserved_pte;
+            frames[slot] = BuddyAllocator::NUM_FRAMES;
+        }
+        TLB::invalidate_range(first_page_id, KMAP_N_SLOTS);
+        next_slot = 0;
+        flushes++;
+    }
+
+    void* Kmap::map(uint frame_id)
+    {
+        // Frame may still be mapped from a previous use
+        for (uint slot = 0; slot < KMAP_N_SLOTS; slot++)
+        {
+            if (frames[slot] != frame_id)
+                continue;
+            users[slot]++;
+            hits++;
+            return (void*)((first_page_id + slot) << 12);
+        }
+
+        // Use the next slot that has not been mapped since the last reclaim, its entry is not cached by the TLB
+        for (bool reclaimed = false;; reclaimed = true)
+        {
+            for (; next_slot < KMAP_N_SLOTS; next_slot++)
+            {
+                if (frames[next_slot] != BuddyAllocator::NUM_FRAMES)
+                    continue;
+                const uint page_id = first_page_id + next_slot;
+                PTE(page_tables, page_id) = FRAME_ID_ADDR(frame_id) | PAGE_GLOBAL | PAGE_WRITE | PAGE_PRESENT;
+                frames[next_slot] = frame_id;
+                users[next_slot++]++;
+                return (void*)(page_id << 12);
+            }
+            if (reclaimed)
+                irrecoverable_error("%s: every slot is in use", __PRETTY_FUNCTION__);
+            reclaim();
+        }
+    }
+
+    void Kmap::unmap(const void* addr)
+    {
+        const uint slot = ADDR_PAGE((uint)addr) - first_page_id;
+        if (slot >= KMAP_N_SLOTS || !users[slot])
+            irrecoverable_error("%s: 0x%x is not mapped", __PRETTY_FUNCTION__, (uint)addr);
+        users[slot]--; // Mapping is kept until the next reclaim
+    }
+
+    uint Kmap::get_hits()
+    {
+        return hits;
+    }
+
+    uint Kmap::get_flushes()
+    {
+        return flushes;
+    }
+}
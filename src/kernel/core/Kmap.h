@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+#include "MemoryDefines.h"
+
+#ifndef KMAP_N_SLOTS
+#define KMAP_N_SLOTS 64 // Number of kernel pages frames can temporarily be mapped in
+#endif
+
+namespace Memory
+{
+    /**
+     * Temporary mappings of frames that have no kernel page of their own, or that are easier to reach by frame id.
+     *
+     * Frames are mapped in slots, a range of kernel pages reserved at init. Slots are handed out in order, and a slot
+     * left by its last user keeps its mapping, so that mapping the same frame again costs nothing.
+     * Unused slots are only reclaimed once every slot has been handed out, all of them at once: their translations are
+     * then dropped by a single TLB invalidation, instead of one per mapping.
+     */
+    class Kmap
+    {
+        static uint first_page_id;
+        static uint reserved_pte; // Value of the entries of unused slots
+        static uint frames[KMAP_N_SLOTS]; // Frame mapped by each slot, BuddyAllocator::NUM_FRAMES if none
+        static uint users[KMAP_N_SLOTS]; // Number of map calls not unmapped yet, per slot
+        static uint next_slot; // Slots from there on have not been handed out since the last reclaim
+        static uint hits;
+        static uint flushes;
+
+        /** Unmaps the slots that are not in use, and invalidates the whole slot range at once */
+        static void reclaim();
+
+    public:
+        /** Reserves the slots. Shall be called once the kernel allocator is up */
+        static void init();
+
+        /**
+         * Maps a frame in kernel address space, until unmap is called
+         * @param frame_id frame to map
+         * @return address the frame is mapped at
+         */
+        static void* map(uint frame_id);
+
+        /** Releases a mapping obtained with map */
+        static void unmap(const void* addr);
+
+        [[nodiscard]] static uint get_hits();
+
+        [[nodiscard]] static uint get_flushes();
+    };
+}
@@ -0,0 +1,191 @@
+#include "KmemCache.h"
+
+#include <kstring.h>
+
+#include "fb.h"
+#include "RawMemory.h"
+#include "../utils/comparison.h"
+
+namespace Memory
+{
+    KmemCache KmemCache::caches[MAX_CACHES]{};
+    uint KmemCache::num_caches = 0;
+
+    KmemCache* KmemCache::create(const char* name, uint size, uint align, ctor_t ctor)
+    {
+        if (!align || align & (align - 1))
+            irrecoverable_error("%s: invalid alignment %u for cache %s", __PRETTY_FUNCTION__, align, name);
+
+        // Free objects store the address of the next free one. It goes after the object when it has a constructor, so
+        // that the constructed state is preserved
+        const uint link_offset = ctor ? (size + alignof(void*) - 1) & ~(alignof(void*) - 1) : 0;
+        const uint object_size = (max(size, link_offset + (uint)sizeof(void*)) + align - 1) & ~(align - 1);
+        const uint first_object_offset = (sizeof(slab) + align - 1) & ~(align - 1);
+        if (first_object_offset + object_size > PAGE_SIZE)
+            irrecoverable_error("%s: objects of cache %s are too big (%u bytes)", __PRETTY_FUNCTION__, name, size);
+
+        for (uint i = 0; i < num_caches; i++)
+        {
+            KmemCache& cache = caches[i];
+            if (cache.object_size == object_size && cache.ctor == ctor && !strcmp(cache.name, name))
+                return &cache;
+        }
+
+        if (num_caches == MAX_CACHES)
+            irrecoverable_error("%s: cannot create cache %s, too many caches", __PRETTY_FUNCTION__, name);
+
+        KmemCache& cache = caches[num_caches++];
+        cache.name = name;
+        cache.object_size = object_size;
+        cache.link_offset = link_offset;
+        cache.first_object_offset = first_object_offset;
+        cache.objects_per_slab = (PAGE_SIZE - first_object_offset) / object_size;
+        cache.ctor = ctor;
+
+        return &cache;
+    }
+
+    void*& KmemCache::next_free(void* obj) const
+    {
+        return *reinterpret_cast<void**>(reinterpret_cast<uintptr_t>(obj) + link_offset);
+    }
+
+    void KmemCache::push(slab*& list, slab* s)
+    {
+        s->prev = nullptr;
+        s->next = list;
+        if (list)
+            list->prev = s;
+        list = s;
+    }
+
+    void KmemCache::unlink(slab*& list, slab* s)
+    {
+        if (s->prev)
+            s->prev->next = s->next;
+        else
+            list = s->next;
+        if (s->next)
+            s->next->prev = s->prev;
+    }
+
+    KmemCache::slab* KmemCache::new_slab()
+    {
+        const uint pe = get_free_pe();
+        if (get_free_frame() == BuddyAllocator::NUM_FRAMES)
+            return nullptr;
+        allocate_page(pe, DEFAULT_K_POLICY | PAGE_SLAB);
+        num_pages++;
+
+        auto s = reinterpret_cast<slab*>(pe << 12);
+        s->cache = this;
+        const auto first = reinterpret_cast<uintptr_t>(s) + first_object_offset;
+        for (uint i = 0; i < objects_per_slab; i++)
+        {
+            const auto obj = reinterpret_cast<void*>(first + i * object_size);
+            if (ctor)
+                ctor(obj);
+            next_free(obj) = i + 1 < objects_per_slab ? reinterpret_cast<void*>(first + (i + 1) * object_size) : nullptr;
+        }
+        s->freep = reinterpret_cast<void*>(first);
+        s->num_free = objects_per_slab;
+
+        return s;
+    }
+
+    void* KmemCache::alloc()
+    {
+        slab* s = partial_slabs;
+        if (!s && (s = empty_slabs))
+        {
+            unlink(empty_slabs, s);
+            num_empty_slabs--;
+            push(partial_slabs, s);
+        }
+        if (!s)
+        {
+            if (!((s = new_slab())))
+                return nullptr;
+            push(partial_slabs, s);
+        }
+
+        void* obj = s->freep;
+        s->freep = next_free(obj);
+        if (!--s->num_free)
+        {
+            unlink(partial_slabs, s);
+            push(full_slabs, s);
+        }
+
+        high_water = max(high_water, ++active_objects);
+
+        return obj;
+    }
+
+    void KmemCache::free(void* obj)
+    {
+        if (!obj)
+            return;
+
+        auto s = reinterpret_cast<slab*>(reinterpret_cast<uintptr_t>(obj) & ~(PAGE_SIZE - 1));
+        next_free(obj) = s->freep;
+        s->freep = obj;
+        active_objects--;
+
+        if (s->num_free++ == 0) // Slab was full
+        {
+            unlink(full_slabs, s);
+            push(partial_slabs, s);
+        }
+        if (s->num_free < objects_per_slab)
+            return;
+
+        // Slab is empty
+        unlink(partial_slabs, s);
+        if (num_empty_slabs < MAX_EMPTY_SLABS)
+        {
+            push(empty_slabs, s);
+            num_empty_slabs++;
+            return;
+        }
+
+        free_page(ADDR_PAGE(reinterpret_cast<uintptr_t>(s)));
+        num_pages--;
+    }
+
+    KmemCache* KmemCache::of(const void* obj)
+    {
+        const auto address = reinterpret_cast<uintptr_t>(obj);
+        if (address < KERNEL_VIRTUAL_BASE || !(PTE(page_tables, ADDR_PAGE(address)) & PAGE_SLAB))
+            return nullptr;
+
+        return reinterpret_cast<slab*>(address & ~(PAGE_SIZE - 1))->cache;
+    }
+
+    uint KmemCache::get_object_size() const
+    {
+        return object_size;
+    }
+
+    KmemCache::info KmemCache::get_info() const
+    {
+        info info{};
+        strncpy(info.name, name, sizeof(info.name) - 1);
+        info.object_size = object_size;
+        info.active_objects = active_objects;
+        info.pages = num_pages;
+        info.high_water = high_water;
+
+        return info;
+    }
+
+    uint KmemCache::get_num_caches()
+    {
+        return num_caches;
+    }
+
+    const KmemCache* KmemCache::get_cache(uint i)
+    {
+        return i < num_caches ? &caches[i] : nullptr;
+    }
+}
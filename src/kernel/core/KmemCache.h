@@ -0,0 +1,128 @@
+#pragma once
+
+#include <stddef.h>
+#include "MemoryDefines.h"
+
+/**
+ * Makes a class allocated from its own object cache, by defining its operator new and delete.
+ * To be used in the class body.
+ */
+#define KMEM_CACHE_ALLOCATED(type, cache_name) \
+    static Memory::KmemCache* kmem_cache() \
+    { \
+        static Memory::KmemCache* cache = nullptr; \
+        if (!cache) \
+            cache = Memory::KmemCache::create(cache_name, sizeof(type), alignof(type)); \
+        return cache; \
+    } \
+    static void* operator new([[maybe_unused]] size_t size) { return kmem_cache()->alloc(); } \
+    static void* operator new([[maybe_unused]] size_t size, void* p) { return p; } \
+    static void operator delete(void* p) { kmem_cache()->free(p); }
+
+namespace Memory
+{
+    /**
+     * Cache of objects of a given size.
+     *
+     * Objects live in slabs of one page. A slab starts with a header, followed by the objects, and free objects of a
+     * slab are chained together. Slabs are kept in three lists: empty, partial and full, allocation preferring
+     * partial slabs so that memory stays packed. Allocation and deallocation are then O(1).
+     *
+     * Caches are never destroyed. Caches with the same name and object size are merged.
+     *
+     * Slab pages are flagged with PAGE_SLAB, so that the cache of any object can be found back from its address only.
+     */
+    class KmemCache
+    {
+    public:
+        typedef void (*ctor_t)(void* obj);
+
+        static constexpr uint MAX_CACHES = 64;
+
+        struct info
+        {
+            char name[24];
+            uint object_size;
+            uint active_objects; // Objects currently allocated
+            uint pages; // Pages currently used by the cache
+            uint high_water; // Highest number of objects simultaneously allocated
+        };
+
+    private:
+        struct slab
+        {
+            slab* prev;
+            slab* next;
+            KmemCache* cache;
+            void* freep; // First free object
+            uint num_free;
+        };
+
+        static constexpr uint MAX_EMPTY_SLABS = 1; // Empty slabs kept around to absorb alloc/free oscillations
+
+        static KmemCache caches[MAX_CACHES];
+        static uint num_caches;
+
+        const char* name = nullptr;
+        uint object_size = 0; // Size of an object slot, including alignment padding
+        uint link_offset = 0; // Offset of the pointer to the next free object in a free object slot
+        uint first_object_offset = 0;
+        uint objects_per_slab = 0;
+        ctor_t ctor = nullptr;
+
+        slab* empty_slabs = nullptr;
+        slab* partial_slabs = nullptr;
+        slab* full_slabs = nullptr;
+        uint num_empty_slabs = 0;
+
+        uint num_pages = 0;
+        uint active_objects = 0;
+        uint high_water = 0;
+
+        [[nodiscard]] void*& next_free(void* obj) const;
+
+        static void push(slab*& list, slab* s);
+        static void unlink(slab*& list, slab* s);
+
+        /** Allocates a page and makes it a slab of free objects. Objects are constructed if the cache has a ctor */
+        slab* new_slab();
+
+    public:
+        /**
+         * Creates an object cache, or gets the existing one with the same name and object size
+         * @param name name of the cache, kept as is
+         * @param size size of the objects
+         * @param align alignment of the objects, power of 2
+         * @param ctor function called once on every object when its slab is created. Freed objects are expected to be
+         * given back in their constructed state
+         * @return cache, never nullptr
+         */
+        static KmemCache* create(const char* name, uint size, uint align, ctor_t ctor = nullptr);
+
+        /**
+         * Allocates an object
+         * @return object, nullptr if memory is full
+         */
+        void* alloc();
+
+        /** Frees an object allocated from this cache */
+        void free(void* obj);
+
+        /**
+         * Gets the cache an object has been allocated from
+         * @param obj any kernel address
+         * @return cache, nullptr if obj does not lie in a slab
+         */
+        [[nodiscard]] static KmemCache* of(const void* obj);
+
+        /** Size of an object slot, ie usable size of any object of the cache */
+        [[nodiscard]] uint get_object_size() const;
+
+        [[nodiscard]] info get_info() const;
+
+        [[nodiscard]] static uint get_num_caches();
+
+        /** Gets the cache of index i, caches being indexed by creation order */
+        [[nodiscard]] static const KmemCache* get_cache(uint i);
+    };
+}
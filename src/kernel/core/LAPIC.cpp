@@ -0,0 +1,139 @@
+#include "LAPIC.h"
+
+#include "fb.h"
+#include "interrupts.h"
+#include "memory.h"
+#include "PIT.h"
+#include "system.h"
+#include "../utils/comparison.h"
+
+volatile uint32_t* LAPIC::registers = nullptr;
+uint8_t LAPIC::bsp_id = 0;
+uint LAPIC::timer_ticks_per_clock_tick = 0;
+
+uint32_t LAPIC::read(uint reg)
+{
+    return registers[reg / sizeof(uint32_t)];
+}
+
+void LAPIC::write(uint reg, uint32_t value)
+{
+    registers[reg / sizeof(uint32_t)] = value;
+}
+
+bool LAPIC::init(uint phys_addr)
+{
+    if (!phys_addr)
+    {
+        printf_info("No local APIC, only the PIC will be used");
+        return false;
+    }
+
+    // Registers are accessed at their physical address, in the higher half like the E1000 ones
+    if (!Memory::identity_map(phys_addr, PAGE_SIZE))
+    {
+        printf_error("Couldn't identity map local APIC registers");
+        return false;
+    }
+    // The scheduler programs the local APIC timer as soon as registers are set, which would disturb the calibration
+    Interrupts::disable_asm();
+    registers = (volatile uint32_t*)phys_addr;
+    bsp_id = get_id();
+
+    enable(true);
+    calibrate_timer();
+    Interrupts::enable_asm();
+
+    return true;
+}
+
+void LAPIC::enable(bool bootstrap_processor)
+{
+    write(LAPIC_TPR, 0); // Accept every interrupt
+
+    // The bootstrap processor keeps getting PIC interrupts (virtual wire mode) until the I/O APIC takes over, others only
+    // get IPIs and their timer
+    write(LAPIC_LVT_LINT0, bootstrap_processor ? LAPIC_LVT_EXTINT : LAPIC_LVT_MASKED);
+    write(LAPIC_LVT_LINT1, bootstrap_processor ? LAPIC_LVT_NMI : LAPIC_LVT_MASKED);
+    write(LAPIC_LVT_ERROR, LAPIC_LVT_MASKED);
+    write(LAPIC_LVT_TIMER, LAPIC_LVT_MASKED);
+
+    write(LAPIC_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_INTERRUPT);
+
+    // Clear errors (needs back to back writes) and pending interrupts
+    write(LAPIC_ESR, 0);
+    write(LAPIC_ESR, 0);
+    write(LAPIC_EOI, 0);
+}
+
+void LAPIC::disable_pic_interrupts()
+{
+    write(LAPIC_LVT_LINT0, LAPIC_LVT_MASKED);
+}
+
+void LAPIC::calibrate_timer()
+{
+    write(LAPIC_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_BY_16);
+    write(LAPIC_TIMER_INITIAL_COUNT, 0xFFFFFFFF);
+    PIT::busy_wait(CLOCK_TICK_MS * 1000);
+    timer_ticks_per_clock_tick = 0xFFFFFFFF - read(LAPIC_TIMER_CURRENT_COUNT);
+    write(LAPIC_TIMER_INITIAL_COUNT, 0); // Stop the timer
+}
+
+void LAPIC::start_oneshot(uint ms)
+{
+    // Longer delays than the counter allows make the timer fire early, the scheduler then programs it again
+    const uint64_t count = (uint64_t)timer_ticks_per_clock_tick * ms / CLOCK_TICK_MS;
+
+    write(LAPIC_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_BY_16);
+    write(LAPIC_LVT_TIMER, LAPIC_TIMER_ONESHOT | LAPIC_TIMER_INTERRUPT);
+    write(LAPIC_TIMER_INITIAL_COUNT, (uint32_t)min(count, (uint64_t)0xFFFFFFFF));
+}
+
+void LAPIC::stop_timer()
+{
+    write(LAPIC_TIMER_INITIAL_COUNT, 0);
+}
+
+uint8_t LAPIC::get_id()
+{
+    return read(LAPIC_ID) >> 24;
+}
+
+uint8_t LAPIC::get_bsp_id()
+{
+    return bsp_id;
+}
+
+void LAPIC::eoi()
+{
+    write(LAPIC_EOI, 0);
+}
+
+void LAPIC::send_ipi(uint8_t apic_id, uint32_t command)
+{
+    write(LAPIC_ICR_HIGH, (uint32_t)apic_id << 24);
+    write(LAPIC_ICR_LOW, command); // Writing the low half sends the IPI
+    while (read(LAPIC_ICR_LOW) & LAPIC_ICR_DELIVERY_PENDING)
+        __builtin_ia32_pause();
+}
+
+void LAPIC::send_init(uint8_t apic_id)
+{
+    send_ipi(apic_id, LAPIC_ICR_INIT | LAPIC_ICR_LEVEL_ASSERT);
+}
+
+void LAPIC::send_startup(uint8_t apic_id, uint8_t page)
+{
+    send_ipi(apic_id, LAPIC_ICR_STARTUP | LAPIC_ICR_LEVEL_ASSERT | page);
+}
+
+void LAPIC::send_interrupt(uint8_t apic_id, uint8_t vector)
+{
+    send_ipi(apic_id, LAPIC_ICR_LEVEL_ASSERT | vector);
+}
+
+bool LAPIC::is_enabled()
+{
+    return registers != nullptr;
+}
@@ -0,0 +1,120 @@
+#ifndef CUSTOM_OS_LAPIC_H
+#define CUSTOM_OS_LAPIC_H
+
+#include <kstddef.h>
+#include <stdint.h>
+
+// Registers, as offsets from the local APIC base address
+#define LAPIC_ID 0x20
+#define LAPIC_TPR 0x80 // Task priority
+#define LAPIC_EOI 0xB0
+#define LAPIC_SVR 0xF0 // Spurious interrupt vector
+#define LAPIC_ESR 0x280 // Error status
+#define LAPIC_ICR_LOW 0x300 // Interrupt command
+#define LAPIC_ICR_HIGH 0x310
+#define LAPIC_LVT_TIMER 0x320
+#define LAPIC_LVT_LINT0 0x350
+#define LAPIC_LVT_LINT1 0x360
+#define LAPIC_LVT_ERROR 0x370
+#define LAPIC_TIMER_INITIAL_COUNT 0x380
+#define LAPIC_TIMER_CURRENT_COUNT 0x390
+#define LAPIC_TIMER_DIVIDE 0x3E0
+
+#define LAPIC_SVR_ENABLE 0x100
+#define LAPIC_LVT_MASKED 0x10000
+#define LAPIC_LVT_NMI 0x400
+#define LAPIC_LVT_EXTINT 0x700
+#define LAPIC_TIMER_ONESHOT 0x0
+#define LAPIC_TIMER_DIVIDE_BY_16 0x3
+#define LAPIC_ICR_INIT 0x500
+#define LAPIC_ICR_STARTUP 0x600
+#define LAPIC_ICR_DELIVERY_PENDING 0x1000
+#define LAPIC_ICR_LEVEL_ASSERT 0x4000
+
+// Interrupt vectors, above the ones of the PIC
+#define LAPIC_TIMER_INTERRUPT 0x30
+#define LAPIC_RESCHEDULE_INTERRUPT 0x31 // Inter-processor interrupt asking an idle processor to look for work
+#define LAPIC_SPURIOUS_INTERRUPT 0xFF
+
+//https://wiki.osdev.org/APIC
+//https://wiki.osdev.org/APIC_Timer
+
+/**
+ * Local APIC of the processors. Each processor has its own, at the same address.
+ * The bootstrap processor receives legacy interrupts from the I/O APIC, or from the PIC through LINT0 if there is no
+ * I/O APIC, and MSI. Application processors only get inter-processor interrupts and their timer. The timer of each
+ * processor is its preemption timer, programmed in one-shot mode.
+ */
+class LAPIC
+{
+	static volatile uint32_t* registers; // nullptr until init
+	static uint8_t bsp_id; // Local APIC ID of the bootstrap processor
+	static uint timer_ticks_per_clock_tick; // Timer counts in CLOCK_TICK_MS, with LAPIC_TIMER_DIVIDE_BY_16
+
+	static uint32_t read(uint reg);
+
+	static void write(uint reg, uint32_t value);
+
+	/**
+	 * Sends an inter-processor interrupt and waits for the local APIC to have sent it
+	 * @param apic_id local APIC ID of the target processor
+	 * @param command low half of the command register
+	 */
+	static void send_ipi(uint8_t apic_id, uint32_t command);
+
+	/** Measures the timer frequency against the TSC. Interrupts have to be disabled */
+	static void calibrate_timer();
+
+public:
+	/**
+	 * Maps the local APIC registers, enables the local APIC of the calling (bootstrap) processor and calibrates its
+	 * timer. PIT has to be set up beforehand
+	 * @param phys_addr physical address of the registers, 0 if there is no local APIC
+	 * @return whether the local APIC can be used
+	 */
+	static bool init(uint phys_addr);
+
+	/**
+	 * Enables the local APIC of the calling processor
+	 * @param bootstrap_processor whether the calling processor is the one legacy interrupts are delivered to
+	 */
+	static void enable(bool bootstrap_processor);
+
+	/** Stops delivering PIC interrupts to the calling (bootstrap) processor, once the I/O APIC delivers them */
+	static void disable_pic_interrupts();
+
+	/**
+	 * Makes the timer of the calling processor fire LAPIC_TIMER_INTERRUPT once
+	 * @param ms delay in milliseconds
+	 */
+	static void start_oneshot(uint ms);
+
+	/** Stops the timer of the calling processor */
+	static void stop_timer();
+
+	/** Local APIC ID of the calling processor */
+	[[nodiscard]] static uint8_t get_id();
+
+	/** Local APIC ID of the bootstrap processor, which device interrupts are delivered to */
+	[[nodiscard]] static uint8_t get_bsp_id();
+
+	/** Acknowledges the interrupt being handled by the calling processor */
+	static void eoi();
+
+	/** Sends an INIT IPI, which puts a processor in wait-for-SIPI state */
+	static void send_init(uint8_t apic_id);
+
+	/**
+	 * Sends a startup IPI
+	 * @param apic_id target processor
+	 * @param page physical page the processor starts executing at, in real mode. Must be below 1 MiB
+	 */
+	static void send_startup(uint8_t apic_id, uint8_t page);
+
+	/** Sends a fixed interrupt to a processor */
+	static void send_interrupt(uint8_t apic_id, uint8_t vector);
+
+	[[nodiscard]] static bool is_enabled();
+};
+
+#endif //CUSTOM_OS_LAPIC_H
@@ -5,8 +5,16 @@
 #define PAGE_WRITE		0x2
 #define PAGE_USER		0x4
 #define PAGE_LAZY_ZERO	0x200 // Page is lazily zeroed, meaning it will be allocated and zeroed on first access
-#define PAGE_COW		0x100 // Page is Copy On Write, meaning it is shared between processes and will be copied on first write
+#define PAGE_COW		0x800 // Page is Copy On Write, meaning it is shared between processes and will be copied on first write
 #define PAGE_SHRO		0x400 // Page is shared read-only, meaning it is shared between processes but not writable
+#define PAGE_SLAB		0x400 // Higher half page is a slab of an object cache. Same bit as PAGE_SHRO, kernel pages are never shared
+#define PAGE_LARGE		0x80 // Page directory entry maps a 4 MiB page (CR4.PSE)
+#define PAGE_FILE		0x80 // Lazy page is read from a file on first access. Only set with PAGE_LAZY_ZERO (PAT bit if present)
+#define PAGE_SHARED		0x40 // Lazy page maps a shared memory object. Only set with PAGE_LAZY_ZERO (dirty bit if present)
+#ifndef GLOBAL_PAGES
+#define GLOBAL_PAGES	1 // Whether higher half pages are global (CR4.PGE), ie survive address space switches in the TLB
+#endif
+#define PAGE_GLOBAL		(GLOBAL_PAGES ? 0x100 : 0) // Page is the same in every address space
 
 #define PDT_ENTRIES 1024
 #define PT_ENTRIES 1024
@@ -16,11 +24,18 @@
 #define FREE_THRESHOLD (10 * PAGE_SIZE) // Maximum bytes freed before attempting to free pages
 
 #define STACK_SIZE 4096
+#ifndef FAULT_AROUND_N_PAGES
+#define FAULT_AROUND_N_PAGES 16 // Lazily zeroed pages allocated together upon a write fault. Power of 2, 1 to disable
+#endif
+#ifndef FILE_READAHEAD_N_PAGES
+#define FILE_READAHEAD_N_PAGES 16 // File-backed pages read together upon a fault. Power of 2, 1 to disable
+#endif
 #define KERNEL_VIRTUAL_BASE 0xC0000000
 
 #define ADDR_PDE(addr) ((addr) >> 22)
 #define ADDR_PTE(addr) (((addr) >> 12) & 0x3FF)
 #define ADDR_PAGE(addr) ((addr) >> 12)
+#define PAGE_GLOBAL_IF_KERNEL(page_id) ((page_id) >= ADDR_PAGE(KERNEL_VIRTUAL_BASE) ? PAGE_GLOBAL : 0)
 #define INVALIDATE_PAGE(pde, pte) __asm__ volatile("invlpg (%0)" : : "r" (VIRT_ADDR(pde, pte, 0)));
 #define FRAME_ID_ADDR(i) ((i) << 12)
 #define VIRT_ADDR(pde, pte, offset) ((pde) << 22 | (pte) << 12 | (offset))
@@ -31,15 +46,16 @@
 #define FRAME_FREE(i) !(FRAME_USED(i))
 #define MARK_FRAME_USED(frame_id, page_id) {Memory::frame_to_page[(frame_id)] = (page_id); \
 	if (Memory::frame_rc[(frame_id)]) { irrecoverable_error("Trying to allocate frame which is already allocated"); } \
-	Memory::frame_rc[(frame_id)]++;}
+	Memory::frame_rc[(frame_id)]++; \
+	Memory::BuddyAllocator::mark_used(frame_id);}
 #define MARK_FRAME_FREE(i) {Memory::frame_to_page[(i)] = (uint)-1; if (Memory::frame_rc[(i)] > 1){irrecoverable_error \
 	("Kernel is trying to free a frame which is referenced by a process");} \
 else \
 {\
 Memory::frame_rc[(i)] = 0;}\
-Memory::lowest_free_frame = min(Memory::lowest_free_frame, (i)); \
+Memory::BuddyAllocator::mark_free(i); \
 }
-#define PHYS_ADDR(page_tables, virt_addr) ((page_tables[(virt_addr) >> 22].entries[((virt_addr) >> 12) & 0x3FF] & ~0x3FF) | ((virt_addr) & 0xFFF))
+#define PHYS_ADDR(page_tables, virt_addr) ((page_tables[(virt_addr) >> 22].entries[((virt_addr) >> 12) & 0x3FF] & ~0xFFF) | ((virt_addr) & 0xFFF))
 
 #define DEFAULT_K_PROT (PROT_READ | PROT_WRITE)
 #define DEFAULT_K_FLAGS (MAP_ANONYMOUS | MAP_PRIVATE)
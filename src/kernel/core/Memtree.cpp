@@ -15,28 +15,48 @@ namespace Memory
 {
     MemTree MemTree::bootstrap_memtree{};
 
-    BST<allocation>::Node* MemTree::find_free_block(Node* current, uint size, const hint_info& hint_info)
+    MemTree::Node* MemTree::find_free_block(Node* current, uint size, const hint_info& hint_info)
     {
-        if (!current)
-            return nullptr;
+        if (hint_info.is_mandatory)
+        {
+            // Only the block starting exactly at hint is suitable
+            while (current && current->data.start != hint_info.hint)
+                current = current->data.start > hint_info.hint ? current->left : current->right;
+
+            return current && !current->data.used && node_size(current) >= size ? current : nullptr;
+        }
 
-        if (!current->data.used && node_size(current) >= size &&
-            (hint_info.hint == current->data.start || (current->data.start > hint_info.hint && !hint_info.is_mandatory)))
-            return current;
+        // No free block big enough in this subtree
+        if (!current || current->max_free < size)
+            return nullptr;
 
-        if (current->data.start > hint_info.hint)
+        // Lowest free block big enough above hint
+        if (current->data.start >= hint_info.hint)
         {
             if (Node* free_block = find_free_block(current->left, size, hint_info); free_block)
                 return free_block;
+            if (!current->data.used && node_size(current) >= size)
+                return current;
         }
-        if (Node* free_block = find_free_block(current->right, size, hint_info); free_block)
-            return free_block;
-        return nullptr;
+
+        return find_free_block(current->right, size, hint_info);
     }
 
     void MemTree::shrink_block(Node* node, uint size)
     {
         node->data.end -= size;
+        refresh(node);
+    }
+
+    void MemTree::split_block(Node* node, uint size, const page_info& page_info)
+    {
+        const uintptr_t ns = node_size(node);
+
+        if (const uint shrink = ns - size)
+        {
+            shrink_block(node, shrink);
+            add_node(new_node({node->data.end, node->data.end + shrink, page_info, false}));
+        }
     }
 
     uintptr_t MemTree::node_size(const Node* node)
@@ -46,58 +66,39 @@ namespace Memory
 
     bool MemTree::merge_node_with_free_successor(Node* node)
     {
-        if (!node->right)
-            return false;
-
-        Node* prev = node;
-        Node* cur = node->right;
+        Node* next = successor(node);
 
-        // Find successor
-        while (cur->left)
-        {
-            prev = cur;
-            cur = cur->left;
-        }
-
-        if (!cur->data.is_similar_and_contiguous(node->data))
+        if (!next || next->data.used || next->data.start != node->data.end || !(next->data.page_info == node->data.page_info))
             return false; // Quit if non-contiguous or non-free
 
         // Merge
-        node->data.end += node_size(cur);
+        node->data.end = next->data.end;
 
         // Remove merged node
-        remove_node(cur, cur == node->right ? &node->right : &prev->left);
+        remove_node(next);
+        refresh(node);
 
         return true;
     }
 
     bool MemTree::merge_node_with_free_predecessor(Node* node)
     {
-        if (!node->left)
-            return false;
-
-        Node* prev = node;
-        Node* cur = node->left;
-
-        // Find predecessor
-        while (cur->right)
-        {
-            prev = cur;
-            cur = cur->right;
-        }
+        Node* prev = predecessor(node);
 
-        if (!cur->data.is_similar_and_contiguous(node->data))
+        if (!prev || prev->data.used || prev->data.end != node->data.start || !(prev->data.page_info == node->data.page_info))
             return false; // Quit if non-contiguous or non-free
 
         // Merge
-        node->data.start = cur->data.start;
+        node->data.start = prev->data.start;
 
-        remove_node(cur, prev == node ? &node->left : &prev->right);
+        // Remove merged node
+        remove_node(prev);
+        refresh(node);
 
         return true;
     }
 
-    BST<allocation>::Node* MemTree::node_physical_alloc(uint size, const page_info& page_info, const hint_info& hint_info, Process* process)
+    MemTree::Node* MemTree::node_physical_alloc(uint size, const page_info& page_info, const hint_info& hint_info, Process* process)
     {
         constexpr uint MIN_ALLOC_PAGES = 2;
         const uint num_pages_base = ADDR_PAGE(size + PAGE_SIZE - 1);
@@ -114,10 +115,32 @@ namespace Memory
         return node;
     }
 
-    BST<allocation>::Node* MemTree::find_allocation_node(uintptr_t address, Node**& node_ptr) const
+    MemTree::Node* MemTree::find_allocation_node(uintptr_t address) const
     {
-        const allocation dummy{address, 0, DEFAULT_K_PAGE_INFO};
-        return find_node(dummy, compare_func, node_ptr);
+        Node* cur = root;
+
+        while (cur && cur->data.start != address)
+            cur = cur->data.start > address ? cur->left : cur->right;
+
+        return cur;
+    }
+
+    MemTree::Node* MemTree::find_first_node_ending_after(uintptr_t start) const
+    {
+        // Blocks do not overlap, so ends are sorted like starts
+        Node* res = nullptr;
+        for (Node* cur = root; cur;)
+        {
+            if (cur->data.end <= start)
+                cur = cur->right;
+            else
+            {
+                res = cur;
+                cur = cur->left;
+            }
+        }
+
+        return res;
     }
 
     void MemTree::merge_free_node(Node* node)
@@ -126,9 +149,10 @@ namespace Memory
         while (merge_node_with_free_successor(node)) {};
     }
 
-    void MemTree::free_node(Node* node, Node** node_ptr, const Process* process)
+    void MemTree::free_node(Node* node, const Process* process)
     {
         node->data.used = false;
+        refresh(node);
         merge_free_node(node);
 
         const uint ns = node_size(node);
@@ -138,11 +162,8 @@ namespace Memory
 
         if (num_pages >= N_FREE_PAGES_THRESHOLD)
         {
-            if (*node_ptr != node)
-                irrecoverable_error("%s: *node_ptr != node", __PRETTY_FUNCTION__);
-
             if (num_pages * PAGE_SIZE == ns)
-                remove_node(node, node_ptr);
+                remove_node(node);
             else
             {
                 if (const uint part2_size = node->data.end - aligned_end)
@@ -158,17 +179,17 @@ namespace Memory
                     shrink_block(node, shrink);
                 }
                 else
-                    remove_node(node, node_ptr);
+                    remove_node(node);
             }
 
             for (uint i = 0; i < num_pages; i++)
-                free_page(ADDR_PAGE(aligned_start + i), process);
+                free_page(aligned_start + (i << 12), process);
         }
     }
 
-    BST<allocation>::Node* MemTree::new_node(const allocation& allocation)
+    MemTree::Node* MemTree::new_node(const allocation& allocation)
     {
-        return new (SlabAllocator<Node>::get_instance()->alloc()) Node{allocation, nullptr, nullptr};
+        return new (SlabAllocator<Node>::get_instance()->alloc()) Node{allocation};
     }
 
     void MemTree::delete_node(Node* node)
@@ -176,88 +197,226 @@ namespace Memory
         SlabAllocator<Node>::get_instance()->free(node);
     }
 
-    void MemTree::remove_node(Node* node, Node** node_ptr)
+    void MemTree::destroy_subtree(Node* node)
     {
-        Node* replacement = nullptr;
+        if (!node)
+            return;
+
+        destroy_subtree(node->left);
+        Node* right = node->right;
+        delete_node(node);
+        destroy_subtree(right);
+    }
+
+    int MemTree::height(const Node* node)
+    {
+        return node ? node->height : 0;
+    }
 
+    uintptr_t MemTree::max_free(const Node* node)
+    {
+        return node ? node->max_free : 0;
+    }
+
+    void MemTree::update(Node* node)
+    {
+        node->height = 1 + max(height(node->left), height(node->right));
+        node->max_free = max(node->data.used ? 0 : node_size(node), max(max_free(node->left), max_free(node->right)));
+    }
+
+    void MemTree::refresh(Node* node)
+    {
+        for (; node; node = node->parent)
+            update(node);
+    }
+
+    MemTree::Node* MemTree::predecessor(Node* node)
+    {
         if (node->left)
         {
-            if (node->right) // Two children
-            {
-                // Find successor
-                Node* prev = node;
-                Node* successor = node->right;
-                while (successor->left)
-                {
-                    prev = successor;
-                    successor = successor->left;
-                }
-                // Replace current node data with successor data
-                node->data = successor->data;
-                // Delete successor
-                (prev == node ? node->right : prev->left) = successor->right;
-                delete_node(successor);
+            node = node->left;
+            while (node->right)
+                node = node->right;
+            return node;
+        }
 
-                return; // Return, as we don't want to delete cur
-            }
-            // Only left child
-            replacement = node->left;
+        while (node->parent && node->parent->left == node)
+            node = node->parent;
+
+        return node->parent;
+    }
+
+    MemTree::Node* MemTree::successor(Node* node)
+    {
+        if (node->right)
+        {
+            node = node->right;
+            while (node->left)
+                node = node->left;
+            return node;
         }
-        else if (node->right) // Only right child
-            replacement = node->right;
-        else
-            replacement = nullptr; // Leaf
 
-        *node_ptr = replacement;
+        while (node->parent && node->parent->right == node)
+            node = node->parent;
 
-        delete_node(node);
+        return node->parent;
     }
 
-    void MemTree::ensure_validity_aux(Node* node, Node* root)
+    void MemTree::replace_child(const Node* node, Node* replacement)
     {
-        if (!node)
-            return;
-        ensure_validity_aux_aux(node, root);
-        ensure_validity_aux(node->left, root);
-        ensure_validity_aux(node->right, root);
+        if (!node->parent)
+            root = replacement;
+        else if (node->parent->left == node)
+            node->parent->left = replacement;
+        else
+            node->parent->right = replacement;
+
+        if (replacement)
+            replacement->parent = node->parent;
     }
 
-    bool do_overlap(const allocation& alloc1, const allocation& alloc2)
+    MemTree::Node* MemTree::rotate_left(Node* node)
     {
-        return  ((alloc1.start >= alloc2.start && alloc1.start < alloc2.end) || (alloc1.end > alloc2.start && alloc1.end <= alloc2.end)) &&
-            !(alloc1.start == alloc2.start && alloc1.end == alloc2.end);
+        Node* pivot = node->right;
+
+        node->right = pivot->left;
+        if (pivot->left)
+            pivot->left->parent = node;
+        replace_child(node, pivot);
+        pivot->left = node;
+        node->parent = pivot;
+
+        update(node);
+        update(pivot);
+
+        return pivot;
     }
 
-    void MemTree::ensure_validity_aux_aux(Node* node, const Node* root)
+    MemTree::Node* MemTree::rotate_right(Node* node)
     {
-        if (!root)
-            return;
+        Node* pivot = node->left;
 
-        if (do_overlap(node->data, root->data))
-            irrecoverable_error("memtree overlap detected");
-        ensure_validity_aux_aux(node, root->left);
-        ensure_validity_aux_aux(node, root->right);
+        node->left = pivot->right;
+        if (pivot->right)
+            pivot->right->parent = node;
+        replace_child(node, pivot);
+        pivot->right = node;
+        node->parent = pivot;
+
+        update(node);
+        update(pivot);
+
+        return pivot;
     }
 
-    BST<allocation>::Node* MemTree::get_lowest_alloc(Node* node, Node* prev, Node**& node_ptr)
+    void MemTree::rebalance(Node* node)
     {
-        if (node->left)
-            return get_lowest_alloc(node->left, node, node_ptr);
+        while (node)
+        {
+            update(node);
 
-        node_ptr = prev ? &prev->left : &root;
-        return node;
+            const int balance = height(node->left) - height(node->right);
+            if (balance > 1) // Left heavy
+            {
+                if (height(node->left->left) < height(node->left->right))
+                    rotate_left(node->left);
+                node = rotate_right(node);
+            }
+            else if (balance < -1) // Right heavy
+            {
+                if (height(node->right->right) < height(node->right->left))
+                    rotate_right(node->right);
+                node = rotate_left(node);
+            }
+
+            node = node->parent;
+        }
     }
 
-    MemTree::MemTree() : BST([](const Memory::allocation& a, const Memory::allocation& b)
+    void MemTree::add_node(Node* node)
     {
-        return a.start == b.start
-                   ? 0
-                   : a.start > b.start ? 1 : -1;
-    })
+        Node* parent = nullptr;
+        Node** cur = &root;
+
+        while (*cur)
+        {
+            parent = *cur;
+            cur = parent->data.start >= node->data.start ? &parent->left : &parent->right;
+        }
+
+        node->parent = parent;
+        *cur = node;
+
+        rebalance(node);
+    }
+
+    void MemTree::remove_node(Node* node)
     {
+        Node* rebalance_start;
 
+        if (node->left && node->right) // Two children
+        {
+            // Find successor. It has no left child
+            Node* successor = node->right;
+            while (successor->left)
+                successor = successor->left;
+
+            // Move successor in place of node. Nodes are relinked rather than having their data swapped, so that
+            // callers can keep using pointers to other nodes
+            if (successor == node->right)
+                rebalance_start = successor;
+            else
+            {
+                rebalance_start = successor->parent;
+                replace_child(successor, successor->right);
+                successor->right = node->right;
+                node->right->parent = successor;
+            }
+            successor->left = node->left;
+            node->left->parent = successor;
+            replace_child(node, successor);
+        }
+        else // At most one child
+        {
+            rebalance_start = node->parent;
+            replace_child(node, node->left ? node->left : node->right);
+        }
+
+        delete_node(node);
+        rebalance(rebalance_start);
     }
 
+    void MemTree::ensure_validity_aux(const Node* node, uintptr_t& prev_end)
+    {
+        if (!node)
+            return;
+
+        if ((node->left && node->left->parent != node) || (node->right && node->right->parent != node))
+            irrecoverable_error("memtree broken parent link");
+
+        ensure_validity_aux(node->left, prev_end);
+
+        if (node->data.start < prev_end)
+            irrecoverable_error("memtree overlap detected");
+        prev_end = node->data.end;
+
+        ensure_validity_aux(node->right, prev_end);
+
+        const int balance = height(node->left) - height(node->right);
+        if (balance > 1 || balance < -1 || node->height != 1 + max(height(node->left), height(node->right)))
+            irrecoverable_error("memtree unbalanced");
+        if (node->max_free != max(node->data.used ? 0 : node_size(node), max(max_free(node->left), max_free(node->right))))
+            irrecoverable_error("memtree invalid max_free");
+    }
+
+    bool do_overlap(const allocation& alloc1, const allocation& alloc2)
+    {
+        return  ((alloc1.start >= alloc2.start && alloc1.start < alloc2.end) || (alloc1.end > alloc2.start && alloc1.end <= alloc2.end)) &&
+            !(alloc1.start == alloc2.start && alloc1.end == alloc2.end);
+    }
+
+    MemTree::MemTree() = default;
+
     void* MemTree::allocate(uint size, const page_info& page_info, Process* process, const hint_info& hint_info)
     {
         const int policy = page_info.policy;
@@ -270,15 +429,10 @@ namespace Memory
             if ((node = node_physical_alloc(size, page_info, hint_info, process)) == nullptr)
                 return nullptr;
 
-        const uintptr_t ns = node_size(node);
-
-        if (const uint shrink = ns - size)
-        {
-            shrink_block(node, shrink);
-            add_node(new_node({node->data.end,node->data.end + shrink, page_info, false}));
-        }
+        split_block(node, size, page_info);
 
         node->data.used = true;
+        refresh(node);
 
 #if ENSURE_VALIDITY
         ensure_validity();
@@ -289,8 +443,16 @@ namespace Memory
 
     allocation* MemTree::find_allocation(uintptr_t address) const
     {
-        [[maybe_unused]] Node** node_ptr;
-        if (Node* node = find_allocation_node(address, node_ptr))
+        if (Node* node = find_allocation_node(address))
+            return &node->data;
+
+        return nullptr;
+    }
+
+    allocation* MemTree::find_allocation_containing(uintptr_t address) const
+    {
+        Node* node = find_first_node_ending_after(address);
+        if (node && node->data.start <= address && node->data.used)
             return &node->data;
 
         return nullptr;
@@ -315,8 +477,7 @@ namespace Memory
         }
 
         // Get header
-        Node** node_ptr;
-        Node* node = find_allocation_node(address, node_ptr);
+        Node* node = find_allocation_node(address);
         if (!node)
             return ReallocState::FAILED;
 
@@ -324,18 +485,7 @@ namespace Memory
 
         if (size <= base_node_size)
         {
-            const uint shrink = base_node_size - size;
-            shrink_block(node, shrink);
-            add_node(new_node({node->data.end, node->data.end + shrink, node->data.page_info, false}));
-            new_address = address;
-#if ENSURE_VALIDITY
-            ensure_validity();
-#endif
-            return ReallocState::OK;
-        }
-
-        if (base_node_size == size)
-        {
+            split_block(node, size, node->data.page_info);
             new_address = address;
 #if ENSURE_VALIDITY
             ensure_validity();
@@ -348,9 +498,7 @@ namespace Memory
 
         if (size <= new_node_size)
         {
-            const uint shrink = new_node_size - size;
-            shrink_block(node, shrink);
-            add_node(new_node({node->data.end, node->data.end + shrink, node->data.page_info, false}));
+            split_block(node, size, node->data.page_info);
             new_address = address;
 #if ENSURE_VALIDITY
             ensure_validity();
@@ -363,7 +511,7 @@ namespace Memory
             return ReallocState::NOMEM;
 
         memcpy(new_buffer, reinterpret_cast<void*>(address), base_node_size);
-        free_node(node, node_ptr, process);
+        free_node(node, process);
         new_address = reinterpret_cast<uintptr_t>(new_buffer);
 
 #if ENSURE_VALIDITY
@@ -379,67 +527,44 @@ namespace Memory
         if (!address)
             return FreeState::OK;
 
-        const allocation dummy = {address, 0,DEFAULT_K_PAGE_INFO};
-
-        int prev_cmp = 0;
-        Node* prev = nullptr;
-        Node* cur = root;
+        Node* node = find_allocation_node(address);
+        if (!node)
+            return FreeState::NOT_FOUND;
+        if (!node->data.used)
+            return FreeState::DOUBLE_FREE;
 
-        while (cur)
-        {
-            const int cmp = compare_func(cur->data, dummy);
-            if (cmp == 0)
-            {
-                if (!cur->data.used)
-                    return FreeState::DOUBLE_FREE;
-                Node** node_ptr = prev ? (prev_cmp > 0 ? &prev->left : &prev->right) : &root;
-                free_node(cur, node_ptr, process);
+        free_node(node, process);
 
 #if ENSURE_VALIDITY
-                ensure_validity();
+        ensure_validity();
 #endif
 
-                return FreeState::OK;
-            }
-            prev_cmp = cmp;
-            prev = cur;
-            cur = cmp > 0 ? cur->left : cur->right;
-        }
-
-        return FreeState::NOT_FOUND;
+        return FreeState::OK;
     }
 
     void MemTree::ensure_validity() const
     {
-        BST::ensure_validity();
-        ensure_validity_aux(root, root);
+        if (root && root->parent)
+            irrecoverable_error("memtree root has a parent");
+
+        uintptr_t prev_end = 0;
+        ensure_validity_aux(root, prev_end);
     }
 
     void MemTree::free_all(const Process* process)
     {
-        while (root)
+        Node* node = root;
+        while (node && node->left)
+            node = node->left;
+
+        // Free every region of contiguous allocations
+        while (node)
         {
-            Node** node_ptr;
-            Node* lowest_alloc = get_lowest_alloc(root, nullptr, node_ptr);
-            const uintptr_t region_start = lowest_alloc->data.start;
-            uintptr_t region_end = lowest_alloc->data.end;
-            remove_node(lowest_alloc, node_ptr);
-
-            const bool there_were_only_one_node = !root;
-            Node* next_lowest_alloc = there_were_only_one_node ? nullptr : get_lowest_alloc(root, nullptr, node_ptr);
-            bool contiguous = !there_were_only_one_node && next_lowest_alloc->data.start == lowest_alloc->data.end;
-            while (contiguous)
-            {
-                region_end = next_lowest_alloc->data.end;
-                remove_node(next_lowest_alloc, node_ptr);
-                if (root)
-                {
-                    next_lowest_alloc = get_lowest_alloc(root, nullptr, node_ptr);
-                    contiguous = next_lowest_alloc->data.start == region_end;
-                }
-                else
-                    contiguous = false;
-            }
+            const uintptr_t region_start = node->data.start;
+            uintptr_t region_end = node->data.end;
+
+            for (node = successor(node); node && node->data.start == region_end; node = successor(node))
+                region_end = node->data.end;
 
             const uintptr_t region_size = region_end - region_start;
             if (region_size & (PAGE_SIZE - 1))
@@ -449,12 +574,48 @@ namespace Memory
             for (uint i = 0; i < num_pages; i++)
                 free_page(region_start + (i << 12), process);
         }
+
+        destroy_subtree(root);
+        root = nullptr;
+    }
+
+    void MemTree::unmap(uintptr_t start, uintptr_t end)
+    {
+        Node* node;
+        while ((node = find_first_node_ending_after(start)) && node->data.start < end)
+        {
+            // Keep the parts of the block lying out of the range
+            if (node->data.end > end)
+            {
+                allocation tail = node->data;
+                tail.start = end;
+                node->data.end = end;
+                refresh(node);
+                add_node(new_node(tail));
+            }
+            if (node->data.start < start)
+            {
+                node->data.end = start;
+                refresh(node);
+                continue;
+            }
+
+            remove_node(node);
+        }
+
+#if ENSURE_VALIDITY
+        ensure_validity();
+#endif
     }
 
     void MemTree::register_external_allocation(const allocation& allocation)
     {
         Node* node = new_node(allocation);
-        ensure_validity_aux_aux(node, root);
         add_node(node);
+
+        const Node* prev = predecessor(node);
+        const Node* next = successor(node);
+        if ((prev && do_overlap(node->data, prev->data)) || (next && do_overlap(node->data, next->data)))
+            irrecoverable_error("memtree overlap detected");
     }
 }
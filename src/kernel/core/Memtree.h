@@ -2,7 +2,6 @@
 
 #include <stdint.h>
 #include "kstring.h"
-#include "../utils/BST.h"
 #include "SlabAllocator.h"
 
 typedef unsigned int uint;
@@ -11,25 +10,62 @@ class Process;
 
 namespace Memory
 {
-    class MemTree : protected BST<allocation>
+    /**
+     * Tree of the allocations of a process, ordered by start address.
+     *
+     * The tree is an AVL tree, and each node also stores the size of the biggest free block lying in its subtree, so
+     * that finding a free block big enough (optionally above a hint) only requires a root to leaf walk.
+     */
+    class MemTree
     {
     protected:
+        struct Node
+        {
+            allocation data;
+            Node* left = nullptr;
+            Node* right = nullptr;
+            Node* parent = nullptr;
+            uintptr_t max_free = 0; // Size of the biggest free block in this subtree
+            int height = 1;
+        };
+
+        Node* root = nullptr;
+
         static constexpr uint N_FREE_PAGES_THRESHOLD = 2;
         static Node* find_free_block(Node* current, uint size, const hint_info& hint_info);
-        static void shrink_block(Node* node, uint size);
+        void shrink_block(Node* node, uint size);
+        void split_block(Node* node, uint size, const page_info& page_info);
         static uintptr_t node_size(const Node* node);
-        static bool merge_node_with_free_successor(Node* node);
-        static bool merge_node_with_free_predecessor(Node* node);
+        bool merge_node_with_free_successor(Node* node);
+        bool merge_node_with_free_predecessor(Node* node);
         Node* node_physical_alloc(uint size, const Memory::page_info& page_info, const Memory::hint_info& hint_info, Process* process);
-        Node* find_allocation_node(uintptr_t address, Node**& node_ptr) const;
-        static void merge_free_node(Node* node);
-        void free_node(Node* node, Node** node_ptr, const Process* process);
+        Node* find_allocation_node(uintptr_t address) const;
+        /** Lowest node ending after start, nullptr if there is none */
+        Node* find_first_node_ending_after(uintptr_t start) const;
+        void merge_free_node(Node* node);
+        void free_node(Node* node, const Process* process);
         static Node* new_node(const allocation& allocation);
         static void delete_node(Node* node);
-        static void remove_node(Node* node, Node** node_ptr);
-        static void ensure_validity_aux(Node* node, Node* root);
-        static void ensure_validity_aux_aux(Node* node, const Node* root);
-        Node* get_lowest_alloc(Node* node, Node* prev, Node**& node_ptr);
+        static void destroy_subtree(Node* node);
+
+        static int height(const Node* node);
+        static uintptr_t max_free(const Node* node);
+        /** Recomputes height and max_free of a node from its children */
+        static void update(Node* node);
+        /** Updates max_free of a node and its ancestors after a node data change */
+        static void refresh(Node* node);
+        static Node* predecessor(Node* node);
+        static Node* successor(Node* node);
+        /** Replaces the link from node's parent to node with a link to replacement */
+        void replace_child(const Node* node, Node* replacement);
+        Node* rotate_left(Node* node);
+        Node* rotate_right(Node* node);
+        /** Updates and rebalances every node from node to the root */
+        void rebalance(Node* node);
+        void add_node(Node* node);
+        void remove_node(Node* node);
+
+        static void ensure_validity_aux(const Node* node, uintptr_t& prev_end);
     public:
         static bool go;
         enum class FreeState
@@ -48,11 +84,21 @@ namespace Memory
         MemTree();
         void* allocate(uint size, const page_info& page_info, Process* process, const hint_info& hint_info = DEFAULT_HINT_INFO);
         allocation* find_allocation(uintptr_t address) const;
+        /** Used block containing an address, nullptr if the address is not allocated */
+        allocation* find_allocation_containing(uintptr_t address) const;
         ReallocState realloc(uintptr_t address, uint size, Process* process, uintptr_t& new_address);
         [[nodiscard]] FreeState free(uintptr_t address, const Process* process);
         static MemTree bootstrap_memtree;
         void ensure_validity() const;
         void free_all(const Process* process);
         void register_external_allocation(const allocation& allocation);
+
+        /**
+         * Removes a range from the tree, used and free blocks alike. Blocks partially covered are split, only their part
+         * lying out of the range is kept. Pages are left untouched.
+         * @param start first address of the range
+         * @param end end of the range, excluded
+         */
+        void unmap(uintptr_t start, uintptr_t end);
     };
 }
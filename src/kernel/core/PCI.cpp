@@ -2,6 +2,9 @@
 
 #include <stdint.h>
 #include "fb.h"
+#include "IOAPIC.h"
+#include "LAPIC.h"
+#include "PIC.h"
 
 PCI::Device PCI::ethernet_card = Device(-1,-1, -1);
 
@@ -24,6 +27,27 @@ uint16_t PCI::pciConfigReadWord(uint8_t bus, uint8_t slot, uint8_t func, uint8_t
     return (uint16_t)((inl(0xCFC) >> ((offset & 2) * 8)) & 0xFFFF);
 }
 
+uint32_t PCI::pciConfigReadDword(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset)
+{
+    outl(0xCF8, (uint32_t)((bus << 16) | (slot << 11) | (func << 8) | (offset & 0xFC) | 0x80000000));
+    return inl(0xCFC);
+}
+
+void PCI::pciConfigWriteDword(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset, uint32_t value)
+{
+    outl(0xCF8, (uint32_t)((bus << 16) | (slot << 11) | (func << 8) | (offset & 0xFC) | 0x80000000));
+    outl(0xCFC, value);
+}
+
+void PCI::pciConfigWriteWord(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset, uint16_t value)
+{
+    // Only whole dwords can be written, keep the other half as is
+    const uint shift = (offset & 2) * 8;
+    uint32_t dword = pciConfigReadDword(bus, slot, func, offset);
+    dword = (dword & ~(0xFFFF << shift)) | ((uint32_t)value << shift);
+    pciConfigWriteDword(bus, slot, func, offset, dword);
+}
+
 uint16_t PCI::pciCheckVendor(uint8_t bus, uint8_t slot)
 {
     uint16_t vendor = pciConfigReadWord(bus, slot, 0, 0);
@@ -164,4 +188,64 @@ uint8_t PCI::getIntLine(uint8_t bus, uint8_t device, uint8_t function)
 
     // The interrupt line is in the lower 8 bits of the word
     return (uint8_t)(value & 0xFF);
+}
+
+uint8_t PCI::findCapability(uint8_t bus, uint8_t device, uint8_t function, uint8_t id)
+{
+    if (!(pciConfigReadWord(bus, device, function, PCI_STATUS) & PCI_STATUS_CAPABILITIES_LIST))
+        return 0;
+
+    // Bound the walk, in case the list loops
+    uint8_t cap = pciConfigReadWord(bus, device, function, PCI_CAPABILITIES_POINTER) & 0xFC;
+    for (int i = 0; cap && i < 48; i++)
+    {
+        const uint16_t header = pciConfigReadWord(bus, device, function, cap); // ID, then next capability offset
+        if ((header & 0xFF) == id)
+            return cap;
+        cap = (header >> 8) & 0xFC;
+    }
+
+    return 0;
+}
+
+bool PCI::enableMSI(uint8_t bus, uint8_t device, uint8_t function, uint8_t vector)
+{
+    // Messages are written to a local APIC
+    if (!LAPIC::is_enabled())
+        return false;
+    const uint8_t cap = findCapability(bus, device, function, PCI_CAP_MSI);
+    if (!cap)
+        return false;
+
+    // Device interrupts are all handled by the bootstrap processor, whichever processor runs this
+    uint16_t control = pciConfigReadWord(bus, device, function, cap + 2);
+    pciConfigWriteDword(bus, device, function, cap + 4, PCI_MSI_ADDRESS | ((uint32_t)LAPIC::get_bsp_id() << 12));
+    uint8_t data_offset = cap + 8;
+    if (control & PCI_MSI_64BIT)
+    {
+        pciConfigWriteDword(bus, device, function, cap + 8, 0); // Upper address half
+        data_offset = cap + 12;
+    }
+    pciConfigWriteWord(bus, device, function, data_offset, vector); // Fixed delivery, edge triggered
+
+    // Single message
+    control = (control & ~PCI_MSI_MULTIPLE_MESSAGE_ENABLE) | PCI_MSI_ENABLE;
+    pciConfigWriteWord(bus, device, function, cap + 2, control);
+
+    const uint16_t command = pciConfigReadWord(bus, device, function, PCI_COMMAND);
+    pciConfigWriteWord(bus, device, function, PCI_COMMAND, command | PCI_COMMAND_INTERRUPT_DISABLE);
+
+    return true;
+}
+
+uint8_t PCI::setupInterrupt(const Device& device, uint8_t msi_vector)
+{
+    if (enableMSI(device.bus, device.device, device.function, msi_vector))
+        return msi_vector;
+
+    const uint8_t line = getIntLine(device.bus, device.device, device.function);
+    const uint8_t vector = PIC1_START_INTERRUPT + line;
+    IOAPIC::route_pci_irq(line, vector);
+
+    return vector;
 }
\ No newline at end of file
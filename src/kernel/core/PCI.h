@@ -6,11 +6,46 @@
 #define PCI_BAR_MEM 0x0
 #define PCI_BAR_IO  0x1
 
+#define PCI_COMMAND 0x04
+#define PCI_STATUS 0x06
+#define PCI_CAPABILITIES_POINTER 0x34
+#define PCI_COMMAND_INTERRUPT_DISABLE 0x400 // Stop asserting the legacy interrupt line
+#define PCI_STATUS_CAPABILITIES_LIST 0x10
+
+#define PCI_CAP_MSI 0x05
+#define PCI_MSI_ENABLE 0x1
+#define PCI_MSI_MULTIPLE_MESSAGE_ENABLE 0x70
+#define PCI_MSI_64BIT 0x80
+#define PCI_MSI_ADDRESS 0xFEE00000 // Local APIC the message is sent to goes in bits 12-19
+
+// Interrupt vectors of devices using MSI, one per device. Above the local APIC ones
+#define MSI_START_INTERRUPT 0x40
+#define MSI_END_INTERRUPT 0x4F
+
 
 class PCI
 {
     static uint16_t pciConfigReadWord(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset);
 
+    static uint32_t pciConfigReadDword(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset);
+
+    static void pciConfigWriteDword(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset, uint32_t value);
+
+    static void pciConfigWriteWord(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset, uint16_t value);
+
+    /**
+     * Looks for a capability in the capabilities list of a function
+     * @return capability offset in the configuration space, 0 if the function does not have it
+     */
+    static uint8_t findCapability(uint8_t bus, uint8_t device, uint8_t function, uint8_t id);
+
+    /**
+     * Makes a function signal its interrupts with MSI rather than with its legacy interrupt line
+     * @param vector interrupt vector the messages trigger on the bootstrap processor
+     * @return whether MSI is enabled. False if the function or the platform do not support it
+     */
+    static bool enableMSI(uint8_t bus, uint8_t device, uint8_t function, uint8_t vector);
+
     static uint16_t pciCheckVendor(uint8_t bus, uint8_t slot);
 
     static uint16_t getVendorID(uint8_t bus, uint8_t device, uint8_t function);
@@ -47,6 +82,14 @@ public:
     static uint32_t getPCIBarSize(uint8_t bus, uint8_t device, uint8_t function, uint8_t barIndex);
 
     static uint8_t getIntLine(uint8_t bus, uint8_t device, uint8_t function);
+
+    /**
+     * Sets up the interrupts of a function. It gets a dedicated vector with MSI if possible, otherwise its legacy
+     * interrupt line is used, which may be shared with other devices
+     * @param msi_vector vector to use with MSI, between MSI_START_INTERRUPT and MSI_END_INTERRUPT
+     * @return interrupt vector the function triggers
+     */
+    static uint8_t setupInterrupt(const Device& device, uint8_t msi_vector);
 };
 
 #endif // PCI_H
@@ -66,4 +66,16 @@ void PIC::disable_preemptive_scheduling()
 {
 	uint a = inb(PIC1_DATA) | 1;
 	outb(PIC1_DATA, a);
+}
+
+bool PIC::is_in_service(uint irq)
+{
+	outb(PIC1_COMMAND, PIC_READ_ISR);
+	return inb(PIC1_COMMAND) & (1 << irq);
+}
+
+void PIC::disable()
+{
+	outb(PIC1_DATA, 0xFF);
+	outb(PIC2_DATA, 0xFF);
 }
\ No newline at end of file
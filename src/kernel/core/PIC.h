@@ -20,6 +20,7 @@
 #define PIC2_END_INTERRUPT (PIC2_START_INTERRUPT + 7)
 
 #define PIC_ACK     0x20
+#define PIC_READ_ISR 0x0B // OCW3, next command port read returns the in-service register
 
 class PIC
 {
@@ -47,6 +48,17 @@ public:
 	static void enable_preemptive_scheduling();
 
 	static void disable_preemptive_scheduling();
+
+	/**
+	 * Checks whether an IRQ of PIC 1 is being handled, which tells it apart from a software interrupt of the same vector
+	 * @param irq PIC 1 IRQ
+	 */
+	[[nodiscard]] static bool is_in_service(uint irq);
+
+	/**
+	 * Masks every IRQ, once another interrupt controller took over
+	 */
+	static void disable();
 };
 
 
@@ -4,10 +4,16 @@
 #include "system.h"
 
 uint32_t PIT::tsc_ticks_per_us = 0;
+uint64_t PIT::init_tsc = 0;
 
-uint PIT::get_tick()
+uint PIT::get_ms()
 {
-    return ticks;
+    return (uint)((System::rdtsc() - init_tsc) / ((uint64_t)tsc_ticks_per_us * 1000));
+}
+
+uint32_t PIT::get_tsc_ticks_per_us()
+{
+    return tsc_ticks_per_us;
 }
 
 uint16_t pit_read_counter()
@@ -29,6 +35,15 @@ void pit_set_reload_value(uint16_t value)
     outb(PIT_CHANNEL0_PORT, (value >> 8) & 0xFF); // Send high byte of divider
 }
 
+void pit_set_oneshot_count(uint16_t value)
+{
+    // Command byte: channel 0, access lobyte/hibyte, mode 0 (interrupt on terminal count), binary mode
+    outb(PIT_COMMAND_PORT, 0b00110000);
+
+    outb(PIT_CHANNEL0_PORT, value & 0xFF);
+    outb(PIT_CHANNEL0_PORT, (value >> 8) & 0xFF);
+}
+
 uint32_t PIT::calibrate_tsc()
 {
     pit_set_reload_value(0xFFFF); // Set PIT to max count
@@ -59,9 +74,12 @@ uint32_t PIT::calibrate_tsc()
 void PIT::init()
 {
     tsc_ticks_per_us = calibrate_tsc();
-    uint divider = ms_to_pit_divider(CLOCK_TICK_MS);
+    init_tsc = System::rdtsc();
+}
 
-    pit_set_reload_value(divider);
+void PIT::start_oneshot(uint ms)
+{
+    pit_set_oneshot_count((uint16_t)ms_to_pit_divider(min(ms, (uint)PIT_MAX_ONESHOT_MS)));
 }
 
 void sleep_cycles(uint64_t cycles)
@@ -73,14 +91,14 @@ void sleep_cycles(uint64_t cycles)
 __attribute__((no_instrument_function))
 void PIT::sleep(uint ms)
 {
-    uint num_ticks_to_wait = (uint)((float)TICKS_PER_SEC * (float)ms / 1000.f);
-    if (num_ticks_to_wait == 0)
-        sleep_cycles(tsc_ticks_per_us * ms * 1000);
-    else
-    {
-        Scheduler::set_process_asleep(Scheduler::get_running_process(), ms);
-        TRIGGER_TIMER_INTERRUPT
-    }
+    // One-shot timers wake the process up on time, even for less than a clock tick
+    Scheduler::set_process_asleep(Scheduler::get_running_process(), ms);
+    TRIGGER_TIMER_INTERRUPT
+}
+
+void PIT::busy_wait(uint us)
+{
+    sleep_cycles((uint64_t)tsc_ticks_per_us * us);
 }
 
 uint PIT::ms_to_pit_divider(uint ms)
@@ -92,5 +110,3 @@ uint PIT::ms_to_pit_divider(uint ms)
     // div = 1193182ms / 1000
     return (uint)(1193182.0 * ms / 1000);
 }
-
-uint PIT::ticks = 0;
@@ -9,11 +9,13 @@
 #define PIT_CHANNEL0_PORT 0x40
 
 #define CLOCK_TICK_MS 10
-#define TICKS_PER_SEC (1000 / CLOCK_TICK_MS)
+#define PIT_FREQUENCY 1193182
+#define PIT_MAX_ONESHOT_MS (0xFFFF * 1000 / PIT_FREQUENCY) // Longest delay a 16 bits count allows
 
 class PIT
 {
 	static uint32_t tsc_ticks_per_us;
+	static uint64_t init_tsc; // TSC value at initialization, time is measured from there
 
 	/**
 	 * Computes the divider to send to PIT to make it send interrupts every ms milliseconds
@@ -29,17 +31,37 @@ class PIT
 	static uint32_t calibrate_tsc();
 
 public:
-	static uint ticks; // PIT tick since it's been initialized
+	/**
+	 * Time elapsed since initialization, measured with the TSC so that it does not depend on timer interrupts
+	 * @return elapsed time in milliseconds
+	 */
+	static uint get_ms();
 
-	static uint get_tick();
+	static uint32_t get_tsc_ticks_per_us();
 
 	/**
-	 * Set up the PIT
+	 * Calibrates the TSC with the PIT and starts measuring time
 	 */
 	static void init();
 
+	/**
+	 * Makes the PIT fire a single interrupt
+	 * @param ms delay in milliseconds, clamped to PIT_MAX_ONESHOT_MS
+	 */
+	static void start_oneshot(uint ms);
+
+	/**
+	 * Puts the running process asleep. Callers that cannot give the CPU away shall use busy_wait instead
+	 * @param ms duration in milliseconds
+	 */
 	__attribute__((no_instrument_function))
 	static void sleep(uint ms);
+
+	/**
+	 * Spins for some time, without giving the CPU away nor relying on interrupts
+	 * @param us duration in microseconds
+	 */
+	static void busy_wait(uint us);
 };
 
 
@@ -0,0 +1,187 @@
+#include "PageCache.h"
+
+#include "BuddyAllocator.h"
+#include "memory.h"
+#include "VirtualPageAllocator.h"
+#include "../file_management/FileInterface.h"
+#include "../processes/process.h"
+
+namespace Memory
+{
+    list<PageCache::cached_file*> PageCache::files{};
+    PageCache::cached_file* PageCache::mapped_file = nullptr;
+    uint PageCache::num_pages = 0;
+    uint PageCache::hits = 0;
+    uint PageCache::misses = 0;
+
+    PageCache::cached_file* PageCache::get_cached_file(const SharedPointer<Dentry>& file)
+    {
+        for (cached_file* cf : files)
+            if (cf->file->inode == file->inode)
+                return cf;
+
+        const uint n = file->inode->size / PAGE_SIZE;
+        auto pages = (uint*)calloc(n ? n : 1, sizeof(uint));
+        if (!pages)
+            return nullptr;
+        auto cf = new cached_file{file, n, pages};
+        files.add(cf);
+
+        return cf;
+    }
+
+    void PageCache::release_page(uint page_id)
+    {
+        // Mapped frames are left to their processes, the last one to unmap it frees the kernel page (cf. free_page)
+        const uint frame_id = PHYS_ADDR(page_tables, page_id << 12) >> 12;
+        if (frame_rc[frame_id] > 1)
+            frame_rc[frame_id]--;
+        else
+            free_page(page_id);
+        num_pages--;
+    }
+
+    bool PageCache::map(const Process* process, uint page_id, const SharedPointer<Dentry>& file, uint file_page, uint n)
+    {
+        cached_file* cf = get_cached_file(file);
+        if (!cf || file_page + n > cf->num_pages)
+            return false;
+
+        mapped_file = cf;
+        const bool mapped = map_pages(cf, process, page_id, file, file_page, n);
+        mapped_file = nullptr;
+
+        return mapped;
+    }
+
+    bool PageCache::map_pages(cached_file* cf, const Process* process, uint page_id, const SharedPointer<Dentry>& file,
+                              uint file_page, uint n)
+    {
+        uint i = 0;
+        while (i < n)
+        {
+            // Pages are looked up right before being mapped: allocating frames may shrink the cache
+            uint run = 0;
+            for (; i + run < n && !cf->pages[file_page + i + run]; run++) {}
+
+            if (run)
+            {
+                // Read the whole run of missing pages at once, in contiguous kernel pages
+                const uint first = VirtualPageAllocator::find(run);
+                if (first == (uint)-1)
+                    return false;
+                for (uint j = 0; j < run; j++)
+                {
+                    const uint frame_id = get_free_frame();
+                    if (frame_id == BuddyAllocator::NUM_FRAMES)
+                    {
+                        for (uint k = 0; k < j; k++)
+                            free_page(first + k);
+                        return false;
+                    }
+                    allocate_page(frame_id, first + j, DEFAULT_K_POLICY);
+                }
+
+                if (File::read_at(file, (void*)(first << 12), (file_page + i) * PAGE_SIZE, run * PAGE_SIZE) !=
+                    (int)(run * PAGE_SIZE))
+                {
+                    for (uint j = 0; j < run; j++)
+                        free_page(first + j);
+                    return false;
+                }
+
+                for (uint j = 0; j < run; j++)
+                    cf->pages[file_page + i + j] = first + j;
+                num_pages += run;
+                misses += run;
+            }
+            else
+                hits++;
+
+            // Map the pages, which are then referenced by the process and cannot be shrunk away anymore.
+            // Writing a PTE may allocate its page table, which may shrink the cache: pin the pages until they are mapped
+            const uint start = i, end = i + (run ? run : 1);
+            for (uint j = start; j < end; j++)
+                frame_rc[PHYS_ADDR(page_tables, cf->pages[file_page + j] << 12) >> 12]++;
+            // Entries were not present, thus not cached by the TLB
+            for (; i < end; i++)
+            {
+                const uint frame_id = PHYS_ADDR(page_tables, cf->pages[file_page + i] << 12) >> 12;
+                const uint share_policy = PTE(process->page_tables, page_id + i) & PAGE_WRITE ? PAGE_COW : PAGE_SHRO;
+                process->update_pte(page_id + i, FRAME_ID_ADDR(frame_id) | PAGE_USER | share_policy | PAGE_PRESENT,
+                                    false);
+            }
+            for (uint j = start; j < end; j++)
+                frame_rc[PHYS_ADDR(page_tables, cf->pages[file_page + j] << 12) >> 12]--;
+        }
+
+        return true;
+    }
+
+    void PageCache::invalidate(const SharedPointer<Dentry>& file)
+    {
+        for (cached_file* cf : files)
+        {
+            if (cf->file->inode != file->inode)
+                continue;
+
+            for (uint i = 0; i < cf->num_pages; i++)
+                if (cf->pages[i])
+                    release_page(cf->pages[i]);
+            files.remove(cf);
+            free(cf->pages);
+            delete cf;
+            return;
+        }
+    }
+
+    uint PageCache::shrink()
+    {
+        uint freed = 0;
+        for (auto it = files.begin(); it != files.end();)
+        {
+            cached_file* cf = *it;
+            bool empty = true;
+            for (uint i = 0; i < cf->num_pages; i++)
+            {
+                const uint page_id = cf->pages[i];
+                if (!page_id)
+                    continue;
+                if (frame_rc[PHYS_ADDR(page_tables, page_id << 12) >> 12] > 1)
+                {
+                    empty = false;
+                    continue;
+                }
+                release_page(page_id);
+                cf->pages[i] = 0;
+                freed++;
+            }
+
+            // Entries without any page left are dropped as well, they would otherwise pile up
+            ++it;
+            if (empty && cf != mapped_file)
+            {
+                files.remove(cf);
+                free(cf->pages);
+                delete cf;
+            }
+        }
+
+        return freed;
+    }
+
+    uint PageCache::get_num_pages()
+    {
+        return num_pages;
+    }
+
+    uint PageCache::get_hits()
+    {
+        return hits;
+    }
+
+    uint PageCache::get_misses()
+    {
+        return misses;
+    }
+}
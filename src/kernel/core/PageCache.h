@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+#include "MemoryDefines.h"
+#include "../file_management/dentry.h"
+#include "../utils/list.h"
+#include "../utils/shared_pointer.h"
+
+class Process;
+
+namespace Memory
+{
+    /**
+     * Cache of file pages, shared by every process mapping them.
+     *
+     * Each cached page lives in a kernel page holding a reference to its frame. Processes map the frame read-only,
+     * PAGE_SHRO for pages they cannot write, PAGE_COW for the others, so that a write gives them a private copy.
+     * Pages no process maps anymore are kept until memory runs out (cf. shrink).
+     * Files are identified by their inode, and dropped from the cache as soon as they are written to.
+     */
+    class PageCache
+    {
+        struct cached_file
+        {
+            SharedPointer<Dentry> file;
+            uint num_pages; // Pages entirely covered by the file
+            uint* pages; // Kernel page holding each page of the file, 0 if not cached
+        };
+
+        static list<cached_file*> files;
+        static cached_file* mapped_file; // Entry map is working on, which shrink must not free as it allocates frames
+        static uint num_pages; // Pages currently cached
+        static uint hits; // Pages mapped from the cache without reading them
+        static uint misses; // Pages read from their file
+
+        /** Gets the cache entry of a file, creating it if need be. Returns nullptr if memory is full */
+        static cached_file* get_cached_file(const SharedPointer<Dentry>& file);
+
+        /** Maps pages of a cache entry in a process, cf. map */
+        static bool map_pages(cached_file* cf, const Process* process, uint page_id, const SharedPointer<Dentry>& file,
+                              uint file_page, uint n);
+
+        /** Drops the cache reference to a page, freeing it if no process maps it */
+        static void release_page(uint page_id);
+
+    public:
+        /**
+         * Maps consecutive whole pages of a file in a process. Missing pages are read, one read per run of them.
+         * @param process process to map pages in
+         * @param page_id first page to map, pages must be lazily allocated in the process
+         * @param file file to map
+         * @param file_page index of the first page in the file
+         * @param n number of pages, all of them entirely covered by the file
+         * @return whether pages have been mapped
+         */
+        static bool map(const Process* process, uint page_id, const SharedPointer<Dentry>& file, uint file_page, uint n);
+
+        /** Drops the cached pages of a file, to be called when the file changes. Mapped pages stay as they are */
+        static void invalidate(const SharedPointer<Dentry>& file);
+
+        /**
+         * Frees the cached pages no process maps. Meant to be called when memory is full.
+         * @return number of frames freed
+         */
+        static uint shrink();
+
+        [[nodiscard]] static uint get_num_pages();
+
+        [[nodiscard]] static uint get_hits();
+
+        [[nodiscard]] static uint get_misses();
+    };
+}
@@ -1,7 +1,12 @@
 #include "RawMemory.h"
+#include "PageCache.h"
+#include "TLB.h"
+#include "VirtualPageAllocator.h"
+#include "ZeroedFramePool.h"
 
 #include "fb.h"
 #include "abi-bits/vm-flags.h"
+#include "../processes/scheduler.h"
 #include "../utils/comparison.h"
 
 [[noreturn]]
@@ -19,8 +24,6 @@ namespace Memory
     // Gives page id given frame id. -1 means that frame is not allocated
     uint* frame_to_page; // uint[PT_ENTRIES * PDT_ENTRIES];
     uint lowest_free_pe_user;
-    uint* lowest_free_pe = nullptr;
-    uint lowest_free_frame = 0;
 
     [[maybe_unused]] uint loaded_grub_modules = 0;
     GRUB_module* grub_modules;
@@ -35,18 +38,24 @@ namespace Memory
 
     uint get_free_frame()
     {
-        while (lowest_free_frame < PDT_ENTRIES * PT_ENTRIES && FRAME_USED(lowest_free_frame))
-            lowest_free_frame++;
+        const uint frame_id = BuddyAllocator::get_free_frame();
+        if (frame_id != BuddyAllocator::NUM_FRAMES)
+            return frame_id;
 
-        return lowest_free_frame;
+        // Memory is full, take back the frames set aside for later
+        const uint pool_frame_id = ZeroedFramePool::release_frame();
+        if (pool_frame_id != BuddyAllocator::NUM_FRAMES)
+            return pool_frame_id;
+
+        // Then the file pages no process maps anymore
+        return PageCache::shrink() ? BuddyAllocator::get_free_frame() : BuddyAllocator::NUM_FRAMES;
     }
 
     uint get_free_pe()
     {
-        while (*lowest_free_pe < PDT_ENTRIES * PT_ENTRIES && PTE_USED(page_tables, *lowest_free_pe))
-            (*lowest_free_pe)++;
+        const uint page_id = VirtualPageAllocator::find(1);
 
-        return *lowest_free_pe;
+        return page_id == (uint)-1 ? PDT_ENTRIES * PT_ENTRIES : page_id;
     }
 
     void free_page(uint page_id)
@@ -58,17 +67,89 @@ namespace Memory
         bool lazy = *pte_ptr & PAGE_LAZY_ZERO;
         if (!lazy && frame_id == 0)
             irrecoverable_error("wut");
+        split_large_page(page_id >> 10);
         *pte_ptr = 0;
+        VirtualPageAllocator::set_used(page_id, false);
+        TLB::invalidate_page(page_id);
 
         if (!lazy)
             MARK_FRAME_FREE(frame_id); // Internal deallocation registration
     }
 
+    /** Sets a kernel page directory entry, in the kernel PDT and in every process PDT, which all share higher half PDEs */
+    static void set_kernel_pde(uint pde, uint val)
+    {
+        pdt->entries[pde] = val;
+        for (pid_t pid = 0; pid < (pid_t)MAX_PROCESSES; pid++)
+        {
+            const Process* process = Scheduler::get_process(pid);
+            if (process && process->pdt != pdt)
+                process->pdt->entries[pde] = val;
+        }
+        TLB::invalidate_page(pde * PT_ENTRIES); // Invalidates the whole large page, if any
+    }
+
+    void copy_kernel_pdes(pdt_t* process_pdt)
+    {
+        memcpy(process_pdt->entries + ADDR_PDE(KERNEL_VIRTUAL_BASE), pdt->entries + ADDR_PDE(KERNEL_VIRTUAL_BASE),
+               sizeof(uint) * (PDT_ENTRIES - ADDR_PDE(KERNEL_VIRTUAL_BASE)));
+    }
+
+    bool map_large_page(uint pde)
+    {
+        if (pde < ADDR_PDE(KERNEL_VIRTUAL_BASE) || pdt->entries[pde] & PAGE_LARGE)
+            return false;
+
+        const uint first_frame = PTE(page_tables, pde * PT_ENTRIES) >> 12;
+        if (first_frame & (PT_ENTRIES - 1))
+            return false;
+        for (uint i = 0; i < PT_ENTRIES; i++)
+            if (PTE(page_tables, pde * PT_ENTRIES + i) != (FRAME_ID_ADDR(first_frame + i) | DEFAULT_K_POLICY | PAGE_GLOBAL))
+                return false;
+
+        set_kernel_pde(pde, FRAME_ID_ADDR(first_frame) | PAGE_LARGE | PAGE_GLOBAL | DEFAULT_K_POLICY);
+
+        return true;
+    }
+
+    void split_large_page(uint pde)
+    {
+        if (!(pdt->entries[pde] & PAGE_LARGE))
+            return;
+
+        set_kernel_pde(pde, PTE_PHYS_ADDR(pde) | PAGE_WRITE | PAGE_PRESENT);
+    }
+
+    void map_large_pages(uint page_id, uint n)
+    {
+        for (uint pde = (page_id + PT_ENTRIES - 1) >> 10; (pde + 1) * PT_ENTRIES <= page_id + n; pde++)
+            map_large_page(pde);
+    }
+
+    bool page_table_present(const page_table_t* pt, uint pde)
+    {
+        return PTE(page_tables, ADDR_PAGE((uintptr_t)&pt[pde])) & PAGE_PRESENT;
+    }
+
+    bool pte_used(const page_table_t* pt, uint page_id)
+    {
+        return page_table_present(pt, page_id >> 10) && PTE_USED(pt, page_id);
+    }
+
     void allocate_page(uint frame_id, uint page_id, int policy)
     {
+        split_large_page(page_id >> 10);
+
         // Write PTE
+        if (policy & PAGE_PRESENT)
+            policy |= PAGE_GLOBAL_IF_KERNEL(page_id);
+        const bool was_present = PTE(page_tables, page_id) & PAGE_PRESENT;
         PTE(page_tables, page_id) = FRAME_ID_ADDR(frame_id) | policy;
-        __asm__ volatile("invlpg (%0)" : : "r" (frame_id << 12));
+        VirtualPageAllocator::set_used(page_id, policy & (PAGE_PRESENT | PAGE_LAZY_ZERO));
+        if (was_present)
+            TLB::invalidate_page(page_id);
+        else
+            TLB::invalidate_new_page(page_id);
 
         if (policy & PAGE_PRESENT)
             MARK_FRAME_USED(frame_id, page_id);
@@ -91,7 +172,7 @@ namespace Memory
                 return (uint)-1;
 
             uint target = pte + n;
-            for (; !(PTE_USED(pt, pte)) && pte != target; pte++) {}
+            for (; !pte_used(pt, pte) && pte != target; pte++) {}
 
             return pte == target ? b : (uint)-1;
         }
@@ -108,7 +189,7 @@ namespace Memory
             uint target = b + n;
 
             // Explore contiguous free blocks while explored block size does not fulfill the request
-            for (; !(PTE_USED(pt, pte)) && pte != target; pte++) {}
+            for (; !pte_used(pt, pte) && pte != target; pte++) {}
 
             // We have explored a free block that is big enough
             if (pte == target)
@@ -4,6 +4,7 @@
 #include "kstring.h"
 #include "kstddef.h"
 #include "MemoryDefines.h"
+#include "BuddyAllocator.h"
 
 namespace Memory
 {
@@ -40,9 +41,7 @@ namespace Memory
 	extern uint* frame_to_page;
 	extern uint* frame_rc;
 	extern uint lowest_free_pe_user;
-	extern uint lowest_free_frame;
 	extern uint* stack_top_ptr;
-	extern uint* lowest_free_pe; // Pointer to kernel_process.lowest_free_pe
 
 	struct hint_info
 	{
@@ -80,13 +79,40 @@ namespace Memory
 
 	void allocate_page(uint page_id, int policy);
 
-	/** Get index of lowest free page id and update lowest_free_page to next free page id */
+	/** Get index of lowest free frame. Frame is not marked as used. Returns PDT_ENTRIES * PT_ENTRIES if memory is full */
 	uint get_free_frame();
 
-	/** Get index of lowest free page entry id in higher half and update lowest_free_pe to next free page id */
+	/** Get index of lowest free page entry id in higher half. Returns PDT_ENTRIES * PT_ENTRIES if there is none */
 	uint get_free_pe();
 
 	void free_page(uint page_id);
 
+	/**
+	 * Maps a higher half page directory entry with a single 4 MiB page. This requires its 1024 pages to map 1024
+	 * contiguous frames starting on a 4 MiB boundary, with DEFAULT_K_POLICY.
+	 * The page table is left as is and still describes the mapping, so that PTE and PHYS_ADDR keep working.
+	 * @return whether the entry now maps a large page
+	 */
+	bool map_large_page(uint pde);
+
+	/** Makes a page directory entry mapping a large page point to its page table again. Does nothing otherwise */
+	void split_large_page(uint pde);
+
+	/** Maps every page directory entry lying entirely in a range of pages with a large page, wherever possible */
+	void map_large_pages(uint page_id, uint n);
+
+	/**
+	 * Copies the higher half entries of the kernel PDT into a process PDT. Kernel PDE changes are only propagated to
+	 * registered processes, so this must be done again right before a PDT built beforehand gets registered
+	 * @param process_pdt PDT to update
+	 */
+	void copy_kernel_pdes(pdt_t* process_pdt);
+
+	/** Whether a page table is backed by a frame. User page tables are allocated lazily */
+	bool page_table_present(const page_table_t* pt, uint pde);
+
+	/** Same as PTE_USED, entries of page tables which are not allocated yet being free */
+	bool pte_used(const page_table_t* pt, uint page_id);
+
 	uint get_contiguous_pages(uint n, const hint_info& hint_info, const page_table_t* pt, uint lowest_free_page_entry);
 }
@@ -0,0 +1,174 @@
+#include "SMP.h"
+
+#include "ACPI.h"
+#include "fb.h"
+#include "GDT.h"
+#include "IDT.h"
+#include "interrupts.h"
+#include "Kmap.h"
+#include "LAPIC.h"
+#include "memory.h"
+#include "PIT.h"
+#include "TLB.h"
+#include "../processes/scheduler.h"
+
+volatile uint SMP::num_cpus = 1;
+uint8_t SMP::apic_ids[MAX_CPUS]{};
+uint8_t SMP::cpu_ids[256]{};
+volatile bool SMP::ap_started = false;
+volatile uint SMP::kernel_lock_owner = 0; // The bootstrap processor runs kernel code from the start
+
+extern "C" void ap_trampoline_start_();
+extern "C" void ap_trampoline_params_();
+extern "C" void ap_trampoline_end_();
+
+extern "C" bool fpu_init_asm_();
+
+void SMP::init()
+{
+    if (ACPI::get_num_cpus() == 1 || !LAPIC::is_enabled())
+        return;
+
+    const uint8_t bsp_apic_id = LAPIC::get_id();
+    apic_ids[0] = bsp_apic_id;
+    cpu_ids[bsp_apic_id] = 0;
+
+    // The trampoline page lies in low memory, which is not handed out, but the bootloader may have left data there
+    if (FRAME_USED(ADDR_PAGE(AP_TRAMPOLINE_ADDR)))
+    {
+        printf_warn("Trampoline page 0x%x is in use, application processors will not be started", AP_TRAMPOLINE_ADDR);
+        return;
+    }
+    auto trampoline = (char*)Memory::Kmap::map(ADDR_PAGE(AP_TRAMPOLINE_ADDR));
+    memcpy(trampoline, (void*)ap_trampoline_start_, (uint)ap_trampoline_end_ - (uint)ap_trampoline_start_);
+    auto params = (ap_trampoline_params*)(trampoline + ((uint)ap_trampoline_params_ - (uint)ap_trampoline_start_));
+
+    // Paging gets enabled while executing the trampoline, which thus has to be identity mapped. The kernel page
+    // directory cannot spare a page in its lower half for that, processors start with a copy of it instead
+    auto startup_pdt = (Memory::pdt_t*)Memory::malloca(2 * PAGE_SIZE);
+    if (!startup_pdt)
+    {
+        printf_error("Not enough memory to start application processors");
+        Memory::Kmap::unmap(trampoline);
+        return;
+    }
+    auto startup_pt = (Memory::page_table_t*)(startup_pdt + 1);
+    memcpy(startup_pdt, Memory::pdt, sizeof(Memory::pdt_t));
+    memset(startup_pt, 0, sizeof(Memory::page_table_t));
+    startup_pt->entries[ADDR_PTE(AP_TRAMPOLINE_ADDR)] = AP_TRAMPOLINE_ADDR | PAGE_WRITE | PAGE_PRESENT;
+    startup_pdt->entries[ADDR_PDE(AP_TRAMPOLINE_ADDR)] = PHYS_ADDR(Memory::page_tables, (uint)startup_pt) |
+        PAGE_WRITE | PAGE_PRESENT;
+
+    params->cr3 = PHYS_ADDR(Memory::page_tables, (uint)startup_pdt);
+    __asm__ volatile("mov %%cr4, %0" : "=r"(params->cr4));
+    params->entry = ap_main;
+
+    for (uint i = 0; i < ACPI::get_num_cpus(); i++)
+    {
+        const uint8_t apic_id = ACPI::get_apic_id(i);
+        if (apic_id == bsp_apic_id)
+            continue;
+        if (!start_ap(apic_id, params))
+            printf_warn("Processor with APIC ID %u did not start", apic_id);
+    }
+
+    Memory::freea(startup_pdt);
+    Memory::Kmap::unmap(trampoline);
+}
+
+bool SMP::start_ap(uint8_t apic_id, ap_trampoline_params* params)
+{
+    const uint cpu = num_cpus;
+    params->stack_top = (uint)Scheduler::init_cpu(cpu);
+    apic_ids[cpu] = apic_id;
+    cpu_ids[apic_id] = cpu;
+    ap_started = false;
+    num_cpus = cpu + 1; // The processor has to know who it is as soon as it runs kernel code
+
+    // INIT-SIPI-SIPI. The second startup IPI is only needed if the processor missed the first one
+    LAPIC::send_init(apic_id);
+    PIT::busy_wait(AP_INIT_DELAY_US);
+    LAPIC::send_startup(apic_id, ADDR_PAGE(AP_TRAMPOLINE_ADDR));
+    PIT::busy_wait(AP_SIPI_DELAY_US);
+    if (!ap_started)
+        LAPIC::send_startup(apic_id, ADDR_PAGE(AP_TRAMPOLINE_ADDR));
+
+    for (uint waited = 0; !ap_started && waited < AP_STARTUP_TIMEOUT_US; waited += AP_SIPI_DELAY_US)
+        PIT::busy_wait(AP_SIPI_DELAY_US);
+    if (ap_started)
+        return true;
+
+    num_cpus = cpu;
+    return false;
+}
+
+void SMP::ap_main()
+{
+    // Leave the startup page directory
+    Interrupts::change_pdt_asm(PHYS_ADDR(Memory::page_tables, (uint)Memory::pdt));
+
+    GDT::init();
+    IDT::load();
+    if (!fpu_init_asm_())
+        irrecoverable_error("Processor %u: FPU not available", get_cpu_id());
+    LAPIC::enable(false);
+
+    // Startup parameters can be reused from now on
+    ap_started = true;
+
+    lock_kernel();
+    Scheduler::schedule();
+}
+
+uint SMP::get_cpu_id()
+{
+    // Only the bootstrap processor runs until an application processor is started
+    if (num_cpus == 1)
+        return 0;
+
+    return cpu_ids[LAPIC::get_id()];
+}
+
+uint SMP::get_num_cpus()
+{
+    return num_cpus;
+}
+
+void SMP::lock_kernel()
+{
+    const uint cpu = get_cpu_id();
+    if (kernel_lock_owner == cpu)
+        return;
+
+    uint expected = KERNEL_LOCK_FREE;
+    while (!__atomic_compare_exchange_n(&kernel_lock_owner, &expected, cpu, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    {
+        while (kernel_lock_owner != KERNEL_LOCK_FREE)
+            __builtin_ia32_pause();
+        expected = KERNEL_LOCK_FREE;
+    }
+
+    // Other processors may have changed higher half mappings since this one last ran kernel code
+    Memory::TLB::catch_up();
+}
+
+void SMP::unlock_kernel()
+{
+    __atomic_store_n(&kernel_lock_owner, KERNEL_LOCK_FREE, __ATOMIC_RELEASE);
+}
+
+void SMP::unlock_kernel_and_halt(void* stack_top)
+{
+    __asm__ volatile("mov %0, %%esp\n"
+                     "movl %2, (%1)\n"
+                     "sti\n"
+                     "hlt" : : "r"(stack_top), "r"(&kernel_lock_owner), "i"(KERNEL_LOCK_FREE) : "memory");
+
+    // Interrupts taken while halted end up in the scheduler
+    irrecoverable_error("%s: unreachable called has been reached!", __PRETTY_FUNCTION__);
+}
+
+void SMP::send_reschedule(uint cpu)
+{
+    LAPIC::send_interrupt(apic_ids[cpu], LAPIC_RESCHEDULE_INTERRUPT);
+}
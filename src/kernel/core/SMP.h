@@ -0,0 +1,85 @@
+#ifndef CUSTOM_OS_SMP_H
+#define CUSTOM_OS_SMP_H
+
+#include <kstddef.h>
+#include <stdint.h>
+
+#ifndef MAX_CPUS
+#define MAX_CPUS 8 // Processors the kernel can use. 1 leaves application processors halted
+#endif
+#define AP_TRAMPOLINE_ADDR 0x8000 // Physical address application processors start at. Must match smp_.s
+#define AP_INIT_DELAY_US 10000 // Time to wait between INIT and startup IPIs
+#define AP_SIPI_DELAY_US 200 // Time to wait for a processor to start before sending a second startup IPI
+#define AP_STARTUP_TIMEOUT_US 100000 // Time to wait for a processor to start before giving up on it
+#define KERNEL_LOCK_FREE MAX_CPUS // Big kernel lock owner value when no processor holds it
+
+/**
+ * Symmetric multiprocessing.
+ *
+ * Application processors (APs) are found in the ACPI MADT and started by the bootstrap processor (BSP) with the
+ * INIT-SIPI-SIPI sequence. Each of them gets its own GDT, TSS and scheduling stack, and its local APIC timer as
+ * preemption timer. They all pick processes from the scheduler ready queue.
+ *
+ * Kernel code is serialized by a big kernel lock: a processor takes it when it enters the kernel (interrupt, exception
+ * or syscall) and releases it when it goes back to userland or halts. Interrupts nested in kernel code find it already
+ * held by their processor. Kernel processes and interrupted syscall handlers are resumed with the lock held.
+ */
+class SMP
+{
+	// Startup parameters, read by the trampoline. Layout must match ap_trampoline_params_ in smp_.s
+	struct ap_trampoline_params
+	{
+		uint cr3; // Startup page directory, which identity maps the trampoline
+		uint cr4;
+		uint stack_top;
+		void (*entry)();
+	} __attribute__((packed));
+
+	static volatile uint num_cpus; // Processors started or being started
+	static uint8_t apic_ids[MAX_CPUS]; // Local APIC ID of each processor
+	static uint8_t cpu_ids[256]; // Processor index of each local APIC ID
+	static volatile bool ap_started; // Set by the AP being started once it runs kernel code
+	static volatile uint kernel_lock_owner; // Processor holding the big kernel lock, KERNEL_LOCK_FREE if none
+
+	/**
+	 * Starts an application processor and waits for it to run kernel code
+	 * @param apic_id local APIC ID of the processor
+	 * @param params trampoline parameters, the stack is set here
+	 * @return whether the processor started
+	 */
+	static bool start_ap(uint8_t apic_id, ap_trampoline_params* params);
+
+	/** Application processors entry point, after the trampoline */
+	[[noreturn]] static void ap_main();
+
+public:
+	/**
+	 * Starts the application processors described by ACPI. Scheduler, PIT and local APIC have to be set up beforehand,
+	 * the processors start scheduling processes right away
+	 */
+	static void init();
+
+	/** Index of the calling processor, 0 being the bootstrap processor */
+	[[nodiscard]] static uint get_cpu_id();
+
+	/** Number of running processors */
+	[[nodiscard]] static uint get_num_cpus();
+
+	/** Takes the big kernel lock, unless the calling processor already holds it */
+	static void lock_kernel();
+
+	/** Releases the big kernel lock */
+	static void unlock_kernel();
+
+	/**
+	 * Releases the big kernel lock and halts until an interrupt comes
+	 * @param stack_top stack to halt on. The lock is only released once the processor runs on it, as the current one
+	 * may belong to a process another processor is about to resume
+	 */
+	[[noreturn]] static void unlock_kernel_and_halt(void* stack_top);
+
+	/** Asks a processor to look for a process to run */
+	static void send_reschedule(uint cpu);
+};
+
+#endif //CUSTOM_OS_SMP_H
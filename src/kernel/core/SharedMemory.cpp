@@ -0,0 +1,165 @@
+#include "SharedMemory.h"
+
+#include <errno.h>
+#include <fcntl.h>
+
+#include "BuddyAllocator.h"
+#include "Kmap.h"
+#include "memory.h"
+#include "ZeroedFramePool.h"
+#include "../processes/process.h"
+
+namespace Memory
+{
+    list<SharedPointer<SharedMemory>> SharedMemory::named_objects{};
+    uint SharedMemory::num_resident_pages = 0;
+
+    SharedMemory::SharedMemory(const char* name) : name(name ? strdup(name) : nullptr), size(0), num_pages(0),
+                                                   pages(nullptr)
+    {
+    }
+
+    SharedMemory::~SharedMemory()
+    {
+        for (uint i = 0; i < num_pages; i++)
+            if (pages[i])
+                release_page(i);
+        free(pages);
+        free(name);
+    }
+
+    void SharedMemory::release_page(uint index)
+    {
+        // Mapped frames are left to their processes, the last one to unmap it frees the kernel page (cf. free_page)
+        const uint frame_id = PHYS_ADDR(page_tables, pages[index] << 12) >> 12;
+        if (frame_rc[frame_id] > 1)
+            frame_rc[frame_id]--;
+        else
+            free_page(pages[index]);
+        pages[index] = 0;
+        num_resident_pages--;
+    }
+
+    SharedPointer<SharedMemory> SharedMemory::open(const char* name, int flags, int& err)
+    {
+        while (*name == '/')
+            name++;
+        if (!*name || strchr(name, '/'))
+        {
+            err = -EINVAL;
+            return nullptr;
+        }
+
+        for (const auto& object : named_objects)
+        {
+            if (strcmp(object->name, name))
+                continue;
+            if (flags & O_CREAT && flags & O_EXCL)
+            {
+                err = -EEXIST;
+                return nullptr;
+            }
+            if (flags & O_TRUNC)
+                object->resize(0);
+            return object;
+        }
+
+        if (!(flags & O_CREAT))
+        {
+            err = -ENOENT;
+            return nullptr;
+        }
+        SharedPointer<SharedMemory> object{new SharedMemory(name)};
+        named_objects.add(object);
+
+        return object;
+    }
+
+    int SharedMemory::unlink(const char* name)
+    {
+        while (*name == '/')
+            name++;
+
+        for (const auto& object : named_objects)
+        {
+            if (strcmp(object->name, name))
+                continue;
+            named_objects.remove(object);
+            return 0;
+        }
+
+        return -ENOENT;
+    }
+
+    int SharedMemory::resize(uint new_size)
+    {
+        const uint new_num_pages = ADDR_PAGE(new_size + PAGE_SIZE - 1);
+        for (uint i = new_num_pages; i < num_pages; i++)
+            if (pages[i])
+                release_page(i);
+
+        if (new_num_pages != num_pages)
+        {
+            auto new_pages = (uint*)realloc(pages, (new_num_pages ? new_num_pages : 1) * sizeof(uint));
+            if (!new_pages)
+                return -ENOMEM;
+            for (uint i = num_pages; i < new_num_pages; i++)
+                new_pages[i] = 0;
+            pages = new_pages;
+            num_pages = new_num_pages;
+        }
+        size = new_size;
+
+        return 0;
+    }
+
+    bool SharedMemory::map_page(const Process* process, uint page_id, uint index)
+    {
+        if (index >= num_pages)
+            return false;
+
+        if (!pages[index])
+        {
+            bool zeroed;
+            const uint frame_id = ZeroedFramePool::get_frame(zeroed);
+            if (frame_id == BuddyAllocator::NUM_FRAMES)
+                return false;
+            const uint sys_page_id = get_free_pe_user();
+            allocate_page(frame_id, sys_page_id, DEFAULT_K_POLICY);
+            if (!zeroed)
+            {
+                void* page = Kmap::map(frame_id);
+                memset(page, 0, PAGE_SIZE);
+                Kmap::unmap(page);
+            }
+            pages[index] = sys_page_id;
+            num_resident_pages++;
+        }
+
+        // Entry was not present, thus not cached by the TLB
+        const uint frame_id = PHYS_ADDR(page_tables, pages[index] << 12) >> 12;
+        const uint pte = PTE(process->page_tables, page_id);
+        process->update_pte(page_id, FRAME_ID_ADDR(frame_id) | (pte & (PAGE_USER | PAGE_WRITE)) | PAGE_PRESENT, false);
+
+        return true;
+    }
+
+    uint SharedMemory::get_size() const
+    {
+        return size;
+    }
+
+    uint SharedMemory::get_num_resident_pages()
+    {
+        return num_resident_pages;
+    }
+
+    const shared_mapping* shared_mapping::find(const Process* process, uintptr_t address)
+    {
+        for (const auto& m : process->shared_mappings)
+            if (address >= m.start && address < m.end)
+                return &m;
+
+        return nullptr;
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdint.h>
+#include "MemoryDefines.h"
+#include "../utils/list.h"
+#include "../utils/shared_pointer.h"
+
+#define SHM_DIR "/dev/shm/" // Directory shm_open looks shared memory objects up in. It is not backed by any file system
+#define SHM_DEV 16 // fstat st_dev for shared memory objects (set arbitrarily)
+
+class Process;
+
+namespace Memory
+{
+    /**
+     * Memory object whose frames are shared by every process mapping it with MAP_SHARED: writes of a process are seen
+     * by the others, pages are never copied.
+     *
+     * Each page of the object lives in a kernel page holding a reference to its frame, allocated zeroed on first access.
+     * Processes map the frame itself, writable if their mapping is. Until then, their pages are mapped
+     * PAGE_LAZY_ZERO | PAGE_SHARED.
+     * Anonymous objects (MAP_SHARED | MAP_ANONYMOUS) live as long as they are mapped. Named ones (shm_open) live until
+     * they are unlinked and neither open nor mapped anymore.
+     */
+    class SharedMemory
+    {
+        static list<SharedPointer<SharedMemory>> named_objects; // Objects that have not been unlinked
+        static uint num_resident_pages; // Pages of every object backed by a frame
+
+        char* name; // nullptr if anonymous
+        uint size;
+        uint num_pages;
+        uint* pages; // Kernel page of each page of the object, 0 if never accessed
+
+        /** Drops the object reference to one of its pages, freeing it if no process maps it */
+        void release_page(uint index);
+
+    public:
+        /** Creates an empty object. Objects are meant to be managed through SharedPointers */
+        explicit SharedMemory(const char* name = nullptr);
+
+        ~SharedMemory();
+
+        /**
+         * Opens a named object
+         * @param name object name, without leading slash
+         * @param flags open flags, O_CREAT, O_EXCL and O_TRUNC are honored
+         * @param err error code to return in case of failure
+         * @return the object, null on failure
+         */
+        static SharedPointer<SharedMemory> open(const char* name, int flags, int& err);
+
+        /**
+         * Removes the name of an object. The object itself lives on while it is open or mapped
+         * @return 0 on success, -errno on error
+         */
+        static int unlink(const char* name);
+
+        /**
+         * Resizes the object. Pages that end up past its end are released, processes mapping them keep their frame
+         * @return 0 on success, -errno on error
+         */
+        int resize(uint new_size);
+
+        /**
+         * Maps a page of the object in a process, allocating it if it has never been accessed
+         * @param process process to map the page in
+         * @param page_id page to map, lazily allocated in the process. It is mapped writable if its entry is
+         * @param index index of the page in the object
+         * @return whether the page has been mapped, false if it lies past the end of the object or memory is full
+         */
+        bool map_page(const Process* process, uint page_id, uint index);
+
+        [[nodiscard]] uint get_size() const;
+
+        [[nodiscard]] static uint get_num_resident_pages();
+    };
+
+    /** Range of a process address space mapping a shared memory object */
+    struct shared_mapping
+    {
+        uintptr_t start, end; // Page aligned
+        SharedPointer<SharedMemory> object;
+        uint offset; // Offset in the object of the first byte of the range, page aligned
+
+        /** Mappings of a process do not overlap, a mapping is identified by its range */
+        bool operator==(const shared_mapping& other) const
+        {
+            return start == other.start && end == other.end;
+        }
+
+        /**
+         * Finds the shared mapping an address belongs to
+         * @return the mapping, nullptr if the address is not part of any
+         */
+        static const shared_mapping* find(const Process* process, uintptr_t address);
+    };
+}
@@ -0,0 +1,92 @@
+#include "TLB.h"
+
+#include "memory.h"
+
+namespace Memory
+{
+    uint TLB::generation = 0;
+    uint TLB::cpu_generations[MAX_CPUS]{};
+    TLB::invalidation TLB::log[LOG_SIZE]{};
+
+    void TLB::record_kernel_invalidation(uint page_id, uint n)
+    {
+        // The calling processor holds the big kernel lock, it was up to date and has just caught up with itself
+        log[++generation % LOG_SIZE] = {page_id, n};
+        cpu_generations[SMP::get_cpu_id()] = generation;
+    }
+
+    void TLB::invlpg(uint page_id)
+    {
+        __asm__ volatile("invlpg (%0)" : : "r" (page_id << 12) : "memory");
+    }
+
+    void TLB::drop_all()
+    {
+        // Without global pages, reloading CR3 already drops everything
+        if (GLOBAL_PAGES)
+            flush_global_tlb_asm();
+        else
+            reload_cr3_asm();
+    }
+
+    void TLB::invalidate_page(uint page_id)
+    {
+        invlpg(page_id);
+        if (page_id >= ADDR_PAGE(KERNEL_VIRTUAL_BASE))
+            record_kernel_invalidation(page_id, 1);
+    }
+
+    void TLB::invalidate_new_page(uint page_id)
+    {
+        invlpg(page_id);
+    }
+
+    void TLB::invalidate_range(uint page_id, uint n)
+    {
+        if (n > RANGE_FLUSH_THRESHOLD)
+        {
+            if (page_id + n > ADDR_PAGE(KERNEL_VIRTUAL_BASE))
+                flush_all();
+            else
+                flush();
+            return;
+        }
+
+        for (uint i = 0; i < n; i++)
+            invlpg(page_id + i);
+        if (page_id + n > ADDR_PAGE(KERNEL_VIRTUAL_BASE))
+            record_kernel_invalidation(page_id, n);
+    }
+
+    void TLB::flush()
+    {
+        reload_cr3_asm();
+    }
+
+    void TLB::flush_all()
+    {
+        drop_all();
+        record_kernel_invalidation(0, 0);
+    }
+
+    void TLB::catch_up()
+    {
+        const uint cpu = SMP::get_cpu_id();
+        if (cpu_generations[cpu] == generation)
+            return;
+
+        // Invalidate the pages logged since then, unless the log has been overwritten meanwhile
+        bool dropped = generation - cpu_generations[cpu] > LOG_SIZE;
+        for (uint g = cpu_generations[cpu] + 1; !dropped && g != generation + 1; g++)
+        {
+            const invalidation& inv = log[g % LOG_SIZE];
+            if (!inv.n)
+                dropped = true;
+            for (uint i = 0; i < inv.n; i++)
+                invlpg(inv.page_id + i);
+        }
+        if (dropped)
+            drop_all();
+        cpu_generations[cpu] = generation;
+    }
+}
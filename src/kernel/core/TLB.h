@@ -0,0 +1,73 @@
+#pragma once
+
+#include "MemoryDefines.h"
+#include "SMP.h"
+
+namespace Memory
+{
+    /**
+     * Translation lookaside buffer maintenance.
+     *
+     * Higher half pages are global (PAGE_GLOBAL), so that address space switches only drop user translations.
+     * The flip side is that a CR3 reload no longer acknowledges changes of higher half mappings: any page table entry
+     * change has to be followed by the narrowest invalidation covering it.
+     *
+     * Higher half mappings are shared by every processor. Rather than interrupting the others, a processor invalidating
+     * higher half translations logs the pages it invalidated under a new generation number, and processors invalidate
+     * the pages logged since their own generation when they take the big kernel lock. Kernel code only runs with the
+     * lock held, so it never uses a stale higher half translation. Entries that were not present are never cached, so
+     * mapping them is not logged.
+     */
+    class TLB
+    {
+        struct invalidation
+        {
+            uint page_id;
+            uint n; // Number of pages, 0 for every page
+        };
+
+        static constexpr uint LOG_SIZE = 16;
+
+        static uint generation; // Number of higher half invalidations since boot
+        static uint cpu_generations[MAX_CPUS]; // Generation the TLB of each processor is up to date with
+        static invalidation log[LOG_SIZE]; // Latest higher half invalidations, the one of generation g at g % LOG_SIZE
+
+        /** Records that higher half translations have been invalidated on the calling processor, for the others */
+        static void record_kernel_invalidation(uint page_id, uint n);
+
+        /** Invalidates the translation of a single page on the calling processor */
+        static void invlpg(uint page_id);
+
+        /** Invalidates every translation of the calling processor */
+        static void drop_all();
+
+    public:
+        /** Above that many pages, flushing everything is cheaper than invalidating pages one by one */
+        static constexpr uint RANGE_FLUSH_THRESHOLD = 32;
+
+        /** Invalidates the translation of a single page, global or not */
+        static void invalidate_page(uint page_id);
+
+        /**
+         * Invalidates the translation of a page whose entry was not present, which no processor has cached. Only the
+         * calling processor is concerned, as it may have faulted on the page
+         */
+        static void invalidate_new_page(uint page_id);
+
+        /**
+         * Invalidates the translations of a range of pages.
+         * Small ranges are invalidated page by page, bigger ones by a single flush, which is global only if the range
+         * reaches the higher half.
+         */
+        static void invalidate_range(uint page_id, uint n);
+
+        /** Invalidates every non global translation, ie the user part of the address space */
+        static void flush();
+
+        /** Invalidates every translation, global ones included */
+        static void flush_all();
+
+        /** Invalidates the higher half translations other processors have invalidated since the calling one last did */
+        static void catch_up();
+    };
+}
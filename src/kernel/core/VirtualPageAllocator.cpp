@@ -0,0 +1,156 @@
+#include "VirtualPageAllocator.h"
+
+#include "RawMemory.h"
+#include "../utils/comparison.h"
+
+#define LEAF(word) ((word) + NUM_WORDS)
+#define NONE ((uint)-1)
+
+namespace Memory
+{
+    uint32_t* VirtualPageAllocator::bitmap = nullptr;
+    VirtualPageAllocator::node* VirtualPageAllocator::tree = nullptr;
+    uint VirtualPageAllocator::first_allocatable_page = 0;
+
+    static_assert(!(VirtualPageAllocator::NUM_WORDS & (VirtualPageAllocator::NUM_WORDS - 1)));
+
+    void VirtualPageAllocator::update_leaf(uint word)
+    {
+        const uint32_t w = bitmap[word];
+        node& leaf = tree[LEAF(word)];
+
+        leaf.prefix = w ? __builtin_ctz(w) : WORD_BITS;
+        leaf.suffix = w ? __builtin_clz(w) : WORD_BITS;
+
+        // Each step shortens every run of free pages by one
+        leaf.longest = 0;
+        for (uint32_t free = ~w; free; free &= free << 1)
+            leaf.longest++;
+    }
+
+    void VirtualPageAllocator::update_node(uint n, uint half_span)
+    {
+        const node& l = tree[2 * n];
+        const node& r = tree[2 * n + 1];
+
+        tree[n].prefix = l.prefix == half_span ? half_span + r.prefix : l.prefix;
+        tree[n].suffix = r.suffix == half_span ? half_span + l.suffix : r.suffix;
+        tree[n].longest = max(max(l.longest, r.longest), l.suffix + r.prefix);
+    }
+
+    void VirtualPageAllocator::init(void* mem, uint first_allocatable)
+    {
+        bitmap = static_cast<uint32_t*>(mem);
+        tree = reinterpret_cast<node*>(bitmap + NUM_WORDS);
+        first_allocatable_page = first_allocatable;
+
+        // Leaves
+        for (uint word = 0; word < NUM_WORDS; word++)
+        {
+            uint32_t w = 0;
+            for (uint bit = 0; bit < WORD_BITS; bit++)
+            {
+                const uint page_id = FIRST_PAGE + word * WORD_BITS + bit;
+                if (page_id < first_allocatable_page || PTE_USED(page_tables, page_id))
+                    w |= 1U << bit;
+            }
+            bitmap[word] = w;
+            update_leaf(word);
+        }
+
+        // Inner nodes, bottom up
+        for (uint n = NUM_WORDS - 1; n; n--)
+            update_node(n, (NUM_PAGES >> (31 - __builtin_clz(n))) / 2);
+    }
+
+    uint VirtualPageAllocator::search_word(uint n, uint h, uint word)
+    {
+        const uint lo = word * WORD_BITS;
+        uint run = 0;
+        for (uint bit = h > lo ? h - lo : 0; bit < WORD_BITS; bit++)
+        {
+            run = bitmap[word] & (1U << bit) ? 0 : run + 1;
+            if (run == n)
+                return lo + bit + 1 - n;
+        }
+
+        return NONE;
+    }
+
+    uint VirtualPageAllocator::search(uint n, uint h, uint node_id, uint lo, uint span)
+    {
+        // Node lies below the hint, or has no run long enough. Runs spanning several nodes are handled by their parent
+        if (lo + span <= h || tree[node_id].longest < n)
+            return NONE;
+        if (span == WORD_BITS)
+            return search_word(n, h, node_id - NUM_WORDS);
+
+        const uint half = span / 2;
+        const uint mid = lo + half;
+        const node& l = tree[2 * node_id];
+        const node& r = tree[2 * node_id + 1];
+
+        // Node lies above the hint, the run is known to be there: go straight to it
+        if (lo >= h)
+        {
+            if (l.longest >= n)
+                return search(n, h, 2 * node_id, lo, half);
+            if (l.suffix + r.prefix >= n)
+                return mid - l.suffix;
+            return search(n, h, 2 * node_id + 1, mid, half);
+        }
+
+        // Hint lies in the node: try the left child, then the run crossing the middle, then the right child
+        const uint res = search(n, h, 2 * node_id, lo, half);
+        if (res != NONE)
+            return res;
+        const uint start = max(mid - l.suffix, h);
+        if (start <= mid && mid - start + r.prefix >= n)
+            return start;
+        return search(n, h, 2 * node_id + 1, mid, half);
+    }
+
+    uint VirtualPageAllocator::find(uint n, uint hint)
+    {
+        if (!n || n > NUM_PAGES)
+            return NONE;
+
+        const uint h = max(hint, first_allocatable_page) - FIRST_PAGE;
+        const uint res = search(n, h, 1, 0, NUM_PAGES);
+
+        return res == NONE ? NONE : FIRST_PAGE + res;
+    }
+
+    bool VirtualPageAllocator::is_free(uint page_id, uint n)
+    {
+        if (page_id < first_allocatable_page || page_id + n > FIRST_PAGE + NUM_PAGES || page_id + n < page_id)
+            return false;
+
+        for (uint i = page_id - FIRST_PAGE; i < page_id - FIRST_PAGE + n; i++)
+            if (bitmap[i / WORD_BITS] & (1U << (i % WORD_BITS)))
+                return false;
+
+        return true;
+    }
+
+    void VirtualPageAllocator::set_used(uint page_id, bool used)
+    {
+        if (!bitmap || page_id < first_allocatable_page || page_id >= FIRST_PAGE + NUM_PAGES)
+            return;
+
+        const uint i = page_id - FIRST_PAGE;
+        const uint word = i / WORD_BITS;
+        const uint32_t prev = bitmap[word];
+        if (used)
+            bitmap[word] |= 1U << (i % WORD_BITS);
+        else
+            bitmap[word] &= ~(1U << (i % WORD_BITS));
+        if (bitmap[word] == prev)
+            return;
+
+        update_leaf(word);
+        uint n = LEAF(word) >> 1;
+        for (uint half_span = WORD_BITS; n; half_span *= 2, n >>= 1)
+            update_node(n, half_span);
+    }
+}
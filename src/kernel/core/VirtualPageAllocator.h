@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdint.h>
+#include "MemoryDefines.h"
+
+namespace Memory
+{
+    /**
+     * Allocator of the higher half pages, ie kernel virtual address space.
+     *
+     * Pages are tracked by a bitmap (1 = used), whose words are the leaves of a complete binary tree stored as an array
+     * (node 1 is the root, node i has children 2i and 2i + 1, word w is leaf w + NUM_WORDS). Each node stores the
+     * length of the free run starting at its first page, of the free run ending at its last page, and of the longest
+     * free run lying in its subtree. Free ranges then coalesce by construction, and finding the lowest run of n free
+     * pages (above a hint) is a single root to leaf walk, whatever the number of pages ever used.
+     *
+     * The allocator only tells which pages are free, and mirrors PTE_USED of the kernel page tables: every change of a
+     * higher half page table entry is reported through set_used.
+     */
+    class VirtualPageAllocator
+    {
+    public:
+        static constexpr uint FIRST_PAGE = KERNEL_VIRTUAL_BASE >> 12;
+        static constexpr uint NUM_PAGES = PDT_ENTRIES * PT_ENTRIES - FIRST_PAGE;
+        static constexpr uint WORD_BITS = 32;
+        static constexpr uint NUM_WORDS = NUM_PAGES / WORD_BITS;
+
+    private:
+        struct node
+        {
+            uint prefix; // Free pages at the beginning of the node
+            uint suffix; // Free pages at the end of the node
+            uint longest; // Longest free run in the node
+        };
+
+    public:
+        static constexpr uint MEM_SIZE = NUM_WORDS * sizeof(uint32_t) + 2 * NUM_WORDS * sizeof(node); // In bytes
+
+    private:
+        static uint32_t* bitmap;
+        static node* tree;
+        static uint first_allocatable_page; // Pages below it are never returned (kernel, page tables, memory metadata)
+
+        /** Recomputes a leaf from its bitmap word */
+        static void update_leaf(uint word);
+
+        /** Recomputes a node from its children, each of them spanning half_span pages */
+        static void update_node(uint n, uint half_span);
+
+        /** Lowest run of n free pages starting at or after page offset h, among those of a node spanning span pages */
+        static uint search(uint n, uint h, uint node_id, uint lo, uint span);
+
+        /** Lowest run of n free pages starting at or after page offset h and lying in a single bitmap word */
+        static uint search_word(uint n, uint h, uint word);
+
+    public:
+        /**
+         * Builds the bitmap and the tree from the kernel page tables
+         * @param mem MEM_SIZE bytes of memory to store the allocator in
+         * @param first_allocatable pages below that one will never be returned
+         */
+        static void init(void* mem, uint first_allocatable);
+
+        /**
+         * Gets the lowest run of free pages. Pages are not marked as used.
+         * @param n number of pages
+         * @param hint id of the lowest page the run may start at
+         * @return id of the first page of the run, (uint)-1 if there is none
+         */
+        static uint find(uint n, uint hint = 0);
+
+        /** Whether n pages starting at a given page are all free and allocatable */
+        static bool is_free(uint page_id, uint n);
+
+        /** Registers a page as used or free. Pages out of the higher half and calls before init are ignored */
+        static void set_used(uint page_id, bool used);
+    };
+}
@@ -0,0 +1,69 @@
+#include "ZeroedFramePool.h"
+
+#include <kstring.h>
+
+#include "Kmap.h"
+#include "memory.h"
+
+namespace Memory
+{
+    uint ZeroedFramePool::frames[ZEROED_FRAME_POOL_SIZE]{};
+    uint ZeroedFramePool::num_frames = 0;
+    uint ZeroedFramePool::hits = 0;
+    uint ZeroedFramePool::misses = 0;
+
+    void ZeroedFramePool::zero_frame(uint frame_id)
+    {
+        void* page = Kmap::map(frame_id);
+        memset(page, 0, PAGE_SIZE);
+        Kmap::unmap(page);
+    }
+
+    void ZeroedFramePool::refill(uint max_frames)
+    {
+        for (uint i = 0; i < max_frames && num_frames < ZEROED_FRAME_POOL_SIZE; i++)
+        {
+            // Leave some memory to the rest of the system
+            if (BuddyAllocator::get_num_free_frames() <= ZEROED_FRAME_POOL_SIZE)
+                return;
+
+            const uint frame_id = BuddyAllocator::get_free_frame();
+            BuddyAllocator::mark_used(frame_id);
+            zero_frame(frame_id);
+            frames[num_frames++] = frame_id;
+        }
+    }
+
+    uint ZeroedFramePool::get_frame(bool& zeroed)
+    {
+        zeroed = num_frames;
+        if (!num_frames)
+        {
+            misses++;
+            return get_free_frame();
+        }
+
+        hits++;
+        return frames[--num_frames];
+    }
+
+    uint ZeroedFramePool::release_frame()
+    {
+        return num_frames ? frames[--num_frames] : BuddyAllocator::NUM_FRAMES;
+    }
+
+    uint ZeroedFramePool::get_num_frames()
+    {
+        return num_frames;
+    }
+
+    uint ZeroedFramePool::get_hits()
+    {
+        return hits;
+    }
+
+    uint ZeroedFramePool::get_misses()
+    {
+        return misses;
+    }
+}
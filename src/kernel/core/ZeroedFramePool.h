@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+#include "MemoryDefines.h"
+
+#ifndef ZEROED_FRAME_POOL_SIZE
+#define ZEROED_FRAME_POOL_SIZE 64 // Number of pre-zeroed frames to keep at hand
+#endif
+
+namespace Memory
+{
+    /**
+     * Pool of frames that have been zeroed in advance, when the CPU had nothing better to do.
+     *
+     * Frames of the pool are marked as used in the buddy allocator, but have no owner (frame_rc and frame_to_page are
+     * left untouched), so that they can be handed out exactly like a frame fresh from get_free_frame.
+     * Frames are zeroed through temporary mappings (cf. Kmap).
+     */
+    class ZeroedFramePool
+    {
+    public:
+        static constexpr uint IDLE_REFILL_BATCH = 16; // Frames zeroed each time the CPU idles, interrupts are off meanwhile
+    private:
+        static uint frames[ZEROED_FRAME_POOL_SIZE];
+        static uint num_frames;
+        static uint hits;
+        static uint misses;
+
+        /** Maps a frame and zeroes it */
+        static void zero_frame(uint frame_id);
+
+    public:
+        /**
+         * Zeroes frames until the pool is full or max_frames frames have been zeroed. Does nothing when memory is low.
+         * Meant to be called when idling.
+         */
+        static void refill(uint max_frames);
+
+        /**
+         * Gets a frame, preferably a pre-zeroed one. Frame is not marked as used.
+         * @param zeroed set to whether the frame is known to be zeroed
+         * @return frame id, NUM_FRAMES if memory is full
+         */
+        static uint get_frame(bool& zeroed);
+
+        /**
+         * Gives back a frame of the pool to the rest of the system, used when memory is full.
+         * @return frame id, NUM_FRAMES if the pool is empty
+         */
+        static uint release_frame();
+
+        [[nodiscard]] static uint get_num_frames();
+
+        [[nodiscard]] static uint get_hits();
+
+        [[nodiscard]] static uint get_misses();
+    };
+}
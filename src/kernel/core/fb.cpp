@@ -178,6 +178,14 @@ void FB::putchar(
 		update_dirty_rect();
 }
 
+void FB::redraw()
+{
+	dirty_start_x = dirty_start_y = 0;
+	dirty_end_x = characters_per_line;
+	dirty_end_y = characters_per_col;
+	flush();
+}
+
 void FB::lock_flushing()
 {
 	lock_flush = true;
@@ -472,7 +480,9 @@ void FB::init(uint fps)
 	if (!((fb = (uint32_t*)Memory::register_physical_data(framebuffer_addr, fb_size))))
 		irrecoverable_error("Cannot map framebuffer");
 
-	fb_shadow = new cell[fb_width * fb_height];
+	// The shadow buffer is several MiB big and is read in whole on every redraw, map it with large pages
+	if (!((fb_shadow = (cell*)Memory::large_page_malloc(fb_width * fb_height * sizeof(cell)))))
+		irrecoverable_error("Cannot allocate framebuffer shadow buffer");
 	progress_bar_height = font->characterSize / 2;
 	characters_per_line = fb_width / 8;
 	characters_per_col = fb_height / font->characterSize;
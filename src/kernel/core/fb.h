@@ -26,8 +26,6 @@
 #define FB_YELLOW       0xFFFF55
 #define FB_WHITE        0xFFFFFF
 
-#define FB_ADDR 0xC03FF000
-
 #define CURSOR_END_LINE 0x0B
 #define CURSOR_BEGIN_LINE 0x0A
 
@@ -100,6 +98,9 @@ public:
 
     static void flush();
 
+    /** Redraws the whole screen */
+    static void redraw();
+
     static void lock_flushing();
 
     static void unlock_flushing();
@@ -8,10 +8,15 @@
 #include "syscalls.h"
 #include "PIT.h"
 #include "PIC.h"
+#include "PCI.h"
+#include "IOAPIC.h"
+#include "LAPIC.h"
+#include "SMP.h"
 #include "system.h"
 
 
 Interrupt_handler* Interrupts::handlers[256] = {nullptr};
+uint Interrupts::timer_interrupts = 0;
 
 /**
  * Changes current pdt
@@ -85,10 +90,14 @@ void Interrupts::gpf_handler(const stack_state* stack_state)
 }
 
 [[noreturn]]
-void Interrupts::interrupt_timer(uint kesp, cpu_state_t* cpu_state, stack_state_t* stack_state)
+void Interrupts::interrupt_timer(uint interrupt, uint kesp, cpu_state_t* cpu_state, stack_state_t* stack_state)
 {
-	// Update time
-	PIT::ticks++;
+	// TRIGGER_TIMER_INTERRUPT uses the PIT vector, only actual timer interrupts are acknowledged and counted. The PIT is
+	// only used through the PIC. Time is kept by the TSC, timers only have to call the scheduler
+	const bool timer_interrupt = interrupt == LAPIC_TIMER_INTERRUPT ||
+		(interrupt == 0x20 && !IOAPIC::is_enabled() && PIC::is_in_service(0));
+	if (timer_interrupt)
+		Interrupts::timer_interrupts++;
 
 	Process* p = Scheduler::get_running_process();
 
@@ -121,7 +130,8 @@ void Interrupts::interrupt_timer(uint kesp, cpu_state_t* cpu_state, stack_state_
 	}
 
 
-	PIC::acknowledge(0x20);
+	if (timer_interrupt)
+		Interrupts::acknowledge(interrupt);
 
 	Scheduler::schedule();
 }
@@ -130,6 +140,9 @@ extern "C"
 __attribute__((no_instrument_function))
 void interrupt_handler(uint kesp, cpu_state_t cpu_state, uint interrupt, stack_state_t stack_state)
 {
+	// No-op if this processor was already running kernel code
+	SMP::lock_kernel();
+
 	switch (interrupt)
 	{
 		case 0x01:
@@ -139,7 +152,8 @@ void interrupt_handler(uint kesp, cpu_state_t cpu_state, uint interrupt, stack_s
 			Interrupts::invalid_opcode(&stack_state);
 			break;
 		case 0x20:
-			Interrupts::interrupt_timer(kesp, &cpu_state, &stack_state);
+		case LAPIC_TIMER_INTERRUPT:
+			Interrupts::interrupt_timer(interrupt, kesp, &cpu_state, &stack_state);
 		case 0x21:
 			Keyboard::interrupt_handler();
 			break;
@@ -149,6 +163,12 @@ void interrupt_handler(uint kesp, cpu_state_t cpu_state, uint interrupt, stack_s
 		case 0xD:
 			Interrupts::gpf_handler(&stack_state);
 			break;
+		case LAPIC_RESCHEDULE_INTERRUPT:
+			// An idle processor gets to the scheduler below. A sleeping process may have a closer deadline
+			Scheduler::update_timer();
+			break;
+		case LAPIC_SPURIOUS_INTERRUPT:
+			break; // Must not be acknowledged, Interrupts::acknowledge leaves it alone
 		case 0x80:
 			Syscall::dispatcher(&cpu_state, &stack_state);
 		default:
@@ -156,7 +176,7 @@ void interrupt_handler(uint kesp, cpu_state_t cpu_state, uint interrupt, stack_s
 			break;
 	}
 
-	PIC::acknowledge(interrupt);
+	Interrupts::acknowledge(interrupt);
 
 	// Handle the case where no process was running when the interrupt occurred. This typically happens when the CPU is
 	// halted because all processes are waiting.
@@ -165,6 +185,29 @@ void interrupt_handler(uint kesp, cpu_state_t cpu_state, uint interrupt, stack_s
 	// or shutdown if there is no more active processes
 	if (!Scheduler::get_running_process())
 		TRIGGER_TIMER_INTERRUPT
+
+	// A process woken up by this interrupt, or by another processor which sent a reschedule interrupt, may be more
+	// favoured than the running one
+	if (Scheduler::should_preempt())
+		TRIGGER_TIMER_INTERRUPT
+
+	// Going back to userland
+	if (stack_state.cs != 0x08)
+		SMP::unlock_kernel();
+}
+
+void Interrupts::acknowledge(uint interrupt)
+{
+	if (interrupt == LAPIC_TIMER_INTERRUPT || interrupt == LAPIC_RESCHEDULE_INTERRUPT ||
+		(interrupt >= MSI_START_INTERRUPT && interrupt <= MSI_END_INTERRUPT))
+		LAPIC::eoi();
+	else if (interrupt >= PIC1_START_INTERRUPT && interrupt <= PIC2_END_INTERRUPT)
+	{
+		if (IOAPIC::is_enabled())
+			LAPIC::eoi();
+		else
+			PIC::acknowledge(interrupt);
+	}
 }
 
 void Interrupts::enable_asm()
@@ -36,6 +36,7 @@ class Interrupts
 {
 public:
 	static Interrupt_handler* handlers[256];
+	static uint timer_interrupts; // Timer interrupts taken by all processors, software triggered ones excluded
 	/**
 	 * Handles a page fault
 	 *
@@ -53,13 +54,21 @@ public:
 	static void gpf_handler(const struct stack_state* stack_state);
 
 	/**
-	 * Handler for preemption timer
+	 * Handler for preemption timer, which calls the scheduler
+	 * @param interrupt PIT (or software triggered) interrupt, or local APIC timer interrupt
 	 * @param kesp Kernel ESP (see details in interrupt_handlers declaration)
 	 * @param cpu_state CPU state
 	 * @param stack_state stack state
 	 */
 	[[noreturn]]
-	static void interrupt_timer(uint kesp, cpu_state_t* cpu_state, stack_state_t* stack_state);
+	static void interrupt_timer(uint interrupt, uint kesp, cpu_state_t* cpu_state, stack_state_t* stack_state);
+
+	/**
+	 * Signals the end of a hardware interrupt to the controller which delivered it: the local APIC for its own
+	 * interrupts, MSI and legacy IRQs routed by the I/O APIC, the PIC otherwise
+	 * @param interrupt interrupt vector
+	 */
+	static void acknowledge(uint interrupt);
 
 	/**
 	 * Enables interrupts
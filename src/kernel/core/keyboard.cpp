@@ -15,6 +15,8 @@
 bool ctrl_hold = false;
 bool shift_hold = false;
 
+WaitQueue Keyboard::wait_queue{};
+
 char Keyboard::kbd_US[128] =
 {
     0, 27, '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', '-', '=', '\b',
@@ -154,7 +156,10 @@ void Keyboard::handle_char(unsigned char c)
         }
 
         if (c)
-            Scheduler::wake_up_key_waiting_processes(c);
+        {
+            while (Process* p = wait_queue.wake_one())
+                p->cpu_state.eax = (uint)c; // Return key
+        }
     }
     else if (c == CTRL_RELEASED)
         ctrl_hold = false;
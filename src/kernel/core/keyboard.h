@@ -1,6 +1,8 @@
 #ifndef INCLUDE_KEYBOARD_H
 #define INCLUDE_KEYBOARD_H
 
+#include "../processes/WaitQueue.h"
+
 #define KBD_DATA_PORT   0x60
 
 class Keyboard
@@ -9,6 +11,8 @@ class Keyboard
 
 	static void handle_char(unsigned char c);
 public:
+	static WaitQueue wait_queue; // Processes waiting for a key press
+
 	static void interrupt_handler();
 
 	/**
@@ -1,3 +1,4 @@
+#include "ACPI.h"
 #include "fb.h"
 #include "GDT.h"
 #include "interrupts.h"
@@ -6,9 +7,13 @@
 #include "../processes/scheduler.h"
 #include "PIC.h"
 #include "IDT.h"
+#include "IOAPIC.h"
+#include "LAPIC.h"
+#include "SMP.h"
 #include "../file_management/VFS.h"
 #include "../network/Network.h"
 #include "../utils/profiling.h"
+#include "../utils/benchmarks.h"
 
 #define FPS 50
 
@@ -35,7 +40,6 @@ extern "C" bool fpu_init_asm_();
 // Todo: Understand where did program loading delay came back from and get rid of it
 // (cf. 18/06/26 screenshots where the last known fast loading project was, where a pull introduced delay back,
 // and reverting the pull didn't remove the delay)
-// Todo: remove inheritance of memtree on bst since some inherited methods use new or delete and are thus invalid
 // Todo: parse memory map from BIOS (to be aware of available regions and RAM size)
 // Todo: make Process::update_pte usage more controlled
 // Todo: fix example.com wget
@@ -57,6 +61,9 @@ extern "C" int kmain(uint ebx) // Ebx contains GRUB's multiboot2 structure point
 
     FLUSHED_FB_OK_OP("Setting up IDT\n", IDT::init());
 
+    // Before ACPI tables frames get handed out
+    FLUSHED_FB_OK_OP("Parsing ACPI tables\n", ACPI::init());
+
     FLUSHED_FB_OK_OP("Enabling interrupts\n", Interrupts::enable_asm())
 
     if (!fpu_init_asm_())
@@ -71,10 +78,23 @@ extern "C" int kmain(uint ebx) // Ebx contains GRUB's multiboot2 structure point
     // Start refreshing the display every frame
     Scheduler::start_kernel_process((void*)FB::refresh_loop);
 
+    // Legacy IRQs go through the PIC until the I/O APIC takes over
+    FLUSHED_FB_OK_OP("Setting up local APIC\n", LAPIC::init(ACPI::get_lapic_address()));
+    FLUSHED_FB_OK_OP("Setting up I/O APIC\n", IOAPIC::init());
+    // Switch to the local APIC timer, the I/O APIC leaves the PIT masked
+    Scheduler::update_timer();
+
+    // Processors start picking processes from the ready queue as soon as they are up
+    FLUSHED_FB_OK_OP("Starting application processors\n", SMP::init());
+
 #ifdef PROFILING
     Profiling::init();
 #endif
 
+#ifdef BENCHMARKS
+    Benchmarks::run();
+#endif
+
     FB_OK_OP("Initialize network card and stack\n", Network::init());
 
     FB_OK_OP("Initializing Virtual File System\n", VFS::init());
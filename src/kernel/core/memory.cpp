@@ -5,15 +5,30 @@ using namespace Memory;
 #include <kstring.h>
 #include <stdint.h>
 #include <sys/mman.h>
+#include <fcntl.h>
 
+#include "../processes/ELFLoader.h"
 #include "../processes/scheduler.h"
 #include "../utils/comparison.h"
 #include "abi-bits/errno.h"
+#include "Kmalloc.h"
+#include "Kmap.h"
+#include "PageCache.h"
 #include "RawMemory.h"
+#include "SharedMemory.h"
+#include "TLB.h"
+#include "VirtualPageAllocator.h"
+#include "ZeroedFramePool.h"
 
 namespace Memory
 {
     Process* kernel_process = nullptr;
+    uint zero_frame = 0; // Frame full of zeroes, mapped read-only by every lazily zeroed user page that is only read
+    uint zero_frame_faults = 0; // Number of read faults handled by mapping the zero frame
+    uint fault_around_pages = 0; // Number of pages allocated ahead of time by fault-around
+    uint file_page_faults = 0; // Number of faults on file-backed pages
+    uint file_pages_read = 0; // Number of file-backed pages read from their file into private frames
+    uint shared_page_faults = 0; // Number of faults on pages mapping a shared memory object
 
     /** Initializes frame to page mapping
      *
@@ -31,6 +46,33 @@ namespace Memory
      */
     void init_frame_rc();
 
+    /** Initializes the physical frame allocator
+     *
+     * This functions allocates PDT 772 to store the buddy allocator tree, registers the frames it uses, then builds
+     * the tree from frame_to_page.
+     */
+    void init_buddy_allocator();
+
+    /** Initializes the kernel virtual page allocator
+     *
+     * This functions allocates the allocator right after the buddy allocator tree, in PDT 772, then builds it from the
+     * kernel page tables.
+     */
+    void init_virtual_page_allocator();
+
+    /** Enables 4 MiB pages and maps the kernel image (PDT 768) with one of them
+     *
+     * Frames below the buddy allocator tree are never handed out, so the large page may safely cover the first 4 MiB of
+     * physical memory entirely. Page table 768 still describes the kernel pages.
+     */
+    void map_kernel_image_large_page();
+
+    /** Finds n free kernel pages, the first of which has the same offset in its page directory entry as a given frame,
+     * so that the 4 MiB chunks of a physically contiguous block can be mapped with large pages
+     * @return id of the first page, (uint)-1 if there is none
+     */
+    uint get_large_page_friendly_pages(uint n, uint first_frame_id);
+
     /** Allocate 1024 pages to store the 1024 pages tables required to map all the memory in PDT[769]. \n
      * 	The page table that maps kernel pages is moved into the newly allocated array of page tables and then freed. \n
      * 	This function also allocates 1024 tables on PDT[770] for frame_to_page
@@ -80,6 +122,28 @@ namespace Memory
      */
     void handle_cow_page_fault(const Process* current_process, bool higher_half, uint page_id, const page_table_t* pt);
 
+    /** Allocates and zeroes the zero frame */
+    void init_zero_frame();
+
+    /** Handles a read page fault on a lazily zeroed user page by mapping the zero frame into it, without allocating
+     * anything. Writable pages are mapped COW, so that the first write gets them a frame of their own.
+     *
+     * @param current_process process that was running when the page fault occurred
+     * @param page_id page id that caused the fault
+     * @param pte page table entry of the page
+     */
+    void handle_lazy_zero_read_fault(const Process* current_process, uint page_id, uint pte);
+
+    /** Gives a frame to a lazily allocated page and maps it writable
+     *
+     * @param current_process process that was running when the page fault occurred
+     * @param higher_half whether the page lies in the higher half of the kernel address space
+     * @param page_id page to give a frame to
+     * @param pt page table to use for the fault handling
+     * @param zero whether the page has to be zeroed, its content being undefined otherwise
+     */
+    void map_lazy_page(Process* current_process, bool higher_half, uint page_id, page_table_t* pt, bool zero);
+
     /** Handles a lazy zero page fault that occurred in the kernel address space
      *
      * @param current_process process that was running when the page fault occurred
@@ -89,6 +153,26 @@ namespace Memory
      */
     void handle_lazy_zero_page_fault(Process* current_process, bool higher_half, uint page_id, page_table_t* pt);
 
+    /** Allocates the lazily zeroed pages surrounding a user page that has just been allocated upon a fault, so that
+     * sequential accesses do not fault on every page. The window is FAULT_AROUND_N_PAGES aligned pages wide, clamped
+     * to the allocation the faulting page belongs to. Kernel pages are left lazy, as page tables and lazy_malloc
+     * buffers are seldom written through.
+     *
+     * @param current_process process that was running when the page fault occurred
+     * @param page_id page id that caused the fault
+     */
+    void fault_around(Process* current_process, uint page_id);
+
+    /** Handles a fault on a file-backed user page by reading it from its file, along with the file-backed pages
+     * surrounding it within an aligned window of FILE_READAHEAD_N_PAGES pages
+     *
+     * @param current_process process that was running when the page fault occurred
+     * @param page_id page id that caused the fault
+     * @param write_access whether the fault was caused by a write access
+     * @return whether the fault has been handled, false if it is an error
+     */
+    bool handle_file_page_fault(Process* current_process, uint page_id, bool write_access);
+
     uint get_free_pe_user()
     {
         while (lowest_free_pe_user < PDT_ENTRIES * PT_ENTRIES && PTE_USED(page_tables, lowest_free_pe_user))
@@ -102,7 +186,8 @@ namespace Memory
         // Allocate space for frame_rc
         for (size_t i = 0; i < PT_ENTRIES; i++)
         {
-            PTE(page_tables, 771 * PDT_ENTRIES + i) = FRAME_ID_ADDR(PDT_ENTRIES * 3 + i) | PAGE_WRITE | PAGE_PRESENT;
+            PTE(page_tables, 771 * PDT_ENTRIES + i) = FRAME_ID_ADDR(PDT_ENTRIES * 3 + i) | PAGE_GLOBAL |
+                PAGE_WRITE | PAGE_PRESENT;
             INVALIDATE_PAGE(771, i);
         }
         frame_rc = (uint*)VIRT_ADDR(771, 0, 0);
@@ -122,12 +207,67 @@ namespace Memory
         }
     }
 
+    void init_buddy_allocator()
+    {
+        constexpr uint tree_frames = BuddyAllocator::TREE_SIZE / PAGE_SIZE;
+        constexpr uint first_tree_frame = PDT_ENTRIES * 4;
+
+        // Allocate space for the tree
+        for (uint i = 0; i < tree_frames; i++)
+        {
+            PTE(page_tables, 772 * PDT_ENTRIES + i) = FRAME_ID_ADDR(first_tree_frame + i) | PAGE_GLOBAL |
+                PAGE_WRITE | PAGE_PRESENT;
+            INVALIDATE_PAGE(772, i);
+            frame_to_page[first_tree_frame + i] = 772 * PDT_ENTRIES + i;
+            frame_rc[first_tree_frame + i] = 1;
+        }
+
+        // Frames below the tree hold the kernel, the page tables, frame_to_page and frame_rc
+        BuddyAllocator::init((void*)VIRT_ADDR(772, 0, 0), first_tree_frame);
+    }
+
+    void map_kernel_image_large_page()
+    {
+        enable_pse_asm();
+        pdt->entries[768] = FRAME_ID_ADDR(0) | PAGE_LARGE | PAGE_GLOBAL | DEFAULT_K_POLICY;
+        reload_cr3_asm();
+        if (GLOBAL_PAGES)
+            enable_pge_asm();
+    }
+
+    uint get_large_page_friendly_pages(uint n, uint first_frame_id)
+    {
+        if (n < PT_ENTRIES)
+            return VirtualPageAllocator::find(n);
+
+        // Look for a bigger run, so that it necessarily contains a suitable one
+        const uint b = VirtualPageAllocator::find(n + PT_ENTRIES - 1);
+        if (b == (uint)-1)
+            return (uint)-1;
+
+        return b + ((first_frame_id - b) & (PT_ENTRIES - 1));
+    }
+
+    void init_virtual_page_allocator()
+    {
+        constexpr uint first_page = 772 * PDT_ENTRIES + BuddyAllocator::TREE_SIZE / PAGE_SIZE;
+        constexpr uint num_pages = (VirtualPageAllocator::MEM_SIZE + PAGE_SIZE - 1) / PAGE_SIZE;
+        static_assert(first_page + num_pages <= 773 * PDT_ENTRIES);
+
+        for (uint i = 0; i < num_pages; i++)
+            allocate_page(first_page + i, DEFAULT_K_POLICY);
+
+        // Page directories below 773 are managed by hand
+        VirtualPageAllocator::init((void*)(first_page << 12), 773 * PDT_ENTRIES);
+    }
+
     void init_frame_to_page()
     {
         // Allocate space for frame_to_page
         for (size_t i = 0; i < PT_ENTRIES; i++)
         {
-            PTE(page_tables, 770 * PDT_ENTRIES + i) = FRAME_ID_ADDR(PDT_ENTRIES * 2 + i) | PAGE_WRITE | PAGE_PRESENT;
+            PTE(page_tables, 770 * PDT_ENTRIES + i) = FRAME_ID_ADDR(PDT_ENTRIES * 2 + i) | PAGE_GLOBAL |
+                PAGE_WRITE | PAGE_PRESENT;
             INVALIDATE_PAGE(770, i);
         }
         frame_to_page = (uint*)VIRT_ADDR(770, 0, 0);
@@ -174,7 +314,7 @@ namespace Memory
 
         // Allocate pages 1024 to 2047, ie allocate space of all the page tables
         for (uint i = 0; i < PT_ENTRIES; ++i)
-            PTE(page_tables, i) = FRAME_ID_ADDR(PDT_ENTRIES + i) | PAGE_WRITE | PAGE_PRESENT;
+            PTE(page_tables, i) = FRAME_ID_ADDR(PDT_ENTRIES + i) | PAGE_GLOBAL | PAGE_WRITE | PAGE_PRESENT;
 
         // Indicate that newly allocated page is a page table. Map it in pdt[769]
         pdt->entries[769] = asm_pt1->entries[1022];
@@ -207,12 +347,16 @@ namespace Memory
         page_tables[768].entries[asm_pt1_page_table_entry] = 0;
 
         reload_cr3_asm(); // Apply changes | Full TLB flush is needed because we modified every pdt entry
+        map_kernel_image_large_page();
 
         init_frame_to_page();
         init_frame_rc();
+        init_buddy_allocator();
+        init_virtual_page_allocator();
 
-        uint used_page_directories = 4; // 0 is kernel, 1 is page tables, 2 is frame_to_page, 3 is frame_rc
-        lowest_free_frame = PT_ENTRIES * used_page_directories;
+        // 0 is kernel, 1 is page tables, 2 is frame_to_page, 3 is frame_rc, 4 is buddy allocator tree and virtual page
+        // allocator
+        uint used_page_directories = 5;
         lowest_free_pe_user = 1; // 0 is reserved for page faulting
 
         return (768 + used_page_directories) * PDT_ENTRIES; // Kernel is only allowed to allocate in higher half
@@ -291,6 +435,85 @@ namespace Memory
             if (fb_info_addr == (uint)-1)
                 register_physical_data(FB_MODE_INFO_ADDR_WHEN_CUSTOM_BOOTLOADER_USED, sizeof(FB::vbe_mode_info_structure));
         }
+
+        init_zero_frame();
+        Kmap::init();
+    }
+
+    void init_zero_frame()
+    {
+        // The kernel mapping holds a reference on the frame forever, so it is never freed
+        void* zero_page = malloca(PAGE_SIZE);
+        if (!zero_page)
+            irrecoverable_error("%s: cannot allocate zero frame", __func__);
+        memset(zero_page, 0, PAGE_SIZE);
+        zero_frame = PHYS_ADDR(page_tables, (uint)zero_page) >> 12;
+    }
+
+    /** Number of pages of the lower half of a process address space that are backed by a frame */
+    static uint get_num_resident_pages(const Process* process)
+    {
+        uint n = 0;
+        for (uint pde = 0; pde < ADDR_PDE(KERNEL_VIRTUAL_BASE); pde++)
+        {
+            if (!page_table_present(process->page_tables, pde))
+                continue;
+            for (uint pte = 0; pte < PT_ENTRIES; pte++)
+                n += (bool)(process->page_tables[pde].entries[pte] & PAGE_PRESENT);
+        }
+
+        return n;
+    }
+
+    uint get_mem_stat(MemStat stat, const Process* process)
+    {
+        switch (stat)
+        {
+            case MemStat::ZERO_FRAME_MAPPINGS:
+                return frame_rc[zero_frame] - 1; // Do not count the kernel mapping
+            case MemStat::ZERO_FRAME_FAULTS:
+                return zero_frame_faults;
+            case MemStat::ZEROED_POOL_FRAMES:
+                return ZeroedFramePool::get_num_frames();
+            case MemStat::ZEROED_POOL_HITS:
+                return ZeroedFramePool::get_hits();
+            case MemStat::ZEROED_POOL_MISSES:
+                return ZeroedFramePool::get_misses();
+            case MemStat::FAULT_AROUND_PAGES:
+                return fault_around_pages;
+            case MemStat::PROCESS_PAGE_FAULTS:
+                return process->num_page_faults;
+            case MemStat::PROCESS_RESIDENT_PAGES:
+                return get_num_resident_pages(process);
+            case MemStat::KMALLOC_ALLOCATIONS:
+                return Kmalloc::get_num_allocations();
+            case MemStat::KMALLOC_REQUESTED_BYTES:
+                return Kmalloc::get_requested_bytes();
+            case MemStat::KMALLOC_ALLOCATED_BYTES:
+                return Kmalloc::get_allocated_bytes();
+            case MemStat::FILE_PAGE_FAULTS:
+                return file_page_faults;
+            case MemStat::FILE_PAGES_READ:
+                return file_pages_read + PageCache::get_misses();
+            case MemStat::PAGE_CACHE_PAGES:
+                return PageCache::get_num_pages();
+            case MemStat::PAGE_CACHE_HITS:
+                return PageCache::get_hits();
+            case MemStat::ELF_IMAGE_CACHE_HITS:
+                return ELFLoader::get_image_cache_hits();
+            case MemStat::ELF_IMAGE_CACHE_MISSES:
+                return ELFLoader::get_image_cache_misses();
+            case MemStat::KMAP_HITS:
+                return Kmap::get_hits();
+            case MemStat::KMAP_FLUSHES:
+                return Kmap::get_flushes();
+            case MemStat::SHARED_MEMORY_PAGES:
+                return SharedMemory::get_num_resident_pages();
+            case MemStat::SHARED_PAGE_FAULTS:
+                return shared_page_faults;
+            default:
+                return 0;
+        }
     }
 
     multiboot_info_t* register_multiboot_info(const multiboot_info* minfo)
@@ -328,6 +551,18 @@ namespace Memory
 
     uint get_contiguous_pages(uint n, const hint_info& hint_info, const Process* process)
     {
+        // Kernel address space. Fixed mappings in the lower half of kernel page tables still go through a page walk
+        if (process->pdt == pdt && (!hint_info.is_mandatory || hint_info.hint >= KERNEL_VIRTUAL_BASE))
+        {
+            if (!hint_info.is_mandatory)
+                return VirtualPageAllocator::find(n, ADDR_PAGE(hint_info.hint));
+
+            if (hint_info.hint & (PAGE_SIZE - 1))
+                irrecoverable_error("%s: alloc_params->hint is not page aligned (0x%x)", __func__, hint_info.hint);
+            const uint b = ADDR_PAGE(hint_info.hint);
+            return VirtualPageAllocator::is_free(b, n) ? b : (uint)-1;
+        }
+
         return get_contiguous_pages(n, hint_info, process->page_tables, process->lowest_free_pe);
     }
 
@@ -358,8 +593,8 @@ namespace Memory
         bool range_is_valid = true;
         for (uint id = 0; id < num_pages; id++)
         {
-            uint page_id = ADDR_PAGE(uaddr + id);
-            uint pte = PTE(process->page_tables, page_id);
+            uint page_id = ADDR_PAGE(uaddr) + id;
+            uint pte = page_table_present(process->page_tables, page_id >> 10) ? PTE(process->page_tables, page_id) : 0;
             if (!(pte & PAGE_PRESENT || pte & PAGE_LAZY_ZERO))
             {
                 if (pte & PAGE_COW || pte & PAGE_SHRO)
@@ -377,14 +612,120 @@ namespace Memory
         // Apply new flags
         for (uint id = 0; id < num_pages; id++)
         {
-            constexpr uint flags_mask = ~PAGE_WRITE;
-
-            uint page_id = ADDR_PAGE(uaddr + id);
+            uint page_id = ADDR_PAGE(uaddr) + id;
             uint pte = PTE(process->page_tables, page_id);
-            pte &= flags_mask;
-            pte |= new_flags;
-            process->update_pte(page_id, pte, true);
+            if (pte & (PAGE_COW | PAGE_SHRO)) // Shared frame, write permission is granted by COW fault handling
+                pte = (pte & ~(PAGE_COW | PAGE_SHRO)) | (new_flags ? PAGE_COW : PAGE_SHRO);
+            else
+                pte = (pte & ~PAGE_WRITE) | new_flags;
+            process->update_pte(page_id, pte, false);
+        }
+        TLB::invalidate_range(ADDR_PAGE(uaddr), num_pages);
+
+        return 0;
+    }
+
+    /** Whether a range of pages lies in the part of a process address space that user code may unmap */
+    static bool is_unmappable_user_range(uintptr_t start, uint num_pages)
+    {
+        // Syscall stack must stay, the CPU switches to it upon entering the kernel
+        constexpr uintptr_t stacks_start = KERNEL_VIRTUAL_BASE - PROCESS_N_STACKS_PAGES * PAGE_SIZE;
+
+        return num_pages && start + num_pages * PAGE_SIZE > start && start + num_pages * PAGE_SIZE <= stacks_start;
+    }
+
+    /** Whether a page lies in a file mapping of a process, and holds file content */
+    static bool is_file_page(const Process* process, uint page_id)
+    {
+        const uintptr_t address = page_id << 12;
+        for (const auto& m : process->file_mappings)
+            if (address >= m.start && address < m.end)
+                return address - m.start < m.file_size;
+
+        return false;
+    }
+
+    int munmap(void* addr, size_t len, Process* process)
+    {
+        const auto start = (uintptr_t)addr;
+        const uint num_pages = ADDR_PAGE(len + PAGE_SIZE - 1);
+        if (start & (PAGE_SIZE - 1) || !is_unmappable_user_range(start, num_pages))
+            return -EINVAL;
+        const uintptr_t end = start + num_pages * PAGE_SIZE;
+
+        process->memtree.unmap(start, end);
+
+        // Forget about the parts of file mappings lying in the range
+        for (int i = process->file_mappings.size() - 1; i >= 0; i--)
+        {
+            file_mapping& m = *process->file_mappings.get(i);
+            if (m.end <= start || m.start >= end)
+                continue;
+
+            if (m.end > end) // Keep the part after the range
+            {
+                const uint skipped = end - m.start;
+                process->file_mappings.add({end, m.end, m.file, m.offset + skipped,
+                                            m.file_size > skipped ? m.file_size - skipped : 0});
+            }
+            if (m.start < start) // Keep the part before the range
+            {
+                m.end = start;
+                m.file_size = min(m.file_size, start - m.start);
+            }
+            else
+                process->file_mappings.remove(m);
+        }
+
+        // Same for shared memory mappings. Objects no longer mapped nor open are released along with them
+        for (int i = process->shared_mappings.size() - 1; i >= 0; i--)
+        {
+            shared_mapping& m = *process->shared_mappings.get(i);
+            if (m.end <= start || m.start >= end)
+                continue;
+
+            if (m.end > end) // Keep the part after the range
+                process->shared_mappings.add({end, m.end, m.object, m.offset + (end - m.start)});
+            if (m.start < start) // Keep the part before the range
+                m.end = start;
+            else
+                process->shared_mappings.remove(m);
+        }
+
+        // Release frames, then drop the cached translations at once
+        for (uint page_id = ADDR_PAGE(start); page_id < ADDR_PAGE(end); page_id++)
+            if (pte_used(process->page_tables, page_id))
+                free_page(page_id << 12, process, false);
+        TLB::invalidate_range(ADDR_PAGE(start), num_pages);
+        process->lowest_free_pe = min(process->lowest_free_pe, ADDR_PAGE(start));
+
+        return 0;
+    }
+
+    int madvise(void* addr, size_t len, int advice, const Process* process)
+    {
+        const auto start = (uintptr_t)addr;
+        const uint num_pages = ADDR_PAGE(len + PAGE_SIZE - 1);
+        if (start & (PAGE_SIZE - 1) || !is_unmappable_user_range(start, num_pages))
+            return -EINVAL;
+        if (advice != MADV_DONTNEED) // Mere hints, nothing to do
+            return 0;
+
+        for (uint page_id = ADDR_PAGE(start); page_id < ADDR_PAGE(start) + num_pages; page_id++)
+        {
+            if (!page_table_present(process->page_tables, page_id >> 10))
+                continue;
+            const uint pte = PTE(process->page_tables, page_id);
+            if (!(pte & PAGE_PRESENT)) // No frame to release
+                continue;
+
+            // Back to a lazily allocated page, with the permissions it had
+            const uint policy = (pte & PAGE_USER) | (pte & (PAGE_WRITE | PAGE_COW) ? PAGE_WRITE : 0) | PAGE_LAZY_ZERO |
+                (shared_mapping::find(process, page_id << 12) ? PAGE_SHARED : is_file_page(process, page_id) ? PAGE_FILE : 0);
+            free_page(page_id << 12, process, false);
+            process->update_pte(page_id, policy, false);
         }
+        TLB::invalidate_range(ADDR_PAGE(start), num_pages);
 
         return 0;
     }
@@ -392,7 +733,7 @@ namespace Memory
     void* sbrk(uint num_pages_requested, const page_info& page_info, const hint_info& hint_info, Process* process)
     {
         // Memory full
-        if (lowest_free_frame == PT_ENTRIES * PDT_ENTRIES)
+        if (!BuddyAllocator::get_num_free_frames())
             return nullptr;
 
         uint b = get_contiguous_pages(num_pages_requested, hint_info, process);
@@ -401,7 +742,8 @@ namespace Memory
         uint e = b + num_pages_requested; /* block end page index + 1*/
 
         // Allocate pages
-        if (constexpr int supported_policy = PAGE_USER | PAGE_LAZY_ZERO | PAGE_PRESENT | PAGE_WRITE; page_info.policy & ~supported_policy)
+        if (constexpr int supported_policy = PAGE_USER | PAGE_LAZY_ZERO | PAGE_PRESENT | PAGE_WRITE | PAGE_SHARED;
+            page_info.policy & ~supported_policy)
             irrecoverable_error("sbrk: Unsupported allocation flags: 0x%x", page_info.policy & ~supported_policy);
         if ((page_info.policy & PAGE_PRESENT) && (page_info.policy & PAGE_LAZY_ZERO))
             irrecoverable_error("sbrk: both PAGE_PRESENT and PAGE_LAZY zero cannot be specified at the same time");
@@ -430,19 +772,19 @@ namespace Memory
             else // Lazy allocation, do not allocate in kernel page tables
                 for (uint i = b; i < e; ++i)
                     process->update_pte(i, page_info.policy, true);
-        }
 
-        while (PTE_USED(process->page_tables, process->lowest_free_pe))
-            process->lowest_free_pe++;
+            while (pte_used(process->page_tables, process->lowest_free_pe))
+                process->lowest_free_pe++;
+        }
 
         // Allocated memory block virtually starts at page b. Return it.
         return (void*)(b << 12);
     }
 
-    void free_page(uint address, const Process* process)
+    void free_page(uint address, const Process* process, bool update_cache)
     {
-        // Cache is not updated, since this is not necessary on free. Pages may appear allocated (from the CPU's
-        // perspective) even though they are not, but this is not an issue, as long as cache is updated upon allocation
+        // The freed page is invalidated on its own, so that no stale translation lets the process reach a frame that
+        // may be handed out again
 
         uint pde = ADDR_PDE(address);
         uint pte = ADDR_PTE(address);
@@ -465,12 +807,17 @@ namespace Memory
             auto physical_address = PHYS_ADDR(process->page_tables, address);
             frame_id = physical_address >> 12;
             sys_page_id = frame_to_page[frame_id];
-            process->update_pte(page_id, 0, false); // Update process pte
+            process->update_pte(page_id, 0, update_cache); // Update process pte
         }
         else
         {
             // Current process is kernel process, so index computation is straightforward
             sys_page_id = pde * PT_ENTRIES + pte;
+            if (PTE(page_tables, sys_page_id) & PAGE_LAZY_ZERO) // Never accessed, there is no frame to free
+            {
+                free_page(sys_page_id);
+                return;
+            }
             frame_id = PHYS_ADDR(page_tables, address) >> 12;
             frame_rc[frame_id]--; // Decrement rc. For user processes this is done in udpate_pte
         }
@@ -486,7 +833,7 @@ namespace Memory
     {
         const uint num_pages = ADDR_PAGE(size + PAGE_SIZE - 1);
         int err;
-        return mmap((void*)KERNEL_VIRTUAL_BASE, num_pages * size, DEFAULT_K_PROT, DEFAULT_K_FLAGS, DEFAULT_K_POLICY, 0, err, kernel_process, false, false);
+        return mmap((void*)KERNEL_VIRTUAL_BASE, num_pages * PAGE_SIZE, DEFAULT_K_PROT, DEFAULT_K_FLAGS, DEFAULT_K_POLICY, 0, err, kernel_process, false, false);
     }
 
     void* calloca(size_t nmemb, size_t size)
@@ -501,12 +848,16 @@ namespace Memory
         if (__builtin_add_overflow(base_size, additional_size, &total_size))
             return nullptr;
 
+        // Pages are zeroed upon first access, with pre-zeroed frames whenever possible
         int err;
-        void* alloc = mmap((void*)KERNEL_VIRTUAL_BASE, num_pages * size, DEFAULT_K_PROT, DEFAULT_K_FLAGS, PAGE_WRITE | PAGE_LAZY_ZERO, 0, err, kernel_process, false, false);
-        if (!alloc)
-            return nullptr;
-        zero_out_possibly_lazily_allocated_memory(new_size, alloc, kernel_process);
-        return alloc;
+        return mmap((void*)KERNEL_VIRTUAL_BASE, new_size, DEFAULT_K_PROT, DEFAULT_K_FLAGS, 0, 0, err, kernel_process, true, false);
+    }
+
+    page_table_t* allocate_user_page_tables()
+    {
+        int err;
+        return (page_table_t*)mmap((void*)KERNEL_VIRTUAL_BASE, 768 * sizeof(page_table_t), DEFAULT_K_PROT,
+                                   DEFAULT_K_FLAGS, 0, 0, err, kernel_process, true, false);
     }
 
     void freea(void* ptr)
@@ -519,35 +870,96 @@ namespace Memory
         return stack_top_ptr;
     }
 
-    void* mmap(void* hint, size_t size, int prot, int flags, [[maybe_unused]] int fd, off_t offset, int& err, Process* process, bool
+    /**
+     * Maps a shared memory object in a user process, lazily: pages get their frame from the object upon first access
+     * @param object object to map, nullptr to create an anonymous one
+     */
+    static void* mmap_shared(void* hint, size_t size, int prot, int flags, off_t offset, int& err, Process* process,
+                             SharedPointer<SharedMemory> object)
+    {
+        if (!object)
+        {
+            object = SharedPointer<SharedMemory>{new SharedMemory()};
+            if (const int e = object->resize(size))
+            {
+                err = -e;
+                return nullptr;
+            }
+        }
+
+        const int policy = PAGE_USER | PAGE_LAZY_ZERO | PAGE_SHARED | (prot & PROT_WRITE ? PAGE_WRITE : 0);
+        const hint_info hint_info{reinterpret_cast<uintptr_t>(hint), (bool)(flags & MAP_FIXED)};
+        void* window = process->memtree.allocate(size, {flags, policy}, process, hint_info);
+        if (flags & MAP_FIXED && window != hint)
+            irrecoverable_error("%s: MAP_FIXED set, but returned window does not match hit", __func__);
+        if (!window)
+        {
+            err = ENOMEM;
+            return nullptr;
+        }
+
+        // The window may reuse pages that are already mapped, they all have to come from the object
+        const uint first_page_id = ADDR_PAGE((uintptr_t)window);
+        for (uint page_id = first_page_id; page_id < first_page_id + ADDR_PAGE(size); page_id++)
+        {
+            if (PTE(process->page_tables, page_id) == (uint)policy)
+                continue;
+            if (pte_used(process->page_tables, page_id))
+                free_page(page_id << 12, process, false);
+            process->update_pte(page_id, policy, false);
+        }
+        TLB::invalidate_range(first_page_id, ADDR_PAGE(size));
+
+        process->shared_mappings.add({(uintptr_t)window, (uintptr_t)window + size, object, (uint)offset});
+
+        return window;
+    }
+
+    void* mmap(void* hint, size_t size, int prot, int flags, int fd, off_t offset, int& err, Process* process, bool
                lazy_zero, bool page_user)
     {
 #define mmap_ret_err(error) {err = error; return nullptr;}
 #define mmap_ret_err_with_warnv(error, msg, ...) {printf_warn(msg, __VA_ARGS__); err = error; return nullptr;}
 #define mmap_ret_err_with_warn(error, msg) {printf_warn(msg); err = error; return nullptr;}
 
-        constexpr int supported_flags = MAP_ANON | MAP_ANONYMOUS | MAP_PRIVATE | MAP_FIXED;
+        constexpr int supported_flags = MAP_ANON | MAP_ANONYMOUS | MAP_PRIVATE | MAP_SHARED | MAP_FIXED;
         if (flags & ~supported_flags)
             mmap_ret_err_with_warnv(EINVAL, "mmap called with the following unsupported flags: 0x%x", flags & ~supported_flags)
 
-        if (!((flags & MAP_PRIVATE) | (flags & MAP_SHARED)))
+        if (!(flags & MAP_PRIVATE) == !(flags & MAP_SHARED))
             mmap_ret_err(EINVAL)  // According to man page
         if ((Elf32_Addr)hint & (PAGE_SIZE - 1) || size & (PAGE_SIZE - 1) || offset & (PAGE_SIZE - 1))
             mmap_ret_err(EINVAL); // According to man page
 
-        // When memory mapped files will be implemented, don't forget to handle EACCES error or mprotect (cf man page)
-
-        // At that point we know that flags contain MAP_PRIVATE, so this case only is handled here for now
-        // Beware that changing code above may require adding more conditional logic below
+        if (prot == 0)
+            mmap_ret_err_with_warn(EINVAL, "mmap called with prot == 0. I don't know how to implement that, returning failure")
 
         // ReSharper disable once CppIdenticalOperandsInBinaryExpression
-        if (!((flags & MAP_ANONYMOUS) | (flags & MAP_ANON)))
+        const bool anonymous = (flags & MAP_ANONYMOUS) | (flags & MAP_ANON);
+        if (flags & MAP_SHARED)
+        {
+            if (process == kernel_process)
+                mmap_ret_err_with_warn(EINVAL, "mmap called with MAP_SHARED on the kernel process")
+            if (anonymous)
+                return mmap_shared(hint, size, prot, flags, 0, err, process, nullptr);
+
+            // Only shared memory objects can be mapped for now, files are read by the ELF loader only
+            const int sys_fd = process->proc_to_sys_fd(fd);
+            if (sys_fd == -1)
+                mmap_ret_err(EBADF)
+            const FileInterface* file = VFS::file_descriptors[sys_fd];
+            if (file->type != FileInterface::Shm)
+                mmap_ret_err_with_warn(ENODEV, "mmap called with MAP_SHARED on a file. This is not supported yet")
+            if (prot & PROT_WRITE && !(file->flags & O_RDWR))
+                mmap_ret_err(EACCES) // According to man page
+            return mmap_shared(hint, size, prot, flags, offset, err, process, ((const SharedMemoryFile*)file)->object);
+        }
+
+        // At that point we know that flags contain MAP_PRIVATE
+        if (!anonymous)
             mmap_ret_err_with_warn(EINVAL, "mmap called with MAP PRIVATE without MAP_ANONYMOUS or MAP_ANON. This is not"
                                "supported yet")
 
-        if (prot == 0)
-            mmap_ret_err_with_warn(EINVAL, "mmap called with prot == 0. I don't know how to implement that, returning failure")
-
         // At that point we know we have ANONYMOUS and MAP_PRIVATE
 
         // If hint is KERNEL_VIRTUAL_BASE, then there is obviously no free memory below kernel_process->lowest_free_pe << 12
@@ -592,45 +1004,55 @@ namespace Memory
 
     void* physically_aligned_malloc(uint n)
     {
-        uint page_beg = (uint)-1;
-        uint frame_beg = (uint)-1;
         uint num_pages = (n + PAGE_SIZE - 1) >> 12;
-        for (auto p = kernel_process->lowest_free_pe; p < PDT_ENTRIES * PT_ENTRIES; p++)
-        {
-            uint i;
-            for (i = 0; i < num_pages && !PTE_USED(page_tables, p + i); i++)
-            {
-            };
-            if (i == num_pages)
-            {
-                page_beg = p;
-                break;
-            }
-        }
+        uint frame_beg = BuddyAllocator::get_contiguous_frames(num_pages);
+        if (frame_beg == (uint)-1)
+            return nullptr;
+
+        uint page_beg = get_large_page_friendly_pages(num_pages, frame_beg);
         if (page_beg == (uint)-1)
             return nullptr;
 
-        for (auto p = lowest_free_frame; p < PDT_ENTRIES * PT_ENTRIES; p++)
+        for (uint i = 0; i < num_pages; ++i)
+            allocate_page(frame_beg + i, page_beg + i, DEFAULT_K_POLICY);
+        map_large_pages(page_beg, num_pages);
+
+        return (void*)(page_beg << 12);
+    }
+
+    void* large_page_malloc(uint n)
+    {
+        const uint num_pages = (n + PAGE_SIZE - 1) >> 12;
+        const uint page_beg = get_large_page_friendly_pages(num_pages, 0);
+        if (page_beg == (uint)-1 || num_pages > BuddyAllocator::get_num_free_frames())
+            return nullptr;
+
+        for (uint chunk = 0; chunk < num_pages; chunk += PT_ENTRIES)
         {
-            uint i;
-            for (i = 0; i < num_pages && !FRAME_USED(p + i); i++)
-            {
-            };
-            if (i == num_pages)
+            const uint chunk_pages = min(num_pages - chunk, (uint)PT_ENTRIES);
+
+            // Full chunks get a 4 MiB block if there is one left, fall back to scattered frames otherwise
+            const uint frame_beg = chunk_pages == PT_ENTRIES
+                                       ? BuddyAllocator::get_free_block(BuddyAllocator::MAX_ORDER)
+                                       : (uint)-1;
+            for (uint i = 0; i < chunk_pages; i++)
             {
-                frame_beg = p;
-                break;
+                const uint frame_id = frame_beg == (uint)-1 ? get_free_frame() : frame_beg + i;
+                allocate_page(frame_id, page_beg + chunk + i, DEFAULT_K_POLICY);
             }
         }
-        if (frame_beg == (uint)-1)
-            return nullptr;
-
-        for (uint i = 0; i < num_pages; ++i)
-            allocate_page(frame_beg + i, page_beg + i, DEFAULT_K_POLICY);
+        map_large_pages(page_beg, num_pages);
 
         return (void*)(page_beg << 12);
     }
 
+    void large_page_free(void* ptr, uint n)
+    {
+        const uint page_beg = ADDR_PAGE((uint)ptr);
+        for (uint i = 0; i < (n + PAGE_SIZE - 1) >> 12; i++)
+            free_page(page_beg + i);
+    }
+
     void handle_cow_page_fault(const Process* current_process, bool higher_half, uint page_id, const page_table_t* pt)
     {
         if (current_process->pdt == pdt)
@@ -639,37 +1061,57 @@ namespace Memory
             irrecoverable_error("COW on higher half");
 
         uint sys_pe = get_free_pe_user(); // Get sys PTE id
-        uint frame = get_free_frame(); // Get frame id
-        const uint current_policy = PTE(pt, page_id) & 0x7FF;
+        const uint current_policy = PTE(pt, page_id) & 0xFFF;
         const uint new_policy = (current_policy & ~PAGE_COW) | PAGE_WRITE;
+
+        // Page maps the zero frame, there is nothing to copy
+        if (PTE(pt, page_id) >> 12 == zero_frame)
+        {
+            bool zeroed;
+            uint frame = ZeroedFramePool::get_frame(zeroed);
+            allocate_page(frame, sys_pe, new_policy); // Allocate page in kernel address space
+            current_process->update_pte(page_id, FRAME_ID_ADDR(frame) | new_policy, true);
+            if (!zeroed)
+                memset((void*)(page_id << 12), 0, PAGE_SIZE);
+            return;
+        }
+
+        uint frame = get_free_frame(); // Get frame id
         allocate_page(frame, sys_pe, new_policy); // Allocate page in kernel address space
-        uint mapping_pe = get_contiguous_pages(1, DEFAULT_HINT_INFO, current_process); // Get a free pe
 
-        // Move old page to mapping page
-        current_process->update_pte(mapping_pe, PTE(pt, page_id), true);
+        // Copy the page through a temporary mapping of the new frame, the old one is still mapped at page_id
+        void* copy = Kmap::map(frame);
+        memcpy(copy, (void*)(page_id << 12), PAGE_SIZE);
+        Kmap::unmap(copy);
+
         // Update page table entry to point to new page
         current_process->update_pte(page_id, FRAME_ID_ADDR(frame) | new_policy, true);
 
-        // Copy page to new page
-        memcpy((void*)(page_id << 12), (void*)(mapping_pe << 12), PAGE_SIZE);
-
-        // Unmap old page which is now at mapping_pe
-        current_process->update_pte(mapping_pe, 0, true);
-
         // If the frame of the original page is not used anymore, free it
         if (frame_rc[frame] == 0)
             MARK_FRAME_FREE(frame);
     }
 
-    void handle_lazy_zero_page_fault(Process* current_process, bool higher_half, uint page_id, page_table_t* pt)
+    void handle_lazy_zero_read_fault(const Process* current_process, uint page_id, uint pte)
+    {
+        const uint share_policy = pte & PAGE_WRITE ? PAGE_COW : PAGE_SHRO;
+        current_process->update_pte(page_id, FRAME_ID_ADDR(zero_frame) | (pte & PAGE_USER) | share_policy | PAGE_PRESENT,
+                                    true);
+        zero_frame_faults++;
+    }
+
+    void map_lazy_page(Process* current_process, bool higher_half, uint page_id, page_table_t* pt, bool zero)
     {
         // Allocate frame and update memory mapping
         auto pte_ptr = &PTE(pt, page_id); // Get pointer to pte
         bool page_user = *pte_ptr & PAGE_USER; // Should page be user accessible ?
-        uint frame_id = get_free_frame(); // Get frame
-        *pte_ptr = FRAME_ID_ADDR(frame_id) | (page_user ? PAGE_USER : 0) | PAGE_WRITE | PAGE_PRESENT; // Update pte
-        INVALIDATE_PAGE(page_id >> 10, page_id & 0x3FF); // Invalidate cache
-        memset((void*)(page_id << 12), 0, PAGE_SIZE); // Zero out page
+        bool zeroed = false;
+        uint frame_id = zero ? ZeroedFramePool::get_frame(zeroed) : get_free_frame(); // Get frame
+        *pte_ptr = FRAME_ID_ADDR(frame_id) | (page_user ? PAGE_USER : 0) | PAGE_GLOBAL_IF_KERNEL(page_id) | PAGE_WRITE |
+            PAGE_PRESENT; // Update pte
+        TLB::invalidate_new_page(page_id); // Lazy entries are not present
+        if (zero && !zeroed)
+            memset((void*)(page_id << 12), 0, PAGE_SIZE); // Zero out page
 
         // If process is kernel process or address is in higher half, kernel global page tables have already
         // been updated, we just need to register the allocated frame
@@ -681,7 +1123,8 @@ namespace Memory
         {
             // Register allocation of the frame in kernel global page tables
             uint sys_page_id = get_free_pe();
-            PTE(page_tables, sys_page_id) = *pte_ptr;
+            PTE(page_tables, sys_page_id) = *pte_ptr | PAGE_GLOBAL;
+            VirtualPageAllocator::set_used(sys_page_id, true);
             MARK_FRAME_USED(frame_id, sys_page_id);
         }
         // If the process is not the kernel, then the page is referenced by the kernel AND the process, thus we need
@@ -689,16 +1132,153 @@ namespace Memory
         // Normally this is done in Process::update_pte, but here we are not using it, this could be changed. Mind
         // that this would then trigger an error in MARK_FRAME_USED since we would be trying to allocate a frame
         // which has a non-null ref count.
-        if (current_process->pdt != pdt)
+        if (current_process->pdt != pdt && !higher_half)
             frame_rc[frame_id]++;
     }
 
+    void handle_lazy_zero_page_fault(Process* current_process, bool higher_half, uint page_id, page_table_t* pt)
+    {
+        map_lazy_page(current_process, higher_half, page_id, pt, true);
+    }
+
+    void fault_around(Process* current_process, uint page_id)
+    {
+        // Window is aligned and at most PT_ENTRIES wide, so it lies in the (present) page table of the faulting page
+        static_assert(FAULT_AROUND_N_PAGES && FAULT_AROUND_N_PAGES <= PT_ENTRIES &&
+                      !(FAULT_AROUND_N_PAGES & (FAULT_AROUND_N_PAGES - 1)), "FAULT_AROUND_N_PAGES must be a power of 2");
+        if (BuddyAllocator::get_num_free_frames() < FAULT_AROUND_N_PAGES) // Do not make memory pressure worse
+            return;
+
+        // Only fill the allocation that faulted, neighbouring ones may never be touched
+        const allocation* alloc = current_process->memtree.find_allocation_containing(page_id << 12);
+        if (!alloc)
+            return;
+
+        page_table_t* pt = current_process->page_tables;
+        const uint window_start = max(page_id & ~(FAULT_AROUND_N_PAGES - 1), ADDR_PAGE(alloc->start));
+        const uint window_end = min((page_id | (FAULT_AROUND_N_PAGES - 1)) + 1, ADDR_PAGE(alloc->end + PAGE_SIZE - 1));
+        for (uint id = window_start; id < window_end; id++)
+        {
+            // File-backed pages have their own readahead, shared ones belong to their object
+            if ((PTE(pt, id) & (PAGE_LAZY_ZERO | PAGE_FILE | PAGE_SHARED)) != PAGE_LAZY_ZERO)
+                continue;
+            handle_lazy_zero_page_fault(current_process, false, id, pt);
+            fault_around_pages++;
+        }
+    }
+
+    bool handle_file_page_fault(Process* current_process, uint page_id, bool write_access)
+    {
+        const uintptr_t address = page_id << 12;
+        const file_mapping* mapping = nullptr;
+        for (const auto& m : current_process->file_mappings)
+        {
+            if (address >= m.start && address < m.end)
+            {
+                mapping = &m;
+                break;
+            }
+        }
+        if (!mapping)
+            irrecoverable_error("%s: file-backed page 0x%x is not part of any file mapping", __func__, address);
+
+        page_table_t* pt = current_process->page_tables;
+        if (write_access && !(PTE(pt, page_id) & PAGE_WRITE))
+            return false; // Program text is read-only
+
+        // Gather the file-backed pages surrounding the faulting one, unless memory is short
+        const auto is_file_page = [pt](uint id)
+        {
+            return (PTE(pt, id) & (PAGE_LAZY_ZERO | PAGE_FILE)) == (PAGE_LAZY_ZERO | PAGE_FILE);
+        };
+        static_assert(FILE_READAHEAD_N_PAGES && FILE_READAHEAD_N_PAGES <= PT_ENTRIES &&
+                      !(FILE_READAHEAD_N_PAGES & (FILE_READAHEAD_N_PAGES - 1)),
+                      "FILE_READAHEAD_N_PAGES must be a power of 2");
+        const uint window_start = max(page_id & ~(FILE_READAHEAD_N_PAGES - 1), ADDR_PAGE(mapping->start));
+        const uint window_end = min((page_id | (FILE_READAHEAD_N_PAGES - 1)) + 1, ADDR_PAGE(mapping->end));
+        uint first = page_id, last = page_id + 1;
+        if (BuddyAllocator::get_num_free_frames() >= FILE_READAHEAD_N_PAGES)
+        {
+            for (; first > window_start && is_file_page(first - 1); first--) {}
+            for (; last < window_end && is_file_page(last); last++) {}
+        }
+
+        // Whole pages of the file that are only read come from the page cache, and are shared with every process
+        // mapping them. Writable ones are mapped COW, and only get copied if they are actually written to
+        if (!write_access && !(mapping->offset & (PAGE_SIZE - 1)) &&
+            (page_id << 12) - mapping->start + PAGE_SIZE <= mapping->file_size)
+        {
+            last = min(last, ADDR_PAGE(mapping->start + mapping->file_size));
+            const uint file_page = ADDR_PAGE(mapping->offset) + first - ADDR_PAGE(mapping->start);
+            if (!PageCache::map(current_process, first, mapping->file, file_page, last - first))
+            {
+                printf_error("%s: cannot read file-backed page 0x%x", __func__, address);
+                return false;
+            }
+            file_page_faults++;
+
+            return true;
+        }
+
+        // Map the pages writable to fill them, their own write permission is restored afterward
+        uint policies[FILE_READAHEAD_N_PAGES];
+        for (uint id = first; id < last; id++)
+        {
+            policies[id - first] = PTE(pt, id);
+            map_lazy_page(current_process, false, id, pt, false);
+        }
+
+        // Read what comes from the file, zero the rest (end of the last page of a data segment, bss)
+        const uint run_offset = (first << 12) - mapping->start;
+        const uint run_size = (last - first) * PAGE_SIZE;
+        const uint file_bytes = run_offset < mapping->file_size ? min(run_size, mapping->file_size - run_offset) : 0;
+        const auto run = (char*)(first << 12);
+        if (file_bytes && File::read_at(mapping->file, run, mapping->offset + run_offset, file_bytes) != (int)file_bytes)
+        {
+            printf_error("%s: cannot read file-backed page 0x%x", __func__, address);
+            return false;
+        }
+        memset(run + file_bytes, 0, run_size - file_bytes);
+
+        for (uint id = first; id < last; id++)
+            if (!(policies[id - first] & PAGE_WRITE))
+                PTE(pt, id) &= ~PAGE_WRITE;
+        TLB::invalidate_range(first, last - first);
+
+        file_page_faults++;
+        file_pages_read += last - first;
+
+        return true;
+    }
+
+    bool handle_shared_page_fault(const Process* current_process, uint page_id, bool write_access)
+    {
+        const shared_mapping* mapping = shared_mapping::find(current_process, page_id << 12);
+        if (!mapping)
+            return false; // Mapping has been removed, the page is left over
+
+        if (write_access && !(PTE(current_process->page_tables, page_id) & PAGE_WRITE))
+            return false; // Read-only mapping
+
+        // Fails past the end of the object, or if memory is full
+        const uint index = ADDR_PAGE(mapping->offset + (page_id << 12) - mapping->start);
+        if (!mapping->object->map_page(current_process, page_id, index))
+            return false;
+        shared_page_faults++;
+
+        return true;
+    }
+
     bool page_fault_handler(Process* current_process, uint fault_address, bool write_access)
     {
+        current_process->num_page_faults++;
+
         // Gather information
         const uint page_id = ADDR_PAGE(fault_address);
         const bool higher_half = fault_address >= KERNEL_VIRTUAL_BASE;
         page_table_t* pt = higher_half ? page_tables : current_process->page_tables;
+        if (!page_table_present(pt, ADDR_PDE(fault_address))) // Nothing is mapped there
+            return false;
         const uint pte = PTE(pt, page_id);
 
         bool handled = false;
@@ -716,7 +1296,23 @@ namespace Memory
         if (!(pte && pte & PAGE_LAZY_ZERO))
             return handled;
 
-        handle_lazy_zero_page_fault(current_process, higher_half, page_id, pt);
+        // Program pages come from their file
+        if (pte & PAGE_FILE)
+            return !higher_half && handle_file_page_fault(current_process, page_id, write_access);
+
+        // Shared pages come from the memory object they map
+        if (pte & PAGE_SHARED)
+            return !higher_half && handle_shared_page_fault(current_process, page_id, write_access);
+
+        // Reading user memory that has never been written to does not need a frame of its own
+        if (!write_access && !higher_half && current_process->pdt != pdt)
+            handle_lazy_zero_read_fault(current_process, page_id, pte);
+        else
+        {
+            handle_lazy_zero_page_fault(current_process, higher_half, page_id, pt);
+            if (!higher_half && current_process->pdt != pdt)
+                fault_around(current_process, page_id);
+        }
 
         return true;
     }
@@ -739,34 +1335,13 @@ namespace Memory
         // to map the whole memory block
         if (no_frame_used)
         {
-            uint b = kernel_process->lowest_free_pe; /* block beginning page index */
-
-            // Try to find contiguous free virtual block of memory
-            while (true)
-            {
-                // Maximum possibly free memory is too small to fulfill request
-                if (b + n_pages > PDT_ENTRIES * PT_ENTRIES)
-                    return nullptr;
-
-                uint pte = b;
-                uint target = b + n_pages;
-
-                // Explore contiguous free blocks while explored block size does not fulfill the request
-                for (; !(PTE_USED(kernel_process->page_tables, pte)) && pte != target; pte++)
-                {
-                }
-
-                // We have explored a free block that is big enough
-                if (pte == target)
-                    break;
-
-                // There is a free virtual memory block from b to pte - 1 that is too small. Page entry pte - 1 is present.
-                // Then next possibly free page entry is the (pte)th
-                b = pte + 1;
-            }
+            const uint b = get_large_page_friendly_pages(n_pages, frame_base);
+            if (b == (uint)-1)
+                return nullptr;
 
             for (uint i = 0; i < n_pages; i++)
                 allocate_page(frame_base + i, b + i, DEFAULT_K_POLICY);
+            map_large_pages(b, n_pages);
 
             return (void*)((b << 12) + (physical_address & (PAGE_SIZE - 1)));
         }
@@ -815,14 +1390,20 @@ void operator delete(void*, void*)
 {
 }
 
+/** Allocates kernel memory, small blocks going to their size class */
+static void* kernel_malloc(uint n)
+{
+    return n && n <= Kmalloc::MAX_SIZE ? Kmalloc::alloc(n) : malloc(n, DEFAULT_K_PAGE_INFO, kernel_process);
+}
+
 void* operator new(size_t size)
 {
-    return malloc(size, DEFAULT_K_PAGE_INFO, kernel_process);
+    return kernel_malloc(size);
 }
 
 void* operator new[](size_t size)
 {
-    return malloc(size, DEFAULT_K_PAGE_INFO, kernel_process);
+    return kernel_malloc(size);
 }
 
 void operator delete(void* p)
@@ -866,7 +1447,7 @@ void* malloc(uint n, const page_info& page_info, Process* process)
 
 extern "C" void* malloc(uint n)
 {
-    void* addr = malloc(n, DEFAULT_K_PAGE_INFO, kernel_process);
+    void* addr = kernel_malloc(n);
     if (!addr)
         printf_warn("malloc returned null");
 
@@ -899,11 +1480,23 @@ void* calloc(size_t nmemb, size_t size, const page_info& page_info, Process* pro
 
 extern "C" void* calloc(size_t nmemb, size_t size)
 {
+    size_t total_size;
+    if (nmemb && size && !__builtin_mul_overflow(nmemb, size, &total_size) && total_size <= Kmalloc::MAX_SIZE)
+    {
+        void* mem = Kmalloc::alloc(total_size);
+        if (mem)
+            memset(mem, 0, total_size);
+        return mem;
+    }
+
     return calloc(nmemb, size, DEFAULT_K_PAGE_INFO, kernel_process);
 }
 
 MemTree::FreeState free(void* ptr, Process* process)
 {
+    if (process == kernel_process && Kmalloc::free(ptr))
+        return MemTree::FreeState::OK;
+
     MemTree& mem_tree = process->memtree;
     const auto free_state = mem_tree.free(reinterpret_cast<uintptr_t>(ptr), process);
 
@@ -937,6 +1530,24 @@ MemTree::ReallocState realloc(void* ptr, size_t size, Process* process, void*& n
 
 void* realloc(void* ptr, size_t size)
 {
+    // Blocks allocated by object caches cannot grow in place, move them if they do not fit in their slot anymore
+    if (const uint slot_size = Kmalloc::size_of(ptr))
+    {
+        if (!size) // realloc with size 0 = free
+        {
+            Kmalloc::free(ptr);
+            return nullptr;
+        }
+        if (size <= slot_size)
+            return ptr;
+        void* new_address = malloc(size);
+        if (!new_address)
+            irrecoverable_error("realloc failed");
+        memcpy(new_address, ptr, slot_size);
+        Kmalloc::free(ptr);
+        return new_address;
+    }
+
     void* new_address;
     // ReSharper disable once CppDFAMemoryLeak
     if (realloc(ptr, size, kernel_process, new_address) != MemTree::ReallocState::OK)
@@ -23,6 +23,14 @@ namespace Memory
 	/** Reload cr3 which will acknowledge every pte change and invalidate TLB */
 	extern "C" void reload_cr3_asm();
 
+	extern "C" void enable_pse_asm();
+
+	/** Enable global pages (CR4.PGE) */
+	extern "C" void enable_pge_asm();
+
+	/** Invalidate the whole TLB, global pages included, by toggling CR4.PGE */
+	extern "C" void flush_global_tlb_asm();
+
 	/** Initialize memory, by referencing free pages, allocating pages to store 1024 pages tables
 	 *
 	 * @param minfo Multiboot info structure
@@ -42,6 +50,14 @@ namespace Memory
 
 	void* calloca(size_t nmemb, size_t size);
 
+	/**
+	 * Reserves kernel virtual space for the page tables of a user address space (PDEs 0 to 767).
+	 * No frame is allocated here: a page table only gets one the first time one of its entries is written, and the
+	 * corresponding PDE has to be installed at that point (cf. Process::update_pte)
+	 * @return page tables, to be released with freea. nullptr on failure
+	 */
+	page_table_t* allocate_user_page_tables();
+
 	/**
 	 * Allocates memory which is both virtually and physically contiguous.
 	 * Does not go through the classical malloc process, thus the resulting pointer cannot be given to free.
@@ -51,6 +67,21 @@ namespace Memory
 	 */
 	void* physically_aligned_malloc(uint n);
 
+	/**
+	 * Allocates a big kernel buffer mapped with 4 MiB pages as much as possible, to spare TLB entries.
+	 * Each 4 MiB chunk is physically contiguous when memory allows it, the remainder is mapped with regular pages.
+	 * @param n Size of memory block to allocate
+	 * @return Pointer to beginning of memory block, 4 MiB aligned. nullptr on failure
+	 */
+	void* large_page_malloc(uint n);
+
+	/**
+	 * Frees a buffer allocated with large_page_malloc
+	 * @param ptr buffer
+	 * @param n size given to large_page_malloc
+	 */
+	void large_page_free(void* ptr, uint n);
+
 	/**
 	 * Free page-aligned memory
 	 *
@@ -63,8 +94,10 @@ namespace Memory
 	 * @param address address to free
 	 * @param process process to get the relevant address space from to correctly interpret the address, nullptr
 	 * if kernel
+	 * @param update_cache whether to invalidate the page, user pages only. Callers freeing a range of pages may
+	 * invalidate it at once afterward instead
 	 */
-	void free_page(uint address, const Process* process);
+	void free_page(uint address, const Process* process, bool update_cache = true);
 
 	/** Get index of lowest free page entry id in lower half and update lowest_free_pe_user to next free page id */
 	uint get_free_pe_user();
@@ -106,6 +139,54 @@ namespace Memory
 
 	int mprotect(void* addr, size_t len, int prot, const Process* process);
 
+	/**
+	 * Unmaps a range of a process address space. Allocations partially covered by the range are split, and the frames
+	 * of the range are released
+	 * @return 0 on success, -errno on error
+	 */
+	int munmap(void* addr, size_t len, Process* process);
+
+	/**
+	 * Gives advice about the use of a range of a process address space. Only MADV_DONTNEED is acted upon: frames of the
+	 * range are released, but the range stays mapped, and reads as zeroes (or as its file content) again
+	 * @return 0 on success, -errno on error
+	 */
+	int madvise(void* addr, size_t len, int advice, const Process* process);
+
+	/** Memory statistics. Values must match libk's mem_stat */
+	enum class MemStat
+	{
+		ZERO_FRAME_MAPPINGS, // Pages currently mapping the zero frame, ie frames saved by the zero frame
+		ZERO_FRAME_FAULTS, // Read faults on lazily zeroed pages that have been handled with the zero frame
+		ZEROED_POOL_FRAMES, // Frames currently in the pre-zeroed frame pool
+		ZEROED_POOL_HITS, // Frame requests served with a pre-zeroed frame
+		ZEROED_POOL_MISSES, // Frame requests that had to zero a frame synchronously
+		FAULT_AROUND_PAGES, // Pages allocated by fault-around, ie page faults saved
+		PROCESS_PAGE_FAULTS, // Page faults taken by the process
+		KMALLOC_ALLOCATIONS, // Blocks allocated by size classes since boot
+		KMALLOC_REQUESTED_BYTES, // Bytes asked for by size class allocations since boot
+		KMALLOC_ALLOCATED_BYTES, // Bytes handed out by size class allocations since boot, rounding included
+		FILE_PAGE_FAULTS, // Faults on file-backed pages, each of them reading a readahead window
+		FILE_PAGES_READ, // File-backed pages read from their file since boot
+		PAGE_CACHE_PAGES, // File pages currently in the page cache
+		PAGE_CACHE_HITS, // File pages mapped from the page cache without reading them, ie reads and frames saved
+		ELF_IMAGE_CACHE_HITS, // ELF files loaded from their cached image, without reading nor parsing them
+		ELF_IMAGE_CACHE_MISSES, // ELF files that had to be read and parsed
+		KMAP_HITS, // Temporary mappings served by a slot still mapping the frame
+		KMAP_FLUSHES, // Reclaims of the temporary mapping slots, each of them a single TLB invalidation
+		PROCESS_RESIDENT_PAGES, // Pages of the process backed by a frame, shared ones included
+		SHARED_MEMORY_PAGES, // Frames currently held by shared memory objects
+		SHARED_PAGE_FAULTS, // Faults on pages mapping a shared memory object, each of them mapping its frame
+		COUNT
+	};
+
+	/**
+	 * Gets the current value of a memory statistic
+	 * @param stat statistic to get
+	 * @param process process to get process specific statistics of
+	 */
+	uint get_mem_stat(MemStat stat, const Process* process);
+
 	/** Tries to allocate a contiguous block of memory
 	 * @param num_pages_requested Size of the block in bytes
 	 * @param page_info page information
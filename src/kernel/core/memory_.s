@@ -5,6 +5,32 @@ reload_cr3_asm:
     mov cr3,ecx
     ret
 
+; Enable 4 MiB pages (CR4.PSE)
+global enable_pse_asm
+enable_pse_asm:
+    mov ecx, cr4
+    or ecx, 0x10
+    mov cr4, ecx
+    ret
+
+; Enable global pages (CR4.PGE)
+global enable_pge_asm
+enable_pge_asm:
+    mov ecx, cr4
+    or ecx, 0x80
+    mov cr4, ecx
+    ret
+
+; Invalidate the whole TLB, global pages included. Any write to CR4 that changes PGE flushes every entry.
+global flush_global_tlb_asm
+flush_global_tlb_asm:
+    mov ecx, cr4
+    mov eax, ecx
+    and eax, ~0x80
+    mov cr4, eax
+    mov cr4, ecx
+    ret
+
 ; Set a new pdt
 ; [esp + 0] call function ret addr
 ; [esp + 4] new pdt physical address
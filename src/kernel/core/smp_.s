@@ -0,0 +1,66 @@
+; Application processors startup code. It is copied at TRAMPOLINE_ADDR, where processors start executing in real mode
+; upon a startup IPI. It switches to protected mode, enables paging and calls the entry point on the stack found in the
+; parameters, which the bootstrap processor fills before starting each processor.
+TRAMPOLINE_ADDR equ 0x8000 ; Must match AP_TRAMPOLINE_ADDR (SMP.h)
+
+; Address of a trampoline label once copied at TRAMPOLINE_ADDR
+%define TRAMPOLINE_REL(label) (TRAMPOLINE_ADDR + ((label) - ap_trampoline_start_))
+
+section .text
+bits 16
+global ap_trampoline_start_
+ap_trampoline_start_:
+    cli
+    cld
+    xor ax, ax
+    mov ds, ax
+    o32 lgdt [TRAMPOLINE_REL(trampoline_gdt_descriptor)]
+
+    mov eax, cr0
+    and eax, 0x9FFFFFFF ; Enable caches, processors come out of INIT with CD and NW set
+    or eax, 1 ; Protected mode
+    mov cr0, eax
+    jmp dword 0x08:TRAMPOLINE_REL(trampoline_protected_mode)
+
+bits 32
+trampoline_protected_mode:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+
+    ; Same paging features as the bootstrap processor (4 MiB pages, global pages)
+    mov eax, [TRAMPOLINE_REL(ap_trampoline_params_) + 4]
+    mov cr4, eax
+    mov eax, [TRAMPOLINE_REL(ap_trampoline_params_)]
+    mov cr3, eax
+    mov eax, cr0
+    or eax, 0x80010000 ; Paging and write protection
+    mov cr0, eax
+
+    mov esp, [TRAMPOLINE_REL(ap_trampoline_params_) + 8]
+    mov eax, [TRAMPOLINE_REL(ap_trampoline_params_) + 12]
+    call eax ; Does not return
+
+align 8
+trampoline_gdt:
+    dq 0                  ; Null segment
+    dq 0x00CF9A000000FFFF ; Kernel code segment, flat
+    dq 0x00CF92000000FFFF ; Kernel data segment, flat
+trampoline_gdt_descriptor:
+    dw trampoline_gdt_descriptor - trampoline_gdt - 1
+    dd TRAMPOLINE_REL(trampoline_gdt)
+
+; Filled by the bootstrap processor, cf. SMP::ap_trampoline_params
+align 4
+global ap_trampoline_params_
+ap_trampoline_params_:
+    dd 0 ; cr3
+    dd 0 ; cr4
+    dd 0 ; stack top
+    dd 0 ; entry point
+
+global ap_trampoline_end_
+ap_trampoline_end_:
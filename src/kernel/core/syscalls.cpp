@@ -3,9 +3,11 @@
 #include "../processes/scheduler.h"
 #include "system.h"
 #include "PIC.h"
+#include "PIT.h"
 #include "../file_management/VFS.h"
 #include "fb.h"
 #include "GDT.h"
+#include "keyboard.h"
 #include "stdarg.h"
 #include "../file_management/superblock.h"
 #include "../network/HTTP.h"
@@ -58,9 +60,7 @@ void Syscall::realloc(Process* p)
 __attribute__((no_instrument_function)) // May not return, which would mess up profiling data
 void Syscall::get_key()
 {
-    Scheduler::get_running_process()->set_flag(P_WAITING_KEY);
-
-    TRIGGER_TIMER_INTERRUPT
+    Keyboard::wait_queue.wait();
 }
 
 [[noreturn]]
@@ -224,6 +224,39 @@ void Syscall::dispatcher(const cpu_state_t* cpu_state, const stack_state_t* stac
         case 50:
             GDB::get_instance()->unload_elf((const char*)p->cpu_state.edx);
             break;
+        case 51:
+            p->cpu_state.eax = buddyinfo(p);
+            break;
+        case 52:
+            p->cpu_state.eax = memstats(p);
+            break;
+        case 53:
+            p->cpu_state.eax = slabinfo(p);
+            break;
+        case 54:
+            p->cpu_state.eax = munmap(p);
+            break;
+        case 55:
+            p->cpu_state.eax = madvise(p);
+            break;
+        case 56:
+            p->cpu_state.eax = ftruncate(p);
+            break;
+        case 57:
+            p->cpu_state.eax = unlink(p);
+            break;
+        case 58:
+            p->cpu_state.eax = setpriority(p);
+            break;
+        case 59:
+            p->cpu_state.eax = getpriority(p);
+            break;
+        case 60:
+            p->cpu_state.eax = sleep(p);
+            break;
+        case 61:
+            p->cpu_state.eax = timer_interrupts();
+            break;
     	case 400: // dbg
     		FB::flush();
             printf_info("%d | 0x%x", p->cpu_state.edi, p->cpu_state.edi);
@@ -233,6 +266,10 @@ void Syscall::dispatcher(const cpu_state_t* cpu_state, const stack_state_t* stac
             break;
     }
 
+    // The syscall may have woken up a process more favoured than this one
+    if (Scheduler::should_preempt())
+        TRIGGER_TIMER_INTERRUPT
+
     Scheduler::resume_user_process(p);
 }
 
@@ -521,6 +558,58 @@ int Syscall::mprotect(Process* p)
 	return Memory::mprotect(addr, len, prot, p);
 }
 
+int Syscall::munmap(Process* p)
+{
+	void* addr = (void*)p->cpu_state.ebx;
+	size_t len = p->cpu_state.ecx;
+
+	return Memory::munmap(addr, len, p);
+}
+
+int Syscall::madvise(Process* p)
+{
+	void* addr = (void*)p->cpu_state.ebx;
+	size_t len = p->cpu_state.ecx;
+	int advice = (int)p->cpu_state.edx;
+
+	return Memory::madvise(addr, len, advice, p);
+}
+
+int Syscall::ftruncate(const Process* p)
+{
+	int fd = (int)p->cpu_state.ebx;
+	uint length = p->cpu_state.ecx;
+
+	return p->ftruncate(fd, length);
+}
+
+int Syscall::unlink(const Process* p)
+{
+	auto pathname = (const char*)p->cpu_state.ebx;
+
+	return VFS::unlink(pathname);
+}
+
+int Syscall::setpriority(const Process* p)
+{
+    const auto pid = (pid_t)p->cpu_state.ebx;
+    const auto nice = (int)p->cpu_state.ecx;
+
+    return Scheduler::set_nice(pid, nice);
+}
+
+int Syscall::getpriority(const Process* p)
+{
+    const auto pid = (pid_t)p->cpu_state.ebx;
+
+    int nice;
+    if (const int err = Scheduler::get_nice(pid, &nice); err)
+        return err;
+
+    // Offset so that nice values cannot be mistaken for errors, as Linux does
+    return 20 - nice;
+}
+
 int Syscall::execve(Process* p, bool use_path_if_no_heading_slash)
 {
     const auto path = (char*)p->cpu_state.ebx;
@@ -549,3 +638,51 @@ int Syscall::wait_pid(Process* p)
 
     return (int)p->cpu_state.eax; // Return value is written here by Scheduler
 }
+
+uint Syscall::buddyinfo(const Process* p)
+{
+    auto counts = (uint*)p->cpu_state.edi;
+    uint n = min(p->cpu_state.esi, Memory::BuddyAllocator::MAX_ORDER + 1);
+
+    for (uint order = 0; order < n; order++)
+        counts[order] = Memory::BuddyAllocator::get_num_free_blocks(order);
+
+    return n;
+}
+
+uint Syscall::memstats(const Process* p)
+{
+    auto stats = (uint*)p->cpu_state.edi;
+    uint n = min(p->cpu_state.esi, (uint)Memory::MemStat::COUNT);
+
+    for (uint i = 0; i < n; i++)
+        stats[i] = Memory::get_mem_stat((Memory::MemStat)i, p);
+
+    return n;
+}
+
+__attribute__((no_instrument_function)) // May not return, which would mess up profiling data
+int Syscall::sleep(Process* p)
+{
+    // Never busy wait, even for less than a clock tick: one-shot timers wake the process up at the right time
+    Scheduler::set_process_asleep(p, p->cpu_state.ebx);
+    TRIGGER_TIMER_INTERRUPT
+
+    return 0;
+}
+
+uint Syscall::timer_interrupts()
+{
+    return Interrupts::timer_interrupts;
+}
+
+uint Syscall::slabinfo(const Process* p)
+{
+    auto infos = (Memory::KmemCache::info*)p->cpu_state.edi;
+    uint n = min(p->cpu_state.esi, Memory::KmemCache::get_num_caches());
+
+    for (uint i = 0; i < n; i++)
+        infos[i] = Memory::KmemCache::get_cache(i)->get_info();
+
+    return n;
+}
@@ -123,7 +123,113 @@ class Syscall
 
 	static int mprotect(Process* p);
 
+	/**
+	 * Unmaps a range of the process address space
+	 * EBX = start of the range, page aligned
+	 * ECX = length of the range
+	 *
+	 * Returns:
+	 * EAX = 0 on success, -errno on error
+	 */
+	static int munmap(Process* p);
+
+	/**
+	 * Gives advice about the use of a range of the process address space. MADV_DONTNEED releases its frames
+	 * EBX = start of the range, page aligned
+	 * ECX = length of the range
+	 * EDX = advice
+	 *
+	 * Returns:
+	 * EAX = 0 on success, -errno on error
+	 */
+	static int madvise(Process* p);
+
+	/**
+	 * Truncates or extends a file or a shared memory object
+	 * EBX = file descriptor, open for writing
+	 * ECX = new length
+	 *
+	 * Returns:
+	 * EAX = 0 on success, -errno on error
+	 */
+	static int ftruncate(const Process* p);
+
+	/**
+	 * Removes a name from the file system. Only shared memory object names (shm_unlink) can be removed for now
+	 * EBX = absolute path of the name
+	 *
+	 * Returns:
+	 * EAX = 0 on success, -errno on error
+	 */
+	static int unlink(const Process* p);
+
+	/**
+	 * Sets the nice value of a process, which sets the scheduling level it starts from
+	 * EBX = PID, 0 for the calling process
+	 * ECX = nice value, clamped to [-20, 19]
+	 *
+	 * Returns:
+	 * EAX = 0 on success, -errno on error
+	 */
+	static int setpriority(const Process* p);
+
+	/**
+	 * Gets the nice value of a process
+	 * EBX = PID, 0 for the calling process
+	 *
+	 * Returns:
+	 * EAX = 20 - nice value (from 1 to 40) on success, -errno on error
+	 */
+	static int getpriority(const Process* p);
+
 	static int execve(Process* p, bool use_path_if_no_heading_slash);
+
+	/**
+	 * Gets the number of free physical blocks of each order
+	 * EDI = buffer to write counts in
+	 * ESI = number of entries in buffer
+	 *
+	 * Returns:
+	 * EAX = number of entries written
+	 */
+	static uint buddyinfo(const Process* p);
+
+	/**
+	 * Gets memory statistics (cf Memory::MemStat)
+	 * EDI = buffer to write statistics in
+	 * ESI = number of entries in buffer
+	 *
+	 * Returns:
+	 * EAX = number of entries written
+	 */
+	static uint memstats(const Process* p);
+
+	/**
+	 * Gets information about kernel object caches (cf Memory::KmemCache::info)
+	 * EDI = buffer to write cache information in
+	 * ESI = number of entries in buffer
+	 *
+	 * Returns:
+	 * EAX = number of entries written
+	 */
+	static uint slabinfo(const Process* p);
+
+	/**
+	 * Suspends the calling process
+	 * EBX = duration in milliseconds
+	 *
+	 * Returns:
+	 * EAX = 0
+	 */
+	static int sleep(Process* p);
+
+	/**
+	 * Gets the number of timer interrupts taken by all processors since boot
+	 *
+	 * Returns:
+	 * EAX = number of timer interrupts
+	 */
+	static uint timer_interrupts();
 public:
 	/**
 	 * Handles a syscall
@@ -6,6 +6,7 @@
 #include "dentry.h"
 #include "../core/fb.h"
 #include "../core/memory.h"
+#include "../core/PageCache.h"
 #include "../utils/comparison.h"
 #include "../utils/TmpString.h"
 
@@ -625,6 +626,8 @@ bool FAT_drive::write_buf_to_file(SharedPointer<Dentry>& dentry, const void* buf
 {
     if (dentry->inode->type != Inode::File)
         ERR_RET_FALSE("Trying to write data on something which is not a file")
+    Memory::PageCache::invalidate(dentry); // Cached pages would be stale
+    dentry->inode->version++;
     // Resize file if necessary
     if (dentry->inode->size != length)
         if (!resize(dentry, length))
@@ -668,6 +671,8 @@ bool FAT_drive::write_buf_to_file(SharedPointer<Dentry>& dentry, const void* buf
 
 bool FAT_drive::resize(SharedPointer<Dentry>& dentry, uint new_size)
 {
+    Memory::PageCache::invalidate(dentry); // Cached pages would be stale
+    dentry->inode->version++;
     ctx ctx{};
 
     uint entry_id;
@@ -19,20 +19,29 @@ File::File(int fd, int flags, uint offset, const SharedPointer<Dentry>& dentry)
 
 int File::read(void* buf, uint count)
 {
-    auto l = min(count, dentry->inode->size - offset);
-    uint loaded_bytes;
+    const int loaded_bytes = read_at(dentry, buf, offset, count);
+    if (loaded_bytes < 0)
+        return loaded_bytes;
+
+    offset += loaded_bytes;
 
+    return loaded_bytes;
+}
+
+int File::read_at(const SharedPointer<Dentry>& dentry, void* buf, uint offset, uint count)
+{
     if (dentry->inode->type != Inode::File)
         return -EINVAL; // Not a regular file
 
-    if (preload_read(buf, offset, count, dentry))
-        loaded_bytes = count;
+    auto l = offset < dentry->inode->size ? min(count, dentry->inode->size - offset) : 0;
+    uint loaded_bytes;
+
+    if (preload_read(buf, offset, l, dentry))
+        loaded_bytes = l;
     else if (!dentry->inode->superblock->get_fs()->load_file_to_buf(buf, dentry->name, dentry->parent, offset, l,
                                                                         loaded_bytes))
         return -EIO; // IO error
 
-    offset += loaded_bytes;
-
     return (int)loaded_bytes;
 }
 
@@ -326,3 +335,57 @@ void Pipe::create_pipe(int rfd, int wrd, int flags, Pipe* pipes[])
     pipes[0] = rp;
     pipes[1] = wp;
 }
+
+SharedMemoryFile::SharedMemoryFile(int fd, int flags, const SharedPointer<Memory::SharedMemory>& object) :
+    FileInterface(fd, flags, 0, FileType::Shm), object(object)
+{
+}
+
+int SharedMemoryFile::read([[maybe_unused]] void* buf, [[maybe_unused]] uint count)
+{
+    return -EINVAL; // Content is accessed by mapping the object
+}
+
+int SharedMemoryFile::lseek([[maybe_unused]] int offset, [[maybe_unused]] int whence)
+{
+    return -EINVAL; // Content is accessed by mapping the object
+}
+
+int SharedMemoryFile::write([[maybe_unused]] void* buf, [[maybe_unused]] uint count)
+{
+    return -EINVAL; // Content is accessed by mapping the object
+}
+
+int SharedMemoryFile::fstat(struct stat* statbuf)
+{
+    statbuf->st_dev = SHM_DEV;
+    statbuf->st_ino = -1; // Shared memory objects do not have an inode
+    statbuf->st_mode = S_IFREG | 0b110110110; // Regular file, read-writable by anybody
+    statbuf->st_nlink = 1;
+    statbuf->st_uid = 0;
+    statbuf->st_gid = 0;
+    statbuf->st_rdev = 0;
+    statbuf->st_size = (off_t)object->get_size();
+    statbuf->st_blksize = PAGE_SIZE;
+    statbuf->st_blocks = (object->get_size() + 511) / 512;
+    statbuf->st_atime = 0;
+    statbuf->st_mtime = 0;
+    statbuf->st_ctime = 0;
+
+    return 0;
+}
+
+bool SharedMemoryFile::should_wait_for_data_on_read() const
+{
+    return false;
+}
+
+int SharedMemoryFile::get_write_fd() const
+{
+    return -1;
+}
+
+int SharedMemoryFile::get_read_fd() const
+{
+    return -1;
+}
@@ -4,7 +4,9 @@
 #include "kstddef.h"
 #include "../utils/shared_pointer.h"
 #include "../core/memory.h"
+#include "../core/SharedMemory.h"
 #include "../utils/circular_buffer.h"
+#include "../processes/WaitQueue.h"
 
 #define SEEK_SET 0
 #define SEEK_CUR 1
@@ -19,12 +21,14 @@ public:
     int flags;
     uint offset;
     int rc = 0;
+    WaitQueue read_wait_queue{}; // Processes waiting for data to read
 
     enum FileType
     {
         File,
         Pipe,
-        TTY
+        TTY,
+        Shm
     };
     FileType type;
 
@@ -58,6 +62,17 @@ class File : public FileInterface
     static bool preload_read(void* buf, uint offset, uint count, const SharedPointer<Dentry>& dentry);
 public:
     File(int fd, int flags, uint offset, const SharedPointer<Dentry>& dentry);
+
+    /**
+     * Reads part of a file without opening it, using preloaded data when possible
+     * @param dentry file dentry
+     * @param buf output buffer
+     * @param offset read offset
+     * @param count num bytes to read
+     * @return number of bytes read, -EINVAL if not a regular file, -EIO on IO error
+     */
+    static int read_at(const SharedPointer<Dentry>& dentry, void* buf, uint offset, uint count);
+
     int read(void* buf, uint count) override;
     int lseek(int offset, int whence) override;
     int write(void* buf, uint count) override;
@@ -122,5 +137,20 @@ public:
     static void create_pipe(int rfd, int wrd, int flags, Pipe* pipes[]);
 };
 
+/** Shared memory object opened with shm_open. It has no content of its own to read or write, it is meant to be mapped */
+class SharedMemoryFile : public FileInterface
+{
+public:
+    SharedPointer<Memory::SharedMemory> object;
+
+    SharedMemoryFile(int fd, int flags, const SharedPointer<Memory::SharedMemory>& object);
+    int read(void* buf, uint count) override;
+    int lseek(int offset, int whence) override;
+    int write(void* buf, uint count) override;
+    int fstat(struct stat* statbuf) override;
+    [[nodiscard]] bool should_wait_for_data_on_read() const override;
+    [[nodiscard]] int get_write_fd() const override;
+    [[nodiscard]] int get_read_fd() const override;
+};
 
 #endif //BREBOS_FILEINTERFACE_H
@@ -422,8 +422,8 @@ int VFS::read(int fd, uint length, void* buf)
 
 	if (r == 0 && f->should_wait_for_data_on_read())
 	{
-		Scheduler::do_read_wait(Scheduler::get_running_process_pid(), f->get_write_fd(), length);
-		return read(fd, length - r, (char*)buf + r);
+		f->read_wait_queue.wait();
+		return read(fd, length, buf);
 	}
 
 	return r;
@@ -440,7 +440,7 @@ int VFS::write(int fd, void* buf, uint count)
 		Scheduler::get_running_process()->kill(SIGPIPE);
 
 	if (status > 0 && f->get_read_fd() != -1)
-		Scheduler::wake_up_read_waiting_processes(fd, f->get_read_fd(), status);
+		file_descriptors[f->get_read_fd()]->read_wait_queue.wake_all();
 
 	return status;
 }
@@ -453,13 +453,13 @@ int VFS::close(int fd)
 
 	if (f->rc == 0)
 	{
-		const int write_fd = f->get_write_fd();
 		const int read_fd = f->get_read_fd();
 		delete f;
 		file_descriptors[fd] = nullptr;
 		lowest_free_fd = min(lowest_free_fd, fd);
-		if (write_fd != -1 && read_fd != -1)
-			Scheduler::wake_up_read_waiting_processes(write_fd, read_fd, 0);
+		// Readers of the other end of a pipe get end of file once its write end is closed
+		if (read_fd != -1 && read_fd != fd)
+			file_descriptors[read_fd]->read_wait_queue.wake_all();
 	}
 
 	return 0; // Success
@@ -470,6 +470,10 @@ FileInterface* VFS::open_file(const char* pathname, int flags, mode_t mode, int&
 #define open_file_leave_with_error(e) { lowest_free_fd=min((int)lowest_free_fd, system_fd); err = e; return nullptr;}
 	constexpr int supported_flags = O_RDONLY | O_RDWR | O_WRONLY | O_TRUNC | O_CREAT | O_SYNC | O_APPEND;
 
+	// Shared memory objects only live in memory, no file system holds them
+	if (strstr(pathname, SHM_DIR) == pathname)
+		return open_shm(pathname + strlen(SHM_DIR), flags, err);
+
 	int system_fd = get_free_fd();
 	if (system_fd == -1)
 		open_file_leave_with_error(-ENFILE) // No free file descriptors
@@ -549,6 +553,63 @@ bool VFS::resize(SharedPointer<Dentry>& dentry, size_t new_size)
 	return dentry->inode->superblock->get_fs()->resize(dentry, new_size);
 }
 
+FileInterface* VFS::open_shm(const char* name, int flags, int& err)
+{
+	// shm_open adds O_NOFOLLOW, O_CLOEXEC and O_NONBLOCK, which mean nothing to shared memory objects
+	constexpr int supported_flags = O_RDONLY | O_RDWR | O_TRUNC | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC |
+		O_NONBLOCK;
+	if (const int flags_check = flags & ~supported_flags)
+	{
+		printf_warn("shm_open called with the following unsupported flags: 0x%x", flags_check);
+		err = -EINVAL;
+		return nullptr;
+	}
+
+	const int system_fd = get_free_fd();
+	if (system_fd == -1)
+	{
+		err = -ENFILE; // No free file descriptors
+		return nullptr;
+	}
+
+	const SharedPointer<Memory::SharedMemory> object = Memory::SharedMemory::open(name, flags, err);
+	if (!object)
+	{
+		lowest_free_fd = min(lowest_free_fd, system_fd);
+		return nullptr;
+	}
+
+	return file_descriptors[system_fd] = new SharedMemoryFile(system_fd, flags, object);
+}
+
+int VFS::ftruncate(int fd, uint length)
+{
+	auto f = file_descriptors[fd];
+	if (f == nullptr)
+		return -EBADF; // File descriptor not found
+	if (!(f->flags & (O_WRONLY | O_RDWR)))
+		return -EINVAL; // Not open for writing
+
+	switch (f->type)
+	{
+		case FileInterface::File:
+			return resize(((File*)f)->dentry, length) ? 0 : -EIO;
+		case FileInterface::Shm:
+			return ((SharedMemoryFile*)f)->object->resize(length);
+		default:
+			return -EINVAL;
+	}
+}
+
+int VFS::unlink(const char* pathname)
+{
+	if (strstr(pathname, SHM_DIR) == pathname)
+		return Memory::SharedMemory::unlink(pathname + strlen(SHM_DIR));
+
+	printf_warn("unlink called on '%s', removing files is not supported yet", pathname);
+	return -ENOSYS;
+}
+
 int VFS::pipe(int pipefd[2])
 {
 	int rfd = get_free_fd();
@@ -57,6 +57,15 @@ private:
 
 	[[nodiscard]]
 	static const char* get_file_name(const char* pathname);
+
+	/**
+	 * Opens a shared memory object
+	 * @param name name of the object, relative to SHM_DIR
+	 * @param flags opening parameters
+	 * @param err error code to return in case of failure
+	 * @return the file descriptor on success, nullptr if an error occurred
+	 */
+	static FileInterface* open_shm(const char* name, int flags, int& err);
 public:
 	static void init();
 
@@ -169,6 +178,21 @@ public:
 	 */
 	static bool resize(SharedPointer<Dentry>& dentry, size_t new_size);
 
+	/**
+	 * Resizes the file or shared memory object a file descriptor refers to
+	 * @param fd file descriptor, open for writing
+	 * @param length new size
+	 * @return 0 on success, -errno on error
+	 */
+	static int ftruncate(int fd, uint length);
+
+	/**
+	 * Removes a name. Only shared memory objects can be removed for now
+	 * @param pathname absolute path of the name to remove
+	 * @return 0 on success, -errno on error
+	 */
+	static int unlink(const char* pathname);
+
 	/**
 	 * Opens a pipe with the specified flags
 	 * @param pipefd Open flags
@@ -11,6 +11,8 @@ public:
 
 	~Dentry();
 
+	KMEM_CACHE_ALLOCATED(Dentry, "dentry")
+
 	[[nodiscard]]
 	char* get_absolute_path() const;
 
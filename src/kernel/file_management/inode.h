@@ -4,6 +4,8 @@
 #include <kstddef.h>
 #include <sys/stat.h>
 
+#include "../core/KmemCache.h"
+
 class Superblock;
 
 class Inode
@@ -18,6 +20,8 @@ public:
     Inode(const Superblock* superblock, uint size, uint lba, Type type, ino_t id, nlink_t nlink, uid_t uid, gid_t gid,
           dev_t rdev, blkcnt_t blocks, time_t atime, time_t mtime, time_t ctime);
 
+    KMEM_CACHE_ALLOCATED(Inode, "inode")
+
 public:
     const Superblock* superblock;
     uint size;
@@ -34,6 +38,7 @@ public:
     time_t atime; // Last access time
     time_t mtime; // Last modification time
     time_t ctime; // Last status change time
+    uint version = 0; // Incremented each time the content changes, so that caches can tell their data is stale
 };
 
 
@@ -10,7 +10,6 @@
 #include "../core/memory.h"
 #include "../core/fb.h"
 #include "../core/interrupts.h"
-#include "../core/PIC.h"
 
 uint8_t MMIOUtils::read8(uint32_t p_address)
 {
@@ -263,8 +262,7 @@ bool E1000::start()
 
     for (int i = 0; i < 0x80; i++)
         writeCommand(0x5200 + i * 4, 0);
-    if (Interrupts::register_interrupt(
-        PIC1_START_INTERRUPT + PCI::getIntLine(device.bus, device.device, device.function), this))
+    if (Interrupts::register_interrupt(PCI::setupInterrupt(device, E1000_MSI_INTERRUPT), this))
     {
         enableInterrupt();
         rxinit();
@@ -279,13 +277,9 @@ bool E1000::start()
 
 void E1000::fire([[maybe_unused]] cpu_state_t* cpu_state, [[maybe_unused]] stack_state_t* stack_state)
 {
-    /* This might be needed here if your handler doesn't clear interrupts from each device and must be done before EOI if using the PIC.
-           Without this, the card will spam interrupts as the int-line will stay high. */
-    // writeCommand(REG_IMASK, 0x1); // as we are writing back the status to ICR and calling PIC::acknowledge later,
-    // this does not appear to be required
-
+    // Reading ICR clears the interrupt causes, and makes the card stop asserting its interrupt line. This has to be done
+    // before the EOI, otherwise a level triggered line would fire again right away
     const uint32_t status = readCommand(0xc0);
-    writeCommand(0xC0, status); // Write the value back to clear the interrupts
     //printf_info("e1000 int: status: 0x%02X", status);
 
     if (status & 0x1)
@@ -15,6 +15,8 @@
 #define E1000_I217     0x153A  // Device ID for Intel I217
 #define E1000_82577LM  0x10EA  // Device ID for Intel 82577LM
 
+#define E1000_MSI_INTERRUPT MSI_START_INTERRUPT // Interrupt vector if the card supports MSI
+
 
 // I have gathered those from different Hobby online operating systems instead of getting them one by one from the manual
 
@@ -6,6 +6,7 @@
 #include "TCPListener.h"
 #include "TCP.h"
 #include "../utils/list.h"
+#include "../core/KmemCache.h"
 
 class Socket
 {
@@ -18,6 +19,8 @@ public:
 
     typedef struct packet packet_t;
 
+    KMEM_CACHE_ALLOCATED(Socket, "socket")
+
 private:
     friend class TCP;
     const char* hostname;
@@ -10,8 +10,12 @@
 
 using namespace ELFTools;
 
+list<ELFLoader::elf_image*> ELFLoader::image_cache{};
+uint ELFLoader::image_cache_hits = 0;
+uint ELFLoader::image_cache_misses = 0;
+
 ELFLoader::ELFLoader(): current_process(Scheduler::get_running_process()), elf_dep_list(new list<elf_dependence>),
-                        page_tables((Memory::page_table_t*)Memory::calloca(768, sizeof(Memory::page_table_t))),
+                        page_tables(Memory::allocate_user_page_tables()),
                         pdt((Memory::pdt_t*)Memory::malloca(sizeof(Memory::pdt_t)))
 {
 }
@@ -20,7 +24,7 @@ ELFLoader::~ELFLoader()
 {
     // Free stuff not transferred to process
     for (auto i = 0; i < elf_dep_list->size(); i++)
-        delete elf_dep_list->get(i)->elf;
+        release_image(elf_dep_list->get(i)->image);
     delete elf_dep_list;
 
     if (used)
@@ -52,13 +56,18 @@ bool ELFLoader::dynamic_loading(const ELF* elf)
 
     // Load interpreter
     auto interpreter = VFS::browse_to(elf->interpreter_name);
+    if (!interpreter) // Cached images are not checked again, the interpreter may have gone since
+    {
+        printf_error("Missing interpreter: %s", elf->interpreter_name);
+        return false;
+    }
     if (!load_elf(interpreter, SharedObject))
         return false;
 
     return true;
 }
 
-void ELFLoader::map_elf(const ELF* load_elf, Elf32_Addr runtime_load_address)
+void ELFLoader::map_elf(const ELF* load_elf, const SharedPointer<Dentry>& file, Elf32_Addr runtime_load_address)
 {
     for (int k = 0; k < load_elf->global_hdr.e_phnum; ++k)
     {
@@ -66,33 +75,23 @@ void ELFLoader::map_elf(const ELF* load_elf, Elf32_Addr runtime_load_address)
         if (h->p_type != PT_LOAD)
             continue;
 
-        uint segment_num_pages = ADDR_PAGE(h->p_memsz + PAGE_SIZE - 1);
-
         Elf32_Addr runtime_address = runtime_load_address + h->p_vaddr;
         uint runtime_page_id = ADDR_PAGE(runtime_address);
+        const uint page_offset = runtime_address & (PAGE_SIZE - 1);
+        uint segment_num_pages = ADDR_PAGE(page_offset + h->p_memsz + PAGE_SIZE - 1);
 
-        // Allocate page in kernel address space
-        int err;
-        auto load_addr = (Elf32_Addr)
-        Memory::mmap((void*)KERNEL_VIRTUAL_BASE,  segment_num_pages * PAGE_SIZE, DEFAULT_U_PROT, MAP_ANON | MAP_PRIVATE, 0, 0, err, Memory::kernel_process, false, true);
-        if (!load_addr)
-            irrecoverable_error("%s: mmap failed", __func__);
-
-        // Map it in process address space
+        // Pages holding file content are read upon first access, the ones past it (bss) are simply zeroed
+        const bool write = h->p_flags & PF_W;
+        const uint file_size = page_offset + h->p_filesz; // Bytes coming from the file, counted from the first page
         for (uint i = 0; i < segment_num_pages; i++)
         {
             if (PTE(page_tables, runtime_page_id + i))
                 irrecoverable_error("%s: address space overlap detected", __func__);
-            PTE(page_tables, runtime_page_id + i) = PTE(Memory::page_tables, ADDR_PAGE(load_addr) + i) | PAGE_USER;
+            PTE(page_tables, runtime_page_id + i) = PAGE_USER | (write ? PAGE_WRITE : 0) | PAGE_LAZY_ZERO |
+                (i * PAGE_SIZE < file_size ? PAGE_FILE : 0);
         }
 
-        // Check if page should have write permissions, and remove the permission if it's not the case
-        const bool write = h->p_flags & PF_W;
-        if (!write)
-            for (uint i = 0; i < segment_num_pages; i++)
-                PTE(page_tables, runtime_page_id + i) &= ~PAGE_WRITE;
-
-        // Register allocation
+        // Register allocation. Nothing is written there at load time, so there is no load address
         const auto runtime_addr_base_page = runtime_page_id << 12;
         const int policy = DEFAULT_U_POLICY & (write ? -1U : ~PROT_WRITE);
         allocations.add({
@@ -102,71 +101,66 @@ void ELFLoader::map_elf(const ELF* load_elf, Elf32_Addr runtime_load_address)
                 Memory::page_info{DEFAULT_U_FLAGS, policy},
                 true
             },
-            load_addr
+            0
         });
+        if (h->p_filesz)
+            file_mappings.add({
+                runtime_addr_base_page,
+                runtime_addr_base_page + segment_num_pages * PAGE_SIZE,
+                file,
+                h->p_offset - page_offset,
+                file_size
+            });
     }
     num_pages += load_elf->num_pages();
 }
 
-void ELFLoader::load_elf_code(const ELF* elf, uint load_address, uint runtime_load_address) const
-{
-    // Copy lib code in allocated space
-    for (int k = 0; k < elf->global_hdr.e_phnum; ++k)
-    {
-        const Elf32_Phdr* h = &elf->prog_hdrs[k];
-        if (h->p_type != PT_LOAD)
-            continue;
-
-        const void* bytes_ptr = (void*)(load_address + h->p_offset);
-
-        // Copy segment
-        const auto runtime_address = runtime_load_address + h->p_vaddr;
-        Lptr dest_addr = new_lptr<void>(runtime_address);
-        dest_addr.memcpy(bytes_ptr, h->p_filesz);
-
-        // Fill the rest with 0. Very important, this is where bss is.
-        if (h->p_memsz > h->p_filesz)
-        {
-            dest_addr = runtime_load_address + (h->p_vaddr + h->p_filesz);
-            dest_addr.memset(0, h->p_memsz - h->p_filesz);
-        }
-    }
-}
-
-void ELFLoader::allocate_stacks()
+void ELFLoader::allocate_stacks(size_t args_size)
 {
     int err;
     constexpr int flags = MAP_ANONYMOUS | MAP_PRIVATE;
 
-    // Allocate process stack pages
+    // Only allocate the top stack pages, which will receive the args. The other ones will be allocated upon first
+    // access by the page fault handler
+    const uint args_n_pages = ADDR_PAGE(args_size + sizeof(int) + PAGE_SIZE - 1);
+    if (args_n_pages > PROCESS_STACK_N_PAGES)
+        irrecoverable_error("%s: args do not fit in process stack", __func__);
     void* stack_load_address =
-            Memory::mmap(nullptr, PROCESS_STACK_SIZE, DEFAULT_U_PROT, flags, 0, 0, err, Memory::kernel_process, false, true);
+            Memory::mmap(nullptr, args_n_pages * PAGE_SIZE, DEFAULT_U_PROT, flags, 0, 0, err, Memory::kernel_process, false, true);
     if (!stack_load_address)
         irrecoverable_error("%s: mmap failed", __func__);
     // Map them in process address space
     constexpr uint stack_start_page_id = 768 * PT_ENTRIES - PROCESS_STACK_N_PAGES;
-    for (int i = 0; i < PROCESS_STACK_N_PAGES; i++)
+    const uint args_start_page_id = 768 * PT_ENTRIES - args_n_pages;
+    for (uint i = 0; i < PROCESS_STACK_N_PAGES; i++)
     {
         uint dest_page_id = stack_start_page_id + i;
         if (PTE(page_tables, dest_page_id) != 0)
             irrecoverable_error("%s: Process kernel stack page entry is not empty", __FUNCTION__);
-        PTE(page_tables, dest_page_id) = PTE(Memory::page_tables, ADDR_PAGE((uint)stack_load_address) + i); // Todo: use update_pte ?
+        PTE(page_tables, dest_page_id) = dest_page_id < args_start_page_id
+            ? (DEFAULT_U_POLICY & ~PAGE_PRESENT) | PAGE_LAZY_ZERO
+            : PTE(Memory::page_tables, ADDR_PAGE((uint)stack_load_address) + dest_page_id - args_start_page_id) &
+              ~PAGE_GLOBAL; // Todo: use update_pte ?
     }
-    allocations.add({{stack_start_page_id << 12, (stack_start_page_id + PROCESS_STACK_N_PAGES) << 12, Memory::DEFAULT_U_PAGE_INFO, true}, (Elf32_Addr)stack_load_address});
+    // Lazily allocated part has no load address, nothing is written there at load time
+    if (args_start_page_id != stack_start_page_id)
+        allocations.add({{stack_start_page_id << 12, args_start_page_id << 12, Memory::DEFAULT_U_PAGE_INFO, true}, 0});
+    allocations.add({{args_start_page_id << 12, KERNEL_VIRTUAL_BASE, Memory::DEFAULT_U_PAGE_INFO, true}, (Elf32_Addr)stack_load_address});
 
     // Allocate syscall stack pages
     void* kstack_load_address =
             Memory::mmap(nullptr, PROCESS_SYSCALL_STACK_SIZE, DEFAULT_K_PROT, flags, 0, 0, err, Memory::kernel_process, false, false);
     if (!kstack_load_address)
         irrecoverable_error("%s: mmap failed", __func__);
-    // Allocate syscall handler stack pages
-    uint kstack_start_page_id = 768 * PT_ENTRIES - PROCESS_STACK_N_PAGES - PROCESS_SYSCALL_STACK_N_PAGES;
+    // Allocate syscall handler stack pages, below the guard page(s)
+    uint kstack_start_page_id = 768 * PT_ENTRIES - PROCESS_N_STACKS_PAGES;
     for (int i = 0; i < PROCESS_SYSCALL_STACK_N_PAGES; i++)
     {
         uint kstack_dest_page_id = kstack_start_page_id + i;
         if (PTE(page_tables, kstack_dest_page_id) != 0)
             irrecoverable_error("%s: Process kernel stack page entry is not empty", __FUNCTION__);
-        PTE(page_tables, kstack_dest_page_id) = PTE(Memory::page_tables, ADDR_PAGE((uint)kstack_load_address) + i);
+        PTE(page_tables, kstack_dest_page_id) =
+            PTE(Memory::page_tables, ADDR_PAGE((uint)kstack_load_address) + i) & ~PAGE_GLOBAL;
     }
     allocations.add({{kstack_start_page_id << 12, (kstack_start_page_id + PROCESS_SYSCALL_STACK_N_PAGES) << 12, Memory::DEFAULT_K_PAGE_INFO, true}, (Elf32_Addr)kstack_load_address});
 
@@ -198,15 +192,14 @@ void ELFLoader::setup_pdt()
     // Entries 768 to 1024 point to kernel page tables, so that kernel is mapped. Moreover, syscall handlers
     // will not need to switch to kernel pdt to make changes in kernel memory as it is mapped the same way
     // in every process' PDT
-    auto num_used_paged_tables = (num_pages + PT_ENTRIES - 1)  / PT_ENTRIES;
-    for (size_t i = 0; i < num_used_paged_tables; ++i)
-        pdt->entries[i] = PHYS_ADDR(Memory::page_tables, (uint) &page_tables[i]) | PAGE_USER | PAGE_WRITE |
-            PAGE_PRESENT;
-    for (size_t i = num_used_paged_tables; i < 768; i++)
-        pdt->entries[i] = 0;
-    // Use kernel page tables for the rest
-    for (int i = 768; i < PDT_ENTRIES; ++i)
-        pdt->entries[i] = PHYS_ADDR(Memory::page_tables, (uint) &Memory::page_tables[i]) | PAGE_WRITE | PAGE_PRESENT;
+    // Page tables are lazily allocated, only the ones that have been written to have a frame and get a PDE
+    for (size_t i = 0; i < 768; ++i)
+        pdt->entries[i] = Memory::page_table_present(page_tables, i)
+                              ? PHYS_ADDR(Memory::page_tables, (uint) &page_tables[i]) | PAGE_USER | PAGE_WRITE |
+                              PAGE_PRESENT
+                              : 0;
+    // Share kernel PDEs for the rest, large pages included
+    Memory::copy_kernel_pdes(pdt);
 }
 
 __attribute__((no_instrument_function))
@@ -258,38 +251,133 @@ Lptr<char> ELFLoader::write_auxv(const Lptr<char>& stack_top, void* const argv0_
     return lt.convert_to<char>();
 }
 
-ELF* ELFLoader::load_elf(const SharedPointer<Dentry>& file, ELF_type expected_type)
+void* ELFLoader::read_elf_headers(const SharedPointer<Dentry>& file)
 {
-    const auto proc = Scheduler::get_running_process();
-    const int fd = proc->open(file->get_absolute_path(), O_RDONLY, 0777);
-    if (fd < 0)
+    const uint size = file->inode->size;
+    if (size < sizeof(Elf32_Ehdr))
         return nullptr;
-    const auto buf = new char[file->inode->size];
-    if (proc->read(fd, buf, file->inode->size) < 0) // Read file with read (and not VFS::load_file) to benefit from preload
-    {
-        proc->close(fd);
+    const auto buf = (char*)lazy_malloc(size);
+    if (!buf)
         return nullptr;
+
+    // Reads a range of the file at its offset in buf
+    const auto read_range = [&file, buf, size](uint offset, uint length)
+    {
+        return offset <= size && length <= size - offset &&
+               File::read_at(file, buf + offset, offset, length) == (int)length;
+    };
+
+    const auto ehdr = (const Elf32_Ehdr*)buf;
+    bool ok = read_range(0, sizeof(Elf32_Ehdr)) &&
+              read_range(ehdr->e_phoff, ehdr->e_phnum * ehdr->e_phentsize) &&
+              read_range(ehdr->e_shoff, ehdr->e_shnum * ehdr->e_shentsize);
+
+    // What ELF reads on top of the headers
+    for (int k = 0; ok && k < ehdr->e_phnum; ++k)
+    {
+        const auto h = (const Elf32_Phdr*)(buf + ehdr->e_phoff + k * ehdr->e_phentsize);
+        if (h->p_type == PT_INTERP || h->p_type == PT_DYNAMIC)
+            ok = read_range(h->p_offset, h->p_filesz);
+    }
+    for (int k = 0; ok && k < ehdr->e_shnum; ++k)
+    {
+        const auto h = (const Elf32_Shdr*)(buf + ehdr->e_shoff + k * ehdr->e_shentsize);
+        if (h->sh_type == SHT_DYNAMIC)
+            ok = read_range(h->sh_offset, h->sh_size);
     }
 
-    const auto elf = load_elf(buf, expected_type);
-    delete[] buf;
+    if (ok)
+        return buf;
 
-    return elf;
+    printf_error("%s: truncated ELF file", __func__);
+    free(buf);
+    return nullptr;
 }
 
-ELF* ELFLoader::load_elf(void* buf, ELF_type expected_type)
+ELFLoader::elf_image* ELFLoader::get_image(const SharedPointer<Dentry>& file, ELF_type expected_type)
 {
+    for (elf_image* image : image_cache)
+    {
+        if (image->file->inode != file->inode || image->type != expected_type)
+            continue;
+
+        image_cache.remove(image);
+        if (image->version != file->inode->version) // File has changed, parse it again
+        {
+            if (!image->users)
+                destroy_image(image);
+            break;
+        }
+
+        image_cache.addFirst(image);
+        image->users++;
+        image_cache_hits++;
+        return image;
+    }
+
+    image_cache_misses++;
+    void* headers = read_elf_headers(file);
+    if (!headers)
+        return nullptr;
+
     ELF* elf;
-    if (!((elf = ELF::is_valid((uint)buf, expected_type))))
+    if (!((elf = ELF::is_valid((uint)headers, expected_type))))
+    {
+        free(headers);
         return nullptr;
+    }
+
+    auto image = new elf_image{file, file->inode->version, expected_type, elf, headers, 1};
+    image_cache.addFirst(image);
+
+    // Evict the least recently used images that no loader is using
+    for (int i = image_cache.size() - 1; i >= 0 && image_cache.size() > ELF_IMAGE_CACHE_SIZE; i--)
+    {
+        elf_image* victim = *image_cache.get(i);
+        if (victim->users)
+            continue;
+        image_cache.remove(victim);
+        destroy_image(victim);
+    }
+
+    return image;
+}
+
+void ELFLoader::release_image(elf_image* image)
+{
+    if (!--image->users && !image_cache.contains(image))
+        destroy_image(image);
+}
+
+void ELFLoader::destroy_image(elf_image* image)
+{
+    delete image->elf;
+    free(image->headers);
+    delete image;
+}
+
+uint ELFLoader::get_image_cache_hits()
+{
+    return image_cache_hits;
+}
+
+uint ELFLoader::get_image_cache_misses()
+{
+    return image_cache_misses;
+}
+
+ELF* ELFLoader::load_elf(const SharedPointer<Dentry>& file, ELF_type expected_type)
+{
+    elf_image* image = get_image(file, expected_type);
+    if (!image)
+        return nullptr;
+    ELF* elf = image->elf;
 
-    uint load_address = (uint)buf;
     uint runtime_load_addr = num_pages * PAGE_SIZE;
-    const auto dep = elf_dependence({elf, runtime_load_addr});
+    const auto dep = elf_dependence({image, elf, runtime_load_addr});
     elf_dep_list->add(dep);
 
-    map_elf(elf, runtime_load_addr);
-    load_elf_code(elf, load_address, runtime_load_addr);
+    map_elf(elf, file, runtime_load_addr);
     if (!dynamic_loading(elf))
         return nullptr;
 
@@ -303,13 +391,15 @@ Process* ELFLoader::build_process(int argc, const char** argv, pid_t pid, pid_t
         return nullptr;
 
     finalize_process_setup(argc, argv, envp);
-    constexpr auto k_stack_top = ((768 * PT_ENTRIES - PROCESS_STACK_N_PAGES) << 12) - sizeof(int);
+    constexpr auto k_stack_top = ((768 * PT_ENTRIES - PROCESS_STACK_N_PAGES - PROCESS_STACK_GUARD_N_PAGES) << 12) - sizeof(int);
 
     used = true;
     Process* p = new Process(file->get_absolute_path(), num_pages, page_tables, pdt, &stack_state, priority, pid, ppid, k_stack_top);
 
     for (const auto& [alloc, _] : allocations)
         p->memtree.register_external_allocation(alloc);
+    for (const auto& mapping : file_mappings)
+        p->file_mappings.add(mapping);
 
     return p;
 }
@@ -323,7 +413,7 @@ void ELFLoader::write_to_stack(Lptr<char>& stack_top, const void* content, size_
 void ELFLoader::finalize_process_setup(int argc, const char** argv, const char** envp)
 {
     setup_pdt();
-    allocate_stacks();
+    allocate_stacks(args_stack_size(argc, argv, envp));
     setup_pcb(argc, argv, envp);
 }
 
@@ -336,6 +426,23 @@ Process* ELFLoader::setup_elf_process(pid_t pid, pid_t ppid, int argc, const cha
     return proc;
 }
 
+size_t ELFLoader::args_stack_size(int argc, const char** argv, const char** envp)
+{
+    if (argc != 0 && argv[argc - 1] == nullptr)
+        argc--;
+
+    size_t size = 0;
+    for (int i = 0; i < argc; i++)
+        size += strlen(argv[i]) + 1 + sizeof(char*); // Content + pointer
+    for (int i = 0; envp[i]; i++)
+        size += strlen(envp[i]) + 1 + sizeof(char*); // Content + pointer
+    size += 4 * 4; // Random bytes
+    size += 10 * sizeof(auxv_t); // auxv, cf write_auxv
+    size += 2 * 4 + sizeof(argc); // Zeroes and argc
+
+    return size;
+}
+
 void* ELFLoader::write_args_to_stack(int argc, const char** argv, const char** envp) const
 {
     // CF https://uclibc.org/docs/psABI-i386.pdf section 2.11
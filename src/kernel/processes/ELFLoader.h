@@ -33,7 +33,11 @@
 #define AT_HWCAP2 26
 #define AT_EXECFN 31
 
-#define PROCESS_N_STACKS_PAGES (PROCESS_STACK_N_PAGES + PROCESS_SYSCALL_STACK_N_PAGES)
+#define PROCESS_N_STACKS_PAGES (PROCESS_STACK_N_PAGES + PROCESS_STACK_GUARD_N_PAGES + PROCESS_SYSCALL_STACK_N_PAGES)
+
+#ifndef ELF_IMAGE_CACHE_SIZE
+#define ELF_IMAGE_CACHE_SIZE 16 // Number of parsed ELF files kept around for later execs
+#endif
 
 typedef struct auxv_t
 {
@@ -61,12 +65,31 @@ class ELFLoader
 {
     friend class Process;
 private:
+    /**
+     * Parsed ELF file. Images are cached, most recently used first, and shared by every loader loading their file
+     * until the file changes
+     */
+    struct elf_image
+    {
+        SharedPointer<Dentry> file;
+        uint version; // Version of the inode the image has been read at
+        ELF_type type;
+        ELF* elf;
+        void* headers; // File sized buffer holding the parts of the file that elf points to
+        uint users; // Loaders currently using the image, which cannot be evicted meanwhile
+    };
+
     struct elf_dependence
     {
+        elf_image* image;
         ELF* elf;
         Elf32_Addr runtime_load_address;
     };
 
+    static list<elf_image*> image_cache;
+    static uint image_cache_hits;
+    static uint image_cache_misses;
+
     Process* current_process;
     list<elf_dependence>* elf_dep_list;
     uint num_pages = 0;
@@ -79,6 +102,7 @@ private:
     ~ELFLoader();
 
     list<ELFTools::alloc> allocations;
+    list<Memory::file_mapping> file_mappings; // Segments, read upon first access
 
     template<typename ptr_inner_type>
     [[nodiscard]]
@@ -95,22 +119,46 @@ private:
     bool dynamic_loading(const ELF* elf);
 
     /**
-     * Load ELF file code and data into a process' address space and maps it
+     * Maps an ELF file into a process' address space. Only the headers are read here, segments are mapped
+     * file-backed and read upon first access
      * @param file ELF to load
      * @param expected_type
      * @return Loaded ELF, nullptr on error
      */
     ELF* load_elf(const SharedPointer<Dentry>& file, ELF_type expected_type);
 
-    ELF* load_elf(void* buf, ELF_type expected_type);
+    /**
+     * Reads the parts of an ELF file that describe it: ELF header, program and section headers, interpreter path and
+     * dynamic section. They are read at their file offset in a lazily allocated buffer as big as the file, so that the
+     * rest of the file costs no memory.
+     * @param file ELF file
+     * @return buffer, to be released with free. nullptr if the file is not big enough to hold what its headers describe
+     */
+    static void* read_elf_headers(const SharedPointer<Dentry>& file);
+
+    /**
+     * Gets the parsed image of an ELF file, from the cache if the file has not changed since it has been parsed.
+     * The image is to be given back with release_image.
+     * @param file ELF file
+     * @param expected_type expected type of the ELF
+     * @return image, nullptr if the file is not a valid ELF of the expected type
+     */
+    static elf_image* get_image(const SharedPointer<Dentry>& file, ELF_type expected_type);
+
+    /** Gives back an image obtained with get_image, destroying it if it is not cached anymore and unused */
+    static void release_image(elf_image* image);
+
+    static void destroy_image(elf_image* image);
 
     /**
-     * Maps the segments of an ELF into the process' virtual address space
+     * Maps the segments of an ELF into the process' virtual address space. Pages holding file content are mapped
+     * PAGE_LAZY_ZERO | PAGE_FILE and registered as file mappings, bss pages are lazily zeroed
      *
      * @param load_elf ELF to map
+     * @param file ELF file
      * @param runtime_load_address runtime load address of the lib
      */
-    void map_elf(const ELF* load_elf, Elf32_Addr runtime_load_address);
+    void map_elf(const ELF* load_elf, const SharedPointer<Dentry>& file, Elf32_Addr runtime_load_address);
 
     /**
      * Create a process to run an ELF executable
@@ -137,9 +185,21 @@ private:
      */
     void finalize_process_setup(int argc, const char** argv, const char** envp);
 
-    void load_elf_code(const ELF* elf, uint load_address, uint runtime_load_address) const;
+    /**
+     * Computes the size taken by what write_args_to_stack writes to the stack
+     * @param argc number of arguments
+     * @param argv argument list
+     * @param envp environment pointers
+     * @return size in bytes
+     */
+    static size_t args_stack_size(int argc, const char** argv, const char** envp);
 
-    void allocate_stacks();
+    /**
+     * Allocates the process stack and syscall stack. Process stack pages are lazily allocated, except the ones that
+     * will receive the args
+     * @param args_size size of the args that will be written to the stack
+     */
+    void allocate_stacks(size_t args_size);
 
     void setup_pcb(int argc, const char** argv, const char** envp);
 
@@ -162,6 +222,10 @@ public:
      */
     static Process* setup_elf_process(pid_t pid, pid_t ppid, int argc, const char** argv,
                                       const char** envp, const SharedPointer<Dentry>& file, uint priority);
+
+    [[nodiscard]] static uint get_image_cache_hits();
+
+    [[nodiscard]] static uint get_image_cache_misses();
 };
 
 
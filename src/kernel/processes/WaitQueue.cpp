@@ -0,0 +1,69 @@
+#include "WaitQueue.h"
+
+#include "scheduler.h"
+#include "../core/fb.h"
+
+void WaitQueue::add(Process* p)
+{
+    if (p->wait_queue)
+        irrecoverable_error("%s: process %d is already waiting", __PRETTY_FUNCTION__, p->pid);
+
+    p->wait_queue = this;
+    p->wait_prev = last;
+    p->wait_next = nullptr;
+    if (last)
+        last->wait_next = p;
+    else
+        first = p;
+    last = p;
+    p->set_flag(P_WAITING);
+}
+
+void WaitQueue::remove(Process* p)
+{
+    if (p->wait_queue != this)
+        irrecoverable_error("%s: process %d is not waiting on this queue", __PRETTY_FUNCTION__, p->pid);
+
+    if (p->wait_prev)
+        p->wait_prev->wait_next = p->wait_next;
+    else
+        first = p->wait_next;
+    if (p->wait_next)
+        p->wait_next->wait_prev = p->wait_prev;
+    else
+        last = p->wait_prev;
+
+    p->wait_queue = nullptr;
+    p->wait_prev = p->wait_next = nullptr;
+    p->flags &= ~P_WAITING;
+}
+
+void WaitQueue::wait()
+{
+    add(Scheduler::get_running_process());
+
+    TRIGGER_TIMER_INTERRUPT
+}
+
+Process* WaitQueue::wake_one()
+{
+    Process* p = first;
+    if (!p)
+        return nullptr;
+
+    remove(p);
+    Scheduler::wake_up(p);
+
+    return p;
+}
+
+void WaitQueue::wake_all()
+{
+    while (wake_one())
+    {}
+}
+
+bool WaitQueue::empty() const
+{
+    return first == nullptr;
+}
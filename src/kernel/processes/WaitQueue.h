@@ -0,0 +1,51 @@
+#ifndef CUSTOM_OS_WAITQUEUE_H
+#define CUSTOM_OS_WAITQUEUE_H
+
+class Process;
+
+/**
+ * Processes blocked until an event occurs. A queue is embedded in the object the event comes from (pipe, keyboard,
+ * process...), so that waking up waiters does not require looking for them.
+ *
+ * Links are stored in the processes themselves, as a process waits for at most one event at a time. Adding, removing
+ * and waking up a process thus take constant time and never allocate.
+ */
+class WaitQueue
+{
+	Process* first = nullptr; // Process waiting for the longest time
+	Process* last = nullptr;
+
+public:
+	WaitQueue() = default;
+	WaitQueue(const WaitQueue&) = delete;
+	WaitQueue& operator=(const WaitQueue&) = delete;
+
+	/**
+	 * Blocks a process on this queue. It stops being scheduled once it gets back to the scheduler, which the caller
+	 * has to make it do
+	 * @param p process to block, which must not be waiting for anything else
+	 */
+	void add(Process* p);
+
+	/**
+	 * Removes a process from this queue without waking it up
+	 * @param p process waiting on this queue
+	 */
+	void remove(Process* p);
+
+	/** Blocks the running process on this queue and calls the scheduler. Returns once the process is woken up */
+	void wait();
+
+	/**
+	 * Wakes up the process waiting for the longest time
+	 * @return woken up process, nullptr if no process is waiting
+	 */
+	Process* wake_one();
+
+	/** Wakes up every waiting process */
+	void wake_all();
+
+	[[nodiscard]] bool empty() const;
+};
+
+#endif //CUSTOM_OS_WAITQUEUE_H
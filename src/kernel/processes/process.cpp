@@ -6,6 +6,9 @@
 #include "scheduler.h"
 #include "../core/memory.h"
 #include "../core/fb.h"
+#include "../core/Kmap.h"
+#include "../core/TLB.h"
+#include "../core/VirtualPageAllocator.h"
 #include "../file_management/VFS.h"
 #include "../utils/comparison.h"
 #include "errno.h"
@@ -80,6 +83,7 @@ void Process::pre_free()
         return;
 
     memtree.free_all(this);
+    shared_mappings.clear(); // Shared memory objects may be released, now that their frames are unmapped
 
     // Close open file descriptors
     for (const auto& file_desc : file_descriptors)
@@ -237,19 +241,9 @@ bool Process::is_terminated() const
     return flags & P_TERMINATED;
 }
 
-bool Process::is_waiting_key() const
+bool Process::is_waiting() const
 {
-    return flags & P_WAITING_KEY;
-}
-
-bool Process::is_waiting_program() const
-{
-    return flags & P_WAITING_PROCESS;
-}
-
-bool Process::is_waiting_read() const
-{
-    return flags & P_WAITING_READ;
+    return flags & P_WAITING;
 }
 
 bool Process::is_sleeping() const
@@ -278,7 +272,7 @@ void Process::init()
     signal_default_action[SIGUSR2] = SIGDISP_TERM;
 }
 
-void Process::copy_page_to_other_process(const Process* other, uint page_id, uint mapping_page_id) const
+void Process::copy_page_to_other_process(const Process* other, uint page_id) const
 {
     if (!PTE(page_tables, page_id))
         return;
@@ -286,25 +280,34 @@ void Process::copy_page_to_other_process(const Process* other, uint page_id, uin
     // Allocate a page in kernel address space
     const uint sys_pe = Memory::get_free_pe_user(); // Get sys PTE id
     const uint frame = Memory::get_free_frame();
-    const int policy = PTE(page_tables, page_id) & 0x7FF;
+    const int policy = PTE(page_tables, page_id) & 0xFFF;
     Memory::allocate_page(frame, sys_pe, policy); // Allocate page in kernel address space
 
     // Register page in child address space
     const uint frame_val = frame << 12;
     other->update_pte(page_id , frame_val | policy, false);
 
-    // Map the new page in current process address space to be able to access it
-    update_pte(mapping_page_id, PTE(Memory::page_tables, sys_pe), true);
-
-    // Copy page to child page
-    memcpy((void*)(mapping_page_id << 12), (void*)(page_id << 12), PAGE_SIZE);
+    // Copy page to child page, through a temporary mapping as the kernel page lies out of the current address space
+    void* copy = Memory::Kmap::map(frame);
+    memcpy(copy, (void*)(page_id << 12), PAGE_SIZE);
+    Memory::Kmap::unmap(copy);
 }
 
 void Process::copy_page_to_other_process_shared(const Process* other, uint page_id) const
 {
     auto pte = PTE(page_tables, page_id);
+    if (pte & PAGE_LAZY_ZERO) // Not allocated yet, each process will get its own frame upon first access
+    {
+        other->update_pte(page_id, pte, false);
+        return;
+    }
     if (!(pte & PAGE_PRESENT))
         return;
+    if (Memory::shared_mapping::find(this, page_id << 12)) // MAP_SHARED frames stay shared as they are, not COW
+    {
+        other->update_pte(page_id, pte, false);
+        return;
+    }
 
     // Remove write permission in current process, as we cannot write to the page anymore since it is shared
     // Mark page as COW in current and other process
@@ -320,9 +323,12 @@ pid_t Process::fork()
     if (child_pid == -1)
         return -1;
 
-    // Allocate PDT and page tables
-    auto child_page_tables = (Memory::page_table_t*)Memory::calloca(768, sizeof(Memory::page_table_t));
+    // Allocate PDT and page tables. Page tables are lazily allocated, and their PDEs are installed by update_pte as
+    // pages get mapped in the child. Kernel PDEs are shared
+    auto child_page_tables = Memory::allocate_user_page_tables();
     auto child_pdt = (Memory::pdt_t*)Memory::malloca(sizeof(Memory::pdt_t));
+    memset(child_pdt->entries, 0, 768 * sizeof(uint));
+    Memory::copy_kernel_pdes(child_pdt);
 
     // Creat child process
     auto child = new Process(strdup(bin_path), num_pages, child_page_tables, child_pdt, &stack_state, priority, child_pid,
@@ -333,14 +339,12 @@ pid_t Process::fork()
     child->k_stack_state = k_stack_state;
     child->k_cpu_state = k_cpu_state;
     child->quantum = quantum;
+    child->nice = nice;
+    child->level = level;
     child->flags = flags & ~P_SYSCALL_INTERRUPTED;
     child->tls_base = tls_base;
 
     // Duplicate page table entries
-    uint mapping_page = ADDR_PAGE(KERNEL_VIRTUAL_BASE) - PROCESS_N_STACKS_PAGES - 1; // Free page that will be used to map the child pages in the current address space
-    if (page_tables[mapping_page / PT_ENTRIES].entries[mapping_page % PT_ENTRIES])
-        irrecoverable_error("%s: mapping mage is not empty", __func__);
-
     uint page_id_off = 0;
     for (uint i = 0; i < 768 - (PROCESS_N_STACKS_PAGES + PT_ENTRIES - 1) / PT_ENTRIES; i++)
     {
@@ -355,30 +359,19 @@ pid_t Process::fork()
         page_id_off += PT_ENTRIES;
     }
 
-    // Duplicate stacks - do not use COW for stacks, because they are not shared
-    for (int i = 0; i <= PROCESS_STACK_N_PAGES; i++) // First copy the process stack
-        copy_page_to_other_process(child, ADDR_PAGE(KERNEL_VIRTUAL_BASE - PAGE_SIZE * (i + 1)), mapping_page);
-    for (int i = 0; i <= PROCESS_SYSCALL_STACK_N_PAGES; i++) // Next proceed with syscall stack
-        copy_page_to_other_process(child, ADDR_PAGE(KERNEL_VIRTUAL_BASE - PAGE_SIZE * (PROCESS_STACK_N_PAGES + i + 1)), mapping_page);
-
-    // Duplicate PDT entries - This MUST be done after copying the pages, because page tables are lazily allocated.
-    // If we do it before, the page tables would not be actually allocated yet, thus PHYS_ADDR would return 0
-    for (uint i = 0; i < 768; i++)
-    {
-        if (pdt->entries[i] == 0)
-        {
-            child->pdt->entries[i] = 0;
-            continue;
-        }
-
-        auto flags = pdt->entries[i] & 0x7FF;
-        auto frame_val = PHYS_ADDR(Memory::page_tables, (uint) &child->page_tables[i]);
-        child->pdt->entries[i] = frame_val | flags;
-    }
-    memcpy(child_pdt->entries + 768, pdt->entries + 768, sizeof(uint) * (PDT_ENTRIES - 768));
+    // Share process stack pages the same way, only the ones that actually get written to will end up being copied
+    for (int i = 0; i < PROCESS_STACK_N_PAGES; i++)
+        copy_page_to_other_process_shared(child, ADDR_PAGE(KERNEL_VIRTUAL_BASE - PAGE_SIZE * (i + 1)));
+    // Copy syscall stack. It cannot be COW, as the CPU pushes the interrupt frame onto it upon entering the kernel,
+    // and a page fault at that moment would be a double fault
+    for (int i = 0; i < PROCESS_SYSCALL_STACK_N_PAGES; i++)
+        copy_page_to_other_process(child, ADDR_PAGE(KERNEL_VIRTUAL_BASE - PAGE_SIZE * (PROCESS_STACK_N_PAGES + PROCESS_STACK_GUARD_N_PAGES + i + 1)));
 
-    // Clear mapping page
-    update_pte(mapping_page, 0, true);
+    // File-backed pages that have not been read yet are shared as they are, the child reads them on its own
+    for (const auto& mapping : file_mappings)
+        child->file_mappings.add(mapping);
+    for (const auto& mapping : shared_mappings)
+        child->shared_mappings.add(mapping);
 
     // Copy file descriptors
     for (uint i = 0; i < MAX_FD_PER_PROCESS; i++)
@@ -419,17 +412,21 @@ void Process::update_pte(uint pte, uint val, bool update_cache) const
     else if (PTE(page_tables, pte) & PAGE_PRESENT && !(PTE(page_tables, pte) & PAGE_LAZY_ZERO))
         irrecoverable_error("huh");
 
+    if (page_tables == Memory::page_tables)
+    {
+        Memory::split_large_page(pte >> 10);
+        Memory::VirtualPageAllocator::set_used(pte, val & (PAGE_PRESENT | PAGE_LAZY_ZERO));
+    }
+    // Values are often copied from kernel PTEs: only keep the global flag on higher half pages
+    val = (val & ~PAGE_GLOBAL) | (val & PAGE_PRESENT ? PAGE_GLOBAL_IF_KERNEL(pte) : 0);
     PTE(page_tables, pte) = val;
     uint pde = pte >> 10;
     if (!pdt->entries[pde])
-    {
         pdt->entries[pde] = PHYS_ADDR(Memory::page_tables, (uint) &page_tables[pde]) | PAGE_USER | PAGE_WRITE |
             PAGE_PRESENT;
-        if (update_cache)
-            Memory::reload_cr3_asm();
-    }
-    else if (update_cache)
-        INVALIDATE_PAGE(pde, pte);
+    // Non present entries are never cached, so invalidating the page also covers a newly installed page table
+    if (update_cache)
+        Memory::TLB::invalidate_page(pte);
 
     // Increase frame reference count if we are actually mapping a frame
     if (val & PAGE_PRESENT && !(val & PAGE_LAZY_ZERO))
@@ -447,6 +444,8 @@ void Process::execve_transfer(Process* proc)
     for (const auto& val : values_to_write)
         proc->values_to_write.add(val);
     proc->pid = pid;
+    proc->nice = nice;
+    proc->level = level;
     exec_replacement = proc;
     proc->is_waiting_for_any_child_to_terminate = is_waiting_for_any_child_to_terminate;
     proc->is_waited_by_parent = is_waited_by_parent;
@@ -580,6 +579,15 @@ int Process::lseek(int fd, int offset, int whence) const
     return VFS::lseek(sys_fd, offset, whence);
 }
 
+int Process::ftruncate(int fd, uint length) const
+{
+    int sys_fd = proc_to_sys_fd(fd);
+    if (sys_fd == -1)
+        return -EBADF; // File descriptor not found
+
+    return VFS::ftruncate(sys_fd, length);
+}
+
 int Process::proc_to_sys_fd(int fd) const
 {
     if (fd >= 0 && fd < MAX_FD_PER_PROCESS && file_descriptors[fd])
@@ -4,7 +4,11 @@
 #include <signal.h>
 #include "../utils/BST.h"
 #include "../core/memory.h"
+#include "../core/FileMapping.h"
+#include "../core/SharedMemory.h"
+#include "../core/KmemCache.h"
 #include "../core/interrupts.h"
+#include "../core/SMP.h"
 #include "ELF.h"
 #include "../utils/list.h"
 #include "../file_management/VFS.h"
@@ -14,6 +18,7 @@
 #include "stdarg.h"
 #include "../utils/min_heap.h"
 #include "../utils/Stack.h"
+#include "WaitQueue.h"
 
 // Process is ready to be executed
 #define P_READY 0
@@ -21,18 +26,14 @@
 #define P_TERMINATED 1
 // Process has been interrupted during a syscall
 #define P_SYSCALL_INTERRUPTED 2
-// Process is waiting for a key press
-#define P_WAITING_KEY 4
-// Process is waiting for another process to terminate
-#define P_WAITING_PROCESS 8
+// Process is blocked on a wait queue
+#define P_WAITING 4
 // Process is terminated, but not freed for its parent to get info from it
 #define P_ZOMBIE 16
 // Process is sleeping
 #define P_SLEEPING 32
 // Process is about to be replaced because of an exec
 #define P_EXEC 64
-// Process is waiting for new data after calling read()
-#define P_WAITING_READ 128
 
 #define INIT_ERR_RET_VAL 127
 
@@ -52,6 +53,7 @@
 #define PROCESS_STACK_SIZE 0x80000 // 512 KiB
 static_assert((PROCESS_STACK_SIZE % PAGE_SIZE) == 0, "PROCESS_STACK_SIZE must be a multiple of STACK_SIZE");
 #define PROCESS_STACK_N_PAGES (PROCESS_STACK_SIZE / PAGE_SIZE)
+#define PROCESS_STACK_GUARD_N_PAGES 1 // Unmapped pages between the process stack and the syscall stack
 #define PROCESS_SYSCALL_STACK_SIZE 0x2000
 static_assert((PROCESS_SYSCALL_STACK_SIZE % PAGE_SIZE) == 0, "PROCESS_SYSCALL_STACK_SIZE must be a multiple of STACK_SIZE");
 #define PROCESS_SYSCALL_STACK_N_PAGES (PROCESS_SYSCALL_STACK_SIZE / PAGE_SIZE)
@@ -62,6 +64,7 @@ class Process
 {
 	friend class Scheduler; // Scheduler managers processes, it needs complete access to do its stuff
 	friend class ELFLoader; // ELFLoader creates processes, it acts like the constructor, it initializes most fields
+	friend class WaitQueue; // Wait queues link the processes blocked on them through their fields
 
 	struct address_val_pair
 	{
@@ -95,6 +98,10 @@ class Process
 	};
 
 	uint quantum, priority;
+	int nice = 0; // Niceness, from NICE_MIN to NICE_MAX. Sets the scheduling level the process starts from
+	uint level = 0; // Scheduling level, 0 being the most favoured one. Lowered as the process uses up its quanta
+	uint run_start = 0; // Time (PIT::get_ms) at which the process last got a processor
+
 
 	uint num_pages; // Num pages over which the process code spans, including unmapped pages
 
@@ -104,6 +111,10 @@ class Process
 	uint k_stack_top; // Top of syscall handlers' stack
 	uint flags; // Process state
 
+	WaitQueue* wait_queue = nullptr; // Wait queue the process is blocked on, if any
+	Process* wait_prev = nullptr; // Previous process in wait_queue
+	Process* wait_next = nullptr; // Next process in wait_queue
+
 	int ret_status{};
 
 	char* work_dir;
@@ -135,13 +146,14 @@ private:
 	sigset_t pending_signals{};
 	sigset_t* signal_top_level_block_mask = nullptr; // Ptr to signals_contexts[0].blocked_mask. Do not free
 
-	void copy_page_to_other_process(const Process* other, uint page_id, uint mapping_page_id) const;
+	void copy_page_to_other_process(const Process* other, uint page_id) const;
 
 	void copy_page_to_other_process_shared(const Process* other, uint page_id) const;
 
 public:
 	uint lowest_free_pe;
 	uint free_bytes = 0;
+	uint num_page_faults = 0; // Number of page faults taken by the process
 
 	char* bin_path = nullptr;
 	cpu_state_t cpu_state{}; // Registers
@@ -151,8 +163,11 @@ public:
 
 	bool is_waiting_for_any_child_to_terminate = false; // Tells whether the process is waiting for any child to terminate
 	bool is_waited_by_parent = false; // Tells whether the parent specifically waited for this process to terminate
+	WaitQueue children_wait_queue{}; // Where the process waits for its children to terminate
 	list<pid_t> children{};
 	list<address_val_pair> values_to_write{}; // list of values that need to be written in process address space
+	list<Memory::file_mapping> file_mappings{}; // Parts of the address space read from files upon first access
+	list<Memory::shared_mapping> shared_mappings{}; // Parts of the address space mapping shared memory objects
 
 	void* tls_base = nullptr;
 
@@ -188,6 +203,8 @@ private:
 	void release_fd(int fd);
 
 public:
+	KMEM_CACHE_ALLOCATED(Process, "process")
+
 	/** Gets the process' PID */
 	[[nodiscard]] pid_t get_pid() const;
 
@@ -229,14 +246,8 @@ public:
 	/** Checks whether the program is terminated */
 	[[nodiscard]] bool is_terminated() const;
 
-	/** Checks whether the program is waiting for a key press */
-	[[nodiscard]] bool is_waiting_key() const;
-
-	/** Checks whether the program is waiting for another program to terminate */
-	[[nodiscard]] bool is_waiting_program() const;
-
-	/** Checks whether the program is waiting for new data after a call to read() **/
-	[[nodiscard]] bool is_waiting_read() const;
+	/** Checks whether the program is blocked on a wait queue */
+	[[nodiscard]] bool is_waiting() const;
 
 	[[nodiscard]] bool is_sleeping() const;
 
@@ -294,6 +305,12 @@ public:
 	[[nodiscard]]
 	int lseek(int fd, int offset, int whence) const;
 
+	/**
+	 * Truncates or extends the file or shared memory object a file descriptor refers to
+	 * @return 0 on success, -errno on error
+	 */
+	int ftruncate(int fd, uint length) const;
+
 	[[nodiscard]]
 	int proc_to_sys_fd(int fd) const;
 
@@ -6,17 +6,21 @@
 #include "../core/GDT.h"
 #include "../core/PIC.h"
 #include "../core/fb.h"
+#include "../core/keyboard.h"
+#include "../core/LAPIC.h"
+#include "../core/TLB.h"
+#include "../core/ZeroedFramePool.h"
 #include "../file_management/VFS.h"
 #include <errno.h>
 
 uint Scheduler::pid_pool = 0;
-pid_t Scheduler::running_process = MAX_PROCESSES;
-queue<pid_t, MAX_PROCESSES>* Scheduler::ready_queue{};
-queue<pid_t, MAX_PROCESSES>* Scheduler::waiting_queue{};
+pid_t Scheduler::running_process[MAX_CPUS]{}; // Set in init, the bootstrap processor runs the kernel process first
+queue<pid_t, MAX_PROCESSES>* Scheduler::ready_queues{};
+uint Scheduler::ready_levels = 0;
+uint Scheduler::last_boost_ms = 0;
 Process* Scheduler::processes[MAX_PROCESSES] {};
 MinHeap<Scheduler::asleep_process>* Scheduler::sleeping_processes{};
-list<Scheduler::proc_waiting_for_read>* Scheduler::processes_waiting_for_read{};
-void* Scheduler::stack_switch_stack_top = nullptr;
+void* Scheduler::stack_switch_stack_tops[MAX_CPUS]{};
 
 /**
  * Switch to a new stack anc all a function (taking a process as parameter)
@@ -28,68 +32,98 @@ extern "C" [[noreturn]] void switch_stack_and_call_process_function(void* new_es
 
 Process* Scheduler::get_next_process()
 {
+    const uint cpu = SMP::get_cpu_id();
     Process* p = nullptr;
-    running_process = MAX_PROCESSES;
 
-    // Find next process to execute
-    while (p == nullptr)
+    // Put away the process this processor was running
+    if (running_process[cpu] != MAX_PROCESSES)
     {
-        // Nothing to run
-        if (ready_queue->empty())
-            return nullptr;
+        Process* proc = processes[running_process[cpu]];
+        running_process[cpu] = MAX_PROCESSES;
 
-        // Get process
-        pid_t pid = running_process = ready_queue->getFirst();
-        Process* proc = processes[pid];
+        // Charge the time it ran
+        const uint ran = PIT::get_ms() - proc->run_start;
+        proc->quantum = ran + QUANTUM_SLACK_MS >= proc->quantum ? 0 : proc->quantum - ran;
 
         if (proc->is_terminated())
-            relinquish_first_ready_process();
-        else if (proc->is_waiting_key())
-            set_first_ready_process_asleep_waiting_key_press();
-        else if (proc->is_waiting_program())
-            set_first_ready_process_asleep_waiting_process();
-        else if (proc->is_sleeping())
-            ready_queue->dequeue();
-        else if (proc->is_waiting_read())
-            set_first_ready_process_asleep_waiting_read();
+            relinquish_process(proc);
+        else if (proc->is_waiting() || proc->is_sleeping())
+        {
+            // Nothing else to do, the process has been put on a wait queue or in the sleeping heap when it started
+            // waiting
+        }
         else
         {
             if (proc->exec_running())
             {
                 auto replacement = proc->exec_replacement;
                 proc->set_flag(P_TERMINATED);
-                relinquish_first_ready_process();
-                processes[proc->pid] = replacement;
+                relinquish_process(proc);
+                Memory::copy_kernel_pdes(replacement->pdt); // Kernel PDEs may have changed since it was built
+                processes[replacement->pid] = replacement;
                 proc = replacement;
+                RESET_QUANTUM(proc); // It has not used up any quantum yet
             }
 
-            // Update queue
+            // Keep running it if it has time left. Processes woken up below may still take its place
             if (proc->quantum)
             {
                 p = proc;
-                p->quantum -= CLOCK_TICK_MS;
+                running_process[cpu] = p->pid;
             }
             else
             {
-                ready_queue->dequeue();
-                ready_queue->enqueue(proc->get_pid());
+                // It used up its quantum, it is CPU bound
+                if (proc->level < SCHED_LEVELS - 1)
+                    proc->level++;
                 RESET_QUANTUM(proc);
+                enqueue(proc);
             }
         }
     }
 
+    // Wake up processes that have been sleeping enough
+    check_for_processes_to_wake_up();
+    boost_if_due();
+
+    // Preempt the previous process if a process of a more favoured level is ready. It keeps what is left of its quantum
+    if (p && best_ready_level() < p->level)
+    {
+        running_process[cpu] = MAX_PROCESSES;
+        enqueue(p);
+        p = nullptr;
+    }
+
+    // Find next process to execute
+    while (p == nullptr)
+    {
+        const pid_t pid = dequeue();
+        if (pid == MAX_PROCESSES)
+            break;
+
+        Process* proc = processes[pid];
+        if (proc->is_terminated())
+        {
+            relinquish_process(proc);
+            continue;
+        }
+
+        if (!proc->quantum)
+            RESET_QUANTUM(proc);
+        p = proc;
+    }
+
+    if (p)
+    {
+        p->run_start = PIT::get_ms();
+        running_process[cpu] = p->pid;
+    }
+
     return p;
 }
 
-void Scheduler::relinquish_first_ready_process()
+void Scheduler::relinquish_process(Process* proc)
 {
-    pid_t pid = running_process = ready_queue->getFirst();
-    Process* proc = processes[pid];
-
-    // Do not dequeue to prevent from excluding the exec replacement from the ready queue
-    if (!(proc->flags & P_EXEC))
-        ready_queue->dequeue();
-
     // If process has no parent, free it rith away, or if it has been replaced
     if (proc->ppid == proc->pid)
     {
@@ -108,22 +142,166 @@ void Scheduler::relinquish_first_ready_process()
         free_terminated_process(*proc);
 }
 
-void Scheduler::set_first_ready_process_asleep_waiting_key_press()
+void Scheduler::make_ready(pid_t pid)
 {
-    pid_t pid = running_process = ready_queue->dequeue();
-    waiting_queue->enqueue(pid);
+    // A process getting ready has been waiting rather than using up its quantum, which is what interactive processes do
+    Process* p = processes[pid];
+    p->level = NICE_BASE_LEVEL(p->nice);
+    RESET_QUANTUM(p);
+    enqueue(p);
+
+    // An idle calling processor is about to look for a process to run, it will take this one
+    const uint self = SMP::get_cpu_id();
+    if (running_process[self] == MAX_PROCESSES && ready_levels == 1u << p->level &&
+        ready_queues[p->level].getCount() == 1)
+        return;
+
+    // Otherwise, wake an idle processor up rather than letting the process wait for a timer interrupt
+    for (uint cpu = 0; cpu < SMP::get_num_cpus(); cpu++)
+    {
+        if (cpu != self && running_process[cpu] == MAX_PROCESSES)
+        {
+            SMP::send_reschedule(cpu);
+            return;
+        }
+    }
+
+    // No processor is idle, preempt the one running the least favoured process, if it is less favoured than this one
+    uint target = MAX_CPUS;
+    uint target_level = p->level;
+    for (uint cpu = 0; cpu < SMP::get_num_cpus(); cpu++)
+    {
+        if (running_process[cpu] != MAX_PROCESSES && processes[running_process[cpu]]->level > target_level)
+        {
+            target = cpu;
+            target_level = processes[running_process[cpu]]->level;
+        }
+    }
+
+    // The calling processor checks whether it should preempt its process on its way out of the interrupt handler
+    if (target != MAX_CPUS && target != self)
+        SMP::send_reschedule(target);
 }
 
-void Scheduler::set_first_ready_process_asleep_waiting_process()
+void Scheduler::enqueue(Process* p)
 {
-    running_process = ready_queue->dequeue();
-    // Nothing else to do, the rest has already been done in register_process_wait
+    ready_queues[p->level].enqueue(p->pid);
+    ready_levels |= 1u << p->level;
 }
 
-void Scheduler::set_first_ready_process_asleep_waiting_read()
+pid_t Scheduler::dequeue()
 {
-    running_process = ready_queue->dequeue();
-    // Nothing else to do, the rest has already been done in register_process_wait
+    if (!ready_levels)
+        return MAX_PROCESSES;
+
+    const uint level = best_ready_level();
+    const pid_t pid = ready_queues[level].dequeue();
+    if (ready_queues[level].empty())
+        ready_levels &= ~(1u << level);
+
+    return pid;
+}
+
+uint Scheduler::best_ready_level()
+{
+    return ready_levels ? __builtin_ctz(ready_levels) : SCHED_LEVELS;
+}
+
+void Scheduler::boost_if_due()
+{
+    const uint now = PIT::get_ms();
+    if (now - last_boost_ms < SCHED_BOOST_PERIOD_MS)
+        return;
+    last_boost_ms = now;
+
+    for (Process* p : processes)
+        if (p)
+            p->level = NICE_BASE_LEVEL(p->nice);
+
+    // Move ready processes to the queue of their new level. Queues are drained most favoured level first, so that
+    // processes of a same level keep their relative order
+    pid_t ready[MAX_PROCESSES];
+    uint n = 0;
+    for (pid_t pid; (pid = dequeue()) != MAX_PROCESSES;)
+        ready[n++] = pid;
+    for (uint i = 0; i < n; i++)
+        enqueue(processes[ready[i]]);
+}
+
+void Scheduler::update_timer()
+{
+    const uint now = PIT::get_ms();
+    uint ms = 0; // No event to wake up for
+
+    if (const Process* p = get_running_process())
+    {
+        const uint ran = now - p->run_start;
+        ms = ran < p->quantum ? p->quantum - ran : 1;
+    }
+
+    if (SMP::get_cpu_id() == 0 && !sleeping_processes->empty())
+    {
+        const uint end_ms = sleeping_processes->min().end_ms;
+        const uint until = end_ms > now ? end_ms - now : 1;
+        if (!ms || until < ms)
+            ms = until;
+    }
+
+    // The PIT is only used until local APIC timers are set up, or if there is no local APIC
+    if (LAPIC::is_enabled())
+    {
+        if (ms)
+            LAPIC::start_oneshot(ms);
+        else
+            LAPIC::stop_timer();
+    }
+    else if (ms)
+    {
+        PIT::start_oneshot(ms);
+        PIC::enable_preemptive_scheduling();
+    }
+    else
+        PIC::disable_preemptive_scheduling();
+}
+
+bool Scheduler::should_preempt()
+{
+    const Process* p = get_running_process();
+
+    return p && best_ready_level() < p->level;
+}
+
+int Scheduler::set_nice(pid_t pid, int nice)
+{
+    Process* p = pid ? get_process(pid) : get_running_process();
+    if (!p || p->is_terminated())
+        return -ESRCH;
+
+    p->nice = max(NICE_MIN, min(nice, NICE_MAX));
+    // Takes effect the next time the process is queued
+    p->level = NICE_BASE_LEVEL(p->nice);
+
+    return 0;
+}
+
+int Scheduler::get_nice(pid_t pid, int* nice)
+{
+    const Process* p = pid ? get_process(pid) : get_running_process();
+    if (!p || p->is_terminated())
+        return -ESRCH;
+
+    *nice = p->nice;
+
+    return 0;
+}
+
+bool Scheduler::some_process_is_running()
+{
+    for (uint cpu = 0; cpu < SMP::get_num_cpus(); cpu++)
+        if (running_process[cpu] != MAX_PROCESSES)
+            return true;
+
+    return false;
 }
 
 void Scheduler::resume_process(Process* p)
@@ -132,7 +310,8 @@ void Scheduler::resume_process(Process* p)
     GDT::set_tss_kernel_stack(p->k_stack_top); // Todo: update k_stack_top somehow ?
     GDT::set_tls(p->tls_base); // Set process TLS address base in GDT TLS entry
 
-    // Use process' address space
+    // Use process' address space. Loading CR3 drops the lower half translations this processor cached when it last
+    // ran the process, which another processor may have changed since then
     Interrupts::change_pdt_asm(PHYS_ADDR(Memory::page_tables, (uint) p->pdt));
 
     // Write some values in process' address space (likely syscall return values)
@@ -179,75 +358,36 @@ void Scheduler::resume_user_process(Process* p)
 {
     signal_handling(p);
 
+    // The process is not touched by other processors until it gets back in the kernel, which takes the lock again
+    SMP::unlock_kernel();
     Interrupts::resume_user_process_asm(&p->cpu_state, &p->stack_state);
 }
 
-void Scheduler::do_read_wait(pid_t process_pid, int fd, size_t n)
-{
-    processes_waiting_for_read->add({process_pid, fd, n, 0});
-    processes[process_pid]->set_flag(P_WAITING_READ);
-
-    TRIGGER_TIMER_INTERRUPT
-}
-
-void Scheduler::wake_up_read_waiting_processes(int write_fd, int read_fd, int count)
-{
-    if (write_fd == -1 || read_fd == -1)
-        irrecoverable_error("%s: write fd or read fd is -1", __FUNCTION__);
-
-    list<proc_waiting_for_read> to_be_resumed{};
-    for (auto& pwfr : *processes_waiting_for_read)
-    {
-        if (pwfr.fd != write_fd)
-            continue;
-
-        size_t remaining = pwfr.request - pwfr.read_so_far;
-        size_t c = min(remaining, (size_t)count);
-        pwfr.read_so_far += c;
-
-        if (pwfr.read_so_far == pwfr.request || !VFS::file_descriptors[read_fd]->should_wait_for_data_on_read())
-            to_be_resumed.add(pwfr);
-    }
-
-    // A second loop is required to remove entries so that we do not modify the list as we walk through it
-    for (const auto tbr : to_be_resumed)
-    {
-        processes_waiting_for_read->remove(tbr);
-        Process* proc = processes[tbr.pid];
-        proc->flags &= ~P_WAITING_READ;
-        ready_queue->enqueue(proc->pid);
-    }
-}
-
 [[noreturn]]
 void Scheduler::schedule()
 {
-    // Wake up processes that have been sleeping enough
-    check_for_processes_to_wake_up();
-
     Process* p = get_next_process();
+    const uint cpu = SMP::get_cpu_id();
+    update_timer();
 
     if (p == nullptr)
     {
-        if (waiting_queue->empty() && sleeping_processes->empty())
+        if (Keyboard::wait_queue.empty() && sleeping_processes->empty() && !some_process_is_running())
             System::shutdown();
-        else
-        {
-            // All processes are waiting for a key press. Thus, we can halt the CPU
-            running_process = MAX_PROCESSES; // Indicate that no process is running
 
-            __asm__ volatile("mov %0, %%esp" : : "r"(Memory::get_stack_top_ptr())); // Use global kernel stack
-            __asm__ volatile("sti"); // Make sure interrupts are enabled
-            __asm__ volatile("hlt"); // Halt
-        }
+        // All processes are waiting or run by other processors. Thus, we can halt the CPU
 
-        irrecoverable_error("%s: unreachable called has been reached!", __PRETTY_FUNCTION__);
+        // Make use of idle time to prepare zeroed frames for page faults to come
+        Memory::ZeroedFramePool::refill(Memory::ZeroedFramePool::IDLE_REFILL_BATCH);
+
+        // The current stack may be the one of a process another processor is about to resume
+        SMP::unlock_kernel_and_halt(stack_switch_stack_tops[cpu]);
     }
 
     if (!p) // Although theoretically impossible, this happens sometimes, I'd like to know why
         irrecoverable_error("%s: no process to run", __func__);
 
-    switch_stack_and_call_process_function(stack_switch_stack_top, resume_process, p);
+    switch_stack_and_call_process_function(stack_switch_stack_tops[cpu], resume_process, p);
 }
 
 void Scheduler::start_module([[maybe_unused]] uint module, [[maybe_unused]] pid_t ppid, [[maybe_unused]] int argc, [[maybe_unused]] const char** argv)
@@ -325,60 +465,74 @@ void Scheduler::init()
     PIT::init();
     Process::init();
 
-    uint stack_switch_pe = Memory::get_free_pe();
-    Memory::allocate_page(stack_switch_pe, DEFAULT_K_POLICY);
-    stack_switch_stack_top = (void*)((stack_switch_pe << 12) + PAGE_SIZE - sizeof(uint)); // Stack top is at the end of the page
+    for (uint cpu = 1; cpu < MAX_CPUS; cpu++)
+        running_process[cpu] = MAX_PROCESSES;
+    init_cpu(0);
 
     // Those have to be pointers because they cannot be instantiated at program start since dynamic memory allocation
     // is not available at this moment. However, it is ok to allocate them now.
-    ready_queue = new queue<pid_t, MAX_PROCESSES>();
-    waiting_queue = new queue<pid_t, MAX_PROCESSES>();
+    ready_queues = new queue<pid_t, MAX_PROCESSES>[SCHED_LEVELS];
     sleeping_processes = new MinHeap<asleep_process>(MAX_PROCESSES);
-    processes_waiting_for_read  = new list<proc_waiting_for_read>();
 
-    set_process_ready(Memory::kernel_process);
+    // The kernel process is running, thus not in the ready queue
+    RESET_QUANTUM(Memory::kernel_process);
+    Memory::kernel_process->run_start = PIT::get_ms();
+    update_timer();
+}
+
+void* Scheduler::init_cpu(uint cpu)
+{
+    if (stack_switch_stack_tops[cpu])
+        return stack_switch_stack_tops[cpu];
 
-    PIC::enable_preemptive_scheduling();
+    uint stack_switch_pe = Memory::get_free_pe();
+    Memory::allocate_page(stack_switch_pe, DEFAULT_K_POLICY);
+    stack_switch_stack_tops[cpu] = (void*)((stack_switch_pe << 12) + PAGE_SIZE - sizeof(uint)); // Stack top is at the end of the page
+
+    return stack_switch_stack_tops[cpu];
 }
 
 void Scheduler::shutdown()
 {
-    delete ready_queue;
-    delete waiting_queue;
+    delete[] ready_queues;
     delete sleeping_processes;
-    delete processes_waiting_for_read;
 }
 
 pid_t Scheduler::get_running_process_pid()
 {
-    return running_process;
+    return running_process[SMP::get_cpu_id()];
 }
 
 Process* Scheduler::get_running_process()
 {
-    return running_process == MAX_PROCESSES ? nullptr : processes[running_process];
+    const pid_t pid = get_running_process_pid();
+    return pid == MAX_PROCESSES ? nullptr : processes[pid];
 }
 
-void Scheduler::wake_up_key_waiting_processes(char key)
+bool Scheduler::is_running(pid_t pid)
 {
-    for (uint i = 0; i < waiting_queue->getCount(); ++i)
-    {
-        // Add process to ready queue and remove it from waiting queue
-        pid_t pid = waiting_queue->dequeue();
-        ready_queue->enqueue(pid);
+    for (uint cpu = 0; cpu < SMP::get_num_cpus(); cpu++)
+        if (running_process[cpu] == pid)
+            return true;
 
-        processes[pid]->cpu_state.eax = (uint)key; // Return key
-        processes[pid]->flags &= ~P_WAITING_KEY; // Clear flag
-    }
+    return false;
+}
+
+void Scheduler::wake_up(Process* p)
+{
+    if (!is_running(p->pid))
+        make_ready(p->pid);
 }
 
 void Scheduler::set_process_ready(Process* p)
 {
     if (processes[p->pid] && processes[p->pid]->pid != p->pid)
         irrecoverable_error("%s: a different process is registered at this pid", __func__);
+    if (p->pdt != Memory::pdt)
+        Memory::copy_kernel_pdes(p->pdt); // Kernel PDEs may have changed since it was built
     processes[p->pid] = p;
-    ready_queue->enqueue(p->pid);
     RESET_QUANTUM(processes[p->pid]);
+    make_ready(p->pid);
 }
 
 void Scheduler::release_pid(pid_t pid)
@@ -388,17 +542,17 @@ void Scheduler::release_pid(pid_t pid)
 
 void Scheduler::check_for_processes_to_wake_up()
 {
-    uint tick = PIT::get_tick();
+    const uint now = PIT::get_ms();
     while (!sleeping_processes->empty())
     {
         auto sleeping_process = sleeping_processes->min();
-        if (sleeping_process.end_tick <= tick)
+        if (sleeping_process.end_ms <= now)
         {
             // Add process to ready queue and remove it from sleeping list
             pid_t pid = sleeping_process.process->pid;
-            ready_queue->enqueue(pid);
             processes[pid]->flags &= ~P_SLEEPING; // Clear flag
             sleeping_processes->delete_min();
+            make_ready(pid);
         }
         else
             break;
@@ -407,12 +561,6 @@ void Scheduler::check_for_processes_to_wake_up()
 
 Process* Scheduler::load_process(const char* path, pid_t pid, pid_t ppid, int argc, const char** argv, const char** envp, bool use_path_if_no_beginning_slash)
 {
-    if (ready_queue->full())
-    {
-        printf_error("Max process are already running");
-        return nullptr;
-    }
-
     const auto file = VFS::browse_to(path, use_path_if_no_beginning_slash);
     if (!file)
         return nullptr;
@@ -434,18 +582,15 @@ void Scheduler::create_kernel_init_process(void* process_host_mem, const uint lo
     kernel->lowest_free_pe = lowest_free_pe;
 
     // Setup ourselves as if this was the actual kernel process
-    running_process = pid;
+    running_process[SMP::get_cpu_id()] = pid;
     processes[pid] = kernel;
     *kernel_process = kernel; // kernel_process is used in malloc, so this is necessary
 
     // Now we can properly construct the process
     stack_state_t dummy_stack_state{};
-    uint lwfpe = lowest_free_pe;
-    Memory::lowest_free_pe = &lwfpe;
     Process* k = new (process_host_mem) Process(nullptr, 0, Memory::page_tables, Memory::pdt, &dummy_stack_state,
                          1, pid, pid, ELF32_ADDR_ERR);
-    k->lowest_free_pe = lwfpe;
-    Memory::lowest_free_pe = &k->lowest_free_pe;
+    k->lowest_free_pe = lowest_free_pe;
 
     // Write result
     *kernel_process = k;
@@ -453,18 +598,14 @@ void Scheduler::create_kernel_init_process(void* process_host_mem, const uint lo
 
 void Scheduler::wake_up_process_parent(pid_t process_pid)
 {
-    pid_t curr_pid = get_running_process_pid();
     pid_t ppid = processes[process_pid]->ppid;
     auto waiting_process = processes[ppid];
 
-    // Resume process, unless it's the current process, in which case it is already in the ready queue
-    if (ppid != curr_pid)
-        ready_queue->enqueue(ppid);
+    // Resume process. It is not waiting if it is the one freeing its zombie child
+    waiting_process->children_wait_queue.wake_all();
     // waitpid return value.
     if (auto wstatus_addr = (int*)waiting_process->cpu_state.esi)
         waiting_process->values_to_write.add({wstatus_addr, processes[process_pid]->ret_status});
-    // Clear flag
-    waiting_process->flags &= ~P_WAITING_PROCESS;
     // Set return value
     waiting_process->cpu_state.eax = process_pid;
     // Remove child
@@ -567,16 +708,9 @@ void Scheduler::free_terminated_process(Process& p)
 
 void Scheduler::stop_kernel_init_process()
 {
-    // Prune kernel process from ready queue
-    PIC::disable_preemptive_scheduling();
-    size_t n = ready_queue->getCount();
-    for (size_t i = 0; i < n; i++)
-    {
-        auto pid = ready_queue->dequeue();
-        if (pid != 0)
-            ready_queue->enqueue(pid);
-    }
-    PIC::enable_preemptive_scheduling();
+    // The kernel process is running, thus not in the ready queue. Forgetting it is running is enough for the
+    // scheduler to never see it again. Should an interrupt come in between, it would schedule another process as well
+    running_process[SMP::get_cpu_id()] = MAX_PROCESSES;
 
     // We asked for termination of kernel init process.
     // It is this precise process running those instructions.
@@ -608,7 +742,7 @@ int Scheduler::register_process_wait(pid_t waiting_process, pid_t waited_for_pro
         {
             // Register the wait for any child
             processes[waiting_process]->is_waiting_for_any_child_to_terminate = true;
-            processes[waiting_process]->set_flag(P_WAITING_PROCESS);
+            p->children_wait_queue.add(p);
             return 0;
         }
         return -ECHILD; // No child to wait for
@@ -627,18 +761,19 @@ int Scheduler::register_process_wait(pid_t waiting_process, pid_t waited_for_pro
         return waited_for_process;
     }
 
-    processes[waiting_process]->set_flag(P_WAITING_PROCESS);
+    p->children_wait_queue.add(p);
     return 0;
 }
 
 void Scheduler::set_process_asleep(Process* p, uint duration)
 {
     p->set_flag(P_SLEEPING);
-    uint num_ticks_to_wait = (uint)((float)TICKS_PER_SEC * (float)duration / 1000.f);
-    if (!num_ticks_to_wait)
-        num_ticks_to_wait = 1;
-    uint end_tick = PIT::get_tick() + num_ticks_to_wait;
-    sleeping_processes->insert({p, end_tick});
+    sleeping_processes->insert({p, PIT::get_ms() + duration});
+
+    // The bootstrap processor wakes sleeping processes up, it has to program its timer for this deadline if it is the
+    // closest one. If it is the calling processor, it will once the process calls the scheduler
+    if (SMP::get_cpu_id() != 0 && sleeping_processes->min().process == p)
+        SMP::send_reschedule(0);
 }
 
 void Scheduler::start_kernel_process(void* eip)
@@ -2,13 +2,23 @@
 #define CUSTOM_OS_SCHEDULER_H
 
 #include "process.h"
+#include "../core/SMP.h"
 #include "../utils/min_heap.h"
 #include "../utils/queue.h"
 
 // Maximum concurrent processes. Limit defined by size of pid_pool
 #define MAX_PROCESSES (sizeof(uint) * 8)
 
-#define RESET_QUANTUM(p) (p->quantum = p->priority * CLOCK_TICK_MS)
+#define SCHED_LEVELS 16 // Multi-level feedback queue levels, 0 being the most favoured one
+#define NICE_MIN (-20)
+#define NICE_MAX 19
+#define NICE_BASE_LEVEL(nice) (((nice) - NICE_MIN) / 5) // Level a process starts from. Nice 0 gives level 4
+#define SCHED_BOOST_PERIOD_MS 1000 // Period at which every process is brought back to its base level
+#define QUANTUM_SLACK_MS 1 // Timers are not precise to the millisecond, a quantum nearly used up is considered used up
+
+// Lower levels get longer quanta, as their processes are CPU bound and less often preempted
+#define LEVEL_QUANTUM_MS(level) (CLOCK_TICK_MS * (1 + (level) / 4))
+#define RESET_QUANTUM(p) (p->quantum = p->priority * LEVEL_QUANTUM_MS(p->level))
 
 class Scheduler
 {
@@ -17,49 +27,81 @@ private:
 	// Thus, 32 = sizeof(uint) PIDs are available, allowing up to 32 processes to run concurrently
 	static uint pid_pool;
 
-	// Represents a sleeping process. Comparison is done using  end tick in order to sort them in a min heap,
+	// Represents a sleeping process. Comparison is done using end time in order to sort them in a min heap,
 	// so that we only need to check the first process in the heap to know if there are processes to wake up
 	struct asleep_process
 	{
 		Process* process;
-		uint end_tick;
+		uint end_ms; // Time (PIT::get_ms) at which the process has to be woken up
 		bool operator<(const asleep_process& other) const
 		{
-			return end_tick < other.end_tick;
+			return end_ms < other.end_ms;
 		}
 		bool operator>(const asleep_process& other) const
 		{
-			return end_tick > other.end_tick;
+			return end_ms > other.end_ms;
 		}
 	};
 
-	struct proc_waiting_for_read
-	{
-		pid_t pid;
-		int fd;
-		size_t request, read_so_far;
-
-		bool operator==(const proc_waiting_for_read& other) const {return other.pid == pid && fd == other.fd; }
-	};
-
-	static pid_t running_process;
-	static queue<pid_t, MAX_PROCESSES>* ready_queue;
-	static queue<pid_t, MAX_PROCESSES>* waiting_queue;
-	static list<proc_waiting_for_read>* processes_waiting_for_read;
+	static pid_t running_process[MAX_CPUS]; // Process run by each processor, MAX_PROCESSES if idle
+	// Runnable processes waiting for a processor, one queue per level. Running processes are not in there
+	static queue<pid_t, MAX_PROCESSES>* ready_queues;
+	static uint ready_levels; // Bitmap of non-empty ready queues. Ith LSB is set if level i has a process
+	static uint last_boost_ms; // Time (PIT::get_ms) at which processes were last brought back to their base level
 	static Process* processes[MAX_PROCESSES];
 	static MinHeap<asleep_process>* sleeping_processes;
 
 	/**
-	 * Round-robin scheduler
+	 * Multi-level feedback queue scheduler. Puts away the process the calling processor was running, and picks the one
+	 * it runs next, round-robin within the most favoured non-empty level.
+	 *
+	 * A process using up its quantum is moved one level down, a process waking up goes back to the level set by its
+	 * nice value, so that interactive processes get ahead of CPU bound ones. Every SCHED_BOOST_PERIOD_MS, all
+	 * processes go back to their base level, so that lowered ones do not starve.
 	 * @return next process to run, NULL if there is no process to run
 	 */
 	static Process* get_next_process();
 
+	/**
+	 * Adds a process to the ready queue of its level
+	 * @param p process to add
+	 */
+	static void enqueue(Process* p);
+
+	/**
+	 * Removes the first process of the most favoured non-empty level
+	 * @return removed process' PID, MAX_PROCESSES if there is no ready process
+	 */
+	static pid_t dequeue();
+
+	/** Most favoured level having a ready process, SCHED_LEVELS if there is none */
+	[[nodiscard]] static uint best_ready_level();
+
+	/** Brings every process back to its base level, if it has not been done for SCHED_BOOST_PERIOD_MS */
+	static void boost_if_due();
+
+	/**
+	 * Frees a terminated process, or makes it a zombie if its parent may still wait for it
+	 * @param proc terminated process, which must not be in any scheduler queue
+	 */
+	static void relinquish_process(Process* proc);
+
+	/**
+	 * Adds a process to the ready queue, at its base level, and wakes an idle processor up to run it. If there is none,
+	 * a processor running a process of a lower level is asked to preempt it
+	 * @param pid process to run
+	 */
+	static void make_ready(pid_t pid);
+
+	/** Whether some processor is running a process */
+	[[nodiscard]] static bool some_process_is_running();
+
 	static void release_pid(pid_t pid);
 
 	static void check_for_processes_to_wake_up();
 
-	static void* stack_switch_stack_top;
+	// Stack of each processor to run the scheduler on, and to halt on when there is nothing to run
+	static void* stack_switch_stack_tops[MAX_CPUS];
 
 	static Process* load_process(const char* path, pid_t pid, pid_t ppid, int argc, const char** argv, const char** envp, bool use_path_if_no_beginning_slash);
 
@@ -99,29 +141,63 @@ public:
 
 	static void init();
 
+	/**
+	 * Allocates the scheduling stack of a processor, unless it is already allocated
+	 * @param cpu processor index
+	 * @return stack top
+	 */
+	static void* init_cpu(uint cpu);
+
 	static void shutdown();
 
 	static pid_t get_running_process_pid();
 
 	static Process* get_running_process();
 
-	static void wake_up_key_waiting_processes(char key);
+	/** Whether a process is being run by any processor */
+	[[nodiscard]] static bool is_running(pid_t pid);
 
-	static void set_process_ready(Process* p);
+	/**
+	 * Makes a process woken up from a wait queue ready. A process woken up before it got back to the scheduler
+	 * is still running, and is left alone
+	 * @param p process removed from its wait queue
+	 */
+	static void wake_up(Process* p);
 
-	static void free_terminated_process(Process& p);
+	/** Whether a process of a more favoured level than the one the calling processor runs is ready */
+	[[nodiscard]] static bool should_preempt();
 
-	static void set_first_ready_process_asleep_waiting_key_press();
+	/**
+	 * Programs the one-shot timer of the calling processor to fire at the next event it has to handle: the end of the
+	 * quantum of its process, or the earliest sleeping process deadline for the bootstrap processor, which wakes
+	 * sleeping processes up. It is stopped if there is no such event, an idle processor then sleeps until an interrupt
+	 * comes
+	 */
+	static void update_timer();
 
-	static void set_first_ready_process_asleep_waiting_process();
+	/**
+	 * Changes the nice value of a process
+	 * @param pid process PID, 0 for the calling process
+	 * @param nice new nice value, clamped to [NICE_MIN, NICE_MAX]
+	 * @return 0 on success, -errno on error
+	 */
+	static int set_nice(pid_t pid, int nice);
 
-	static void set_first_ready_process_asleep_waiting_read();
+	/**
+	 * Gets the nice value of a process
+	 * @param pid process PID, 0 for the calling process
+	 * @param nice where to write the nice value
+	 * @return 0 on success, -errno on error
+	 */
+	static int get_nice(pid_t pid, int* nice);
 
-	static void relinquish_first_ready_process();
+	static void set_process_ready(Process* p);
+
+	static void free_terminated_process(Process& p);
 
 	/**
 	 * Stop kernel initialization process, leaving only potential user programs
-	 * in the waiting queue
+	 * in the scheduler queues
 	 */
 	static void stop_kernel_init_process();
 
@@ -146,10 +222,6 @@ public:
 
 	[[noreturn]]
 	static void resume_user_process(Process* p);
-
-	static void do_read_wait(pid_t process_pid, int fd, size_t n);
-
-	static void wake_up_read_waiting_processes(int write_fd, int read_fd, int count);
 };
 
 
@@ -1,21 +1,22 @@
 #include "TmpString.h"
-#include "../core/SlabAlloc.h"
+
+#include <kstring.h>
 
 TmpString::TmpString(uint size) : size(size)
 {
-    data = Memory::slab_allocate(size);
+    data = new char[size];
     data[0] = '\0';
 }
 
 TmpString::~TmpString()
 {
-    Memory::slab_deallocate(data, size);
+    delete[] data;
 }
 
 TmpString::TmpString(const TmpString& other)
     : size(other.size)
 {
-    data = Memory::slab_allocate(size);
+    data = new char[size];
     memcpy(data, other.data, size);
 }
 
@@ -24,10 +25,10 @@ TmpString& TmpString::operator=(const TmpString& other)
     if (this == &other)
         return *this;
 
-    Memory::slab_deallocate(data, size);
+    delete[] data;
 
     size = other.size;
-    data = Memory::slab_allocate(size);
+    data = new char[size];
     memcpy(data, other.data, size);
 
     return *this;
@@ -45,7 +46,7 @@ TmpString& TmpString::operator=(TmpString&& other) noexcept
     if (this == &other)
         return *this;
 
-    Memory::slab_deallocate(data, size);
+    delete[] data;
 
     size = other.size;
     data = other.data;
@@ -64,15 +65,14 @@ char* TmpString::operator*() const
 TmpString& TmpString::concat(const TmpString& other)
 {
     char* original_data = data;
-    const uint original_size = size;
 
     size += other.size;
-    char* new_data = Memory::slab_allocate(size);
+    char* new_data = new char[size];
     strcpy(new_data, data);
     strcat(new_data, *other);
     data = new_data;
 
-    Memory::slab_deallocate(original_data, original_size);
+    delete[] original_data;
 
     return *this;
 }
\ No newline at end of file
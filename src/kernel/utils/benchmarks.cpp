@@ -0,0 +1,196 @@
+#ifdef BENCHMARKS
+
+#include "benchmarks.h"
+
+#include "../core/fb.h"
+#include "../core/memory.h"
+#include "../core/Kmalloc.h"
+#include "../core/KmemCache.h"
+#include "../core/PIT.h"
+#include "../core/RawMemory.h"
+#include "../core/system.h"
+
+namespace Benchmarks
+{
+    static uint rand_state = 42;
+
+    /** Cheap deterministic pseudo random numbers, so that runs are comparable */
+    static uint next_rand()
+    {
+        rand_state = rand_state * 1103515245 + 12345;
+        return rand_state >> 16;
+    }
+
+    static void report(const char* name, uint num_ops, uint64_t cycles)
+    {
+        const uint ns_per_op = (uint)(cycles * 1000 / PIT::get_tsc_ticks_per_us() / num_ops);
+        printf_info("%s: %u ops, %u ns/op", name, num_ops, ns_per_op);
+    }
+
+    void run()
+    {
+        memtree();
+        kmem_cache();
+        kmalloc();
+        large_pages();
+    }
+
+    void memtree()
+    {
+        constexpr uint N = 100000;
+        constexpr uint STRIDE = 7919; // Prime with N, used to free blocks in a scattered order
+        constexpr uint MAX_SIZE = 256;
+
+        auto addresses = new uintptr_t[N];
+        Memory::MemTree tree;
+        Process* process = Memory::kernel_process;
+
+        // Fill the tree
+        uint64_t start = System::rdtsc();
+        for (uint i = 0; i < N; i++)
+            addresses[i] = (uintptr_t)tree.allocate(1 + next_rand() % MAX_SIZE, Memory::DEFAULT_K_PAGE_INFO, process);
+        report("memtree alloc", N, System::rdtsc() - start);
+
+        // Punch holes everywhere, then fill them back
+        start = System::rdtsc();
+        for (uint i = 0; i < N; i += 2)
+            (void)tree.free(addresses[i], process);
+        for (uint i = 0; i < N; i += 2)
+            addresses[i] = (uintptr_t)tree.allocate(1 + next_rand() % MAX_SIZE, Memory::DEFAULT_K_PAGE_INFO, process);
+        report("memtree churn", N, System::rdtsc() - start);
+
+        // Empty the tree
+        start = System::rdtsc();
+        for (uint i = 0; i < N; i++)
+            (void)tree.free(addresses[(i * STRIDE) % N], process);
+        report("memtree free", N, System::rdtsc() - start);
+
+        tree.free_all(process);
+        delete[] addresses;
+    }
+
+    void kmem_cache()
+    {
+        constexpr uint N = 100000;
+        constexpr uint BATCH = 1000; // Objects alive at the same time
+        struct object
+        {
+            char data[48]; // Around the size of list nodes, sockets, dentries...
+        };
+
+        auto objects = new object*[BATCH];
+
+        uint64_t start = System::rdtsc();
+        for (uint i = 0; i < N; i += BATCH)
+        {
+            for (uint j = 0; j < BATCH; j++)
+                objects[j] = new object;
+            for (uint j = 0; j < BATCH; j++)
+                delete objects[j];
+        }
+        report("new/delete", N, System::rdtsc() - start);
+
+        Memory::KmemCache* cache = Memory::KmemCache::create("benchmark", sizeof(object), alignof(object));
+        start = System::rdtsc();
+        for (uint i = 0; i < N; i += BATCH)
+        {
+            for (uint j = 0; j < BATCH; j++)
+                objects[j] = static_cast<object*>(cache->alloc());
+            for (uint j = 0; j < BATCH; j++)
+                cache->free(objects[j]);
+        }
+        report("kmem_cache alloc/free", N, System::rdtsc() - start);
+
+        delete[] objects;
+    }
+
+    void kmalloc()
+    {
+        constexpr uint N = 100000;
+        constexpr uint BATCH = 1000; // Blocks alive at the same time
+        constexpr uint MAX_SIZE = 512;
+
+        auto blocks = new void*[BATCH];
+        Process* process = Memory::kernel_process;
+
+        uint64_t start = System::rdtsc();
+        for (uint i = 0; i < N; i += BATCH)
+        {
+            for (uint j = 0; j < BATCH; j++)
+                blocks[j] = ::malloc(1 + next_rand() % MAX_SIZE, Memory::DEFAULT_K_PAGE_INFO, process);
+            for (uint j = 0; j < BATCH; j++)
+                (void)::free(blocks[j], process);
+        }
+        report("memtree malloc/free", N, System::rdtsc() - start);
+
+        const uint requested_bytes = Memory::Kmalloc::get_requested_bytes();
+        const uint allocated_bytes = Memory::Kmalloc::get_allocated_bytes();
+        start = System::rdtsc();
+        for (uint i = 0; i < N; i += BATCH)
+        {
+            for (uint j = 0; j < BATCH; j++)
+                blocks[j] = Memory::Kmalloc::alloc(1 + next_rand() % MAX_SIZE);
+            for (uint j = 0; j < BATCH; j++)
+                Memory::Kmalloc::free(blocks[j]);
+        }
+        report("kmalloc/kfree", N, System::rdtsc() - start);
+        const uint requested = Memory::Kmalloc::get_requested_bytes() - requested_bytes;
+        const uint allocated = Memory::Kmalloc::get_allocated_bytes() - allocated_bytes;
+        printf_info("kmalloc rounding: %u%% of %u bytes", (allocated - requested) / (allocated / 100), allocated);
+
+        delete[] blocks;
+    }
+
+    /** Copies buffers and redraws the screen */
+    static void large_pages_run(const char* mapping, char* src, char* dst, uint size)
+    {
+        constexpr uint N_COPIES = 16;
+        constexpr uint N_REDRAWS = 16;
+
+        printf_info("kernel mapped with %s:", mapping);
+
+        uint64_t start = System::rdtsc();
+        for (uint i = 0; i < N_COPIES; i++)
+            memcpy(dst, src, size);
+        report("memcpy 4 MiB", N_COPIES, System::rdtsc() - start);
+
+        start = System::rdtsc();
+        for (uint i = 0; i < N_REDRAWS; i++)
+            FB::redraw();
+        report("FB redraw", N_REDRAWS, System::rdtsc() - start);
+    }
+
+    void large_pages()
+    {
+        constexpr uint SIZE = PT_ENTRIES * PAGE_SIZE; // One large page
+
+        auto src = (char*)Memory::large_page_malloc(SIZE);
+        auto dst = (char*)Memory::large_page_malloc(SIZE);
+        if (!src || !dst)
+        {
+            printf_warn("large pages benchmark: not enough memory");
+            return;
+        }
+        memset(src, 0x42, SIZE);
+        memset(dst, 0, SIZE);
+
+        large_pages_run("large pages", src, dst, SIZE);
+
+        // Split every large page but the kernel image, then restore them
+        bool split[PDT_ENTRIES]{};
+        for (uint pde = ADDR_PDE(KERNEL_VIRTUAL_BASE) + 1; pde < PDT_ENTRIES; pde++)
+        {
+            split[pde] = Memory::pdt->entries[pde] & PAGE_LARGE;
+            Memory::split_large_page(pde);
+        }
+        large_pages_run("4 KiB pages", src, dst, SIZE);
+        for (uint pde = 0; pde < PDT_ENTRIES; pde++)
+            if (split[pde])
+                Memory::map_large_page(pde);
+
+        Memory::large_page_free(src, SIZE);
+        Memory::large_page_free(dst, SIZE);
+    }
+}
+
+#endif
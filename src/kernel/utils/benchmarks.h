@@ -0,0 +1,26 @@
+#ifdef BENCHMARKS
+
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+#include <stdint.h>
+
+namespace Benchmarks
+{
+    /** Runs every kernel benchmark and prints the results */
+    void run();
+
+    /** Allocates and frees 100k blocks of various sizes in a memory tree */
+    void memtree();
+
+    /** Allocates and frees 100k small objects, with new/delete and with an object cache */
+    void kmem_cache();
+
+    /** Allocates and frees 100k blocks of various small sizes, with size classes and with the memory tree */
+    void kmalloc();
+
+    /** Copies 4 MiB buffers and redraws the screen, with and without 4 MiB pages */
+    void large_pages();
+}
+#endif //BENCHMARKS_H
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef INCLUDE_LIST_H
 #define INCLUDE_LIST_H
 
+#include "../core/KmemCache.h"
+
 template<class E>
 class list {
 
@@ -13,6 +15,8 @@ private:
 		Node();
 
 		explicit Node(const E& val);
+
+		KMEM_CACHE_ALLOCATED(Node, "list_node")
 	};
 
     Node *head;
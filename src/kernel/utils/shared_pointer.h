@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../core/KmemCache.h"
+
 template <typename T>
 class SharedPointer
 {
@@ -156,6 +158,11 @@ private:
     element_type* data_;
     // A counter shared between all ref pointers to \a data_.
     long* count_;
+
+    // Counters are allocated from a dedicated object cache
+    static Memory::KmemCache* count_cache();
+    static long* new_count();
+    static void delete_count(long* count);
 };
 
 #include "shared_pointer.hxx"
@@ -2,10 +2,33 @@
 
 #include "shared_pointer.h"
 
+template <typename T>
+Memory::KmemCache* SharedPointer<T>::count_cache()
+{
+    static Memory::KmemCache* cache = nullptr;
+    if (!cache)
+        cache = Memory::KmemCache::create("shared_ptr_count", sizeof(long), alignof(long));
+    return cache;
+}
+
+template <typename T>
+long* SharedPointer<T>::new_count()
+{
+    auto count = static_cast<long*>(count_cache()->alloc());
+    *count = 1;
+    return count;
+}
+
+template <typename T>
+void SharedPointer<T>::delete_count(long* count)
+{
+    count_cache()->free(count);
+}
+
 template <typename T>
 SharedPointer<T>::SharedPointer(element_type* p)
     : data_(p)
-    , count_(p == nullptr ? nullptr : new long{ 1 })
+    , count_(p == nullptr ? nullptr : new_count())
 {}
 
 template <typename T>
@@ -16,7 +39,7 @@ SharedPointer<T>::~SharedPointer()
         if (--(*count_) == 0)
         {
             delete data_;
-            delete count_;
+            delete_count(count_);
         }
     }
 }
@@ -40,11 +63,11 @@ void SharedPointer<T>::reset(element_type* p)
         if (--(*count_) == 0)
         {
             delete data_;
-            delete count_;
+            delete_count(count_);
         }
     }
     data_ = p;
-    count_ = p == nullptr ? nullptr : new long(1);
+    count_ = p == nullptr ? nullptr : new_count();
 }
 
 template <typename T>
@@ -55,7 +78,7 @@ SharedPointer<T>& SharedPointer<T>::operator=(const SharedPointer& other)
         if (--(*count_) == 0)
         {
             delete data_;
-            delete count_;
+            delete_count(count_);
         }
     }
     data_ = other.data_;
@@ -129,7 +152,7 @@ SharedPointer<T>::operator=(SharedPointer&& other) noexcept
             if (--(*count_) == 0)
             {
                 delete data_;
-                delete count_;
+                delete_count(count_);
             }
         }
         data_ = other.data_;
@@ -33,6 +33,34 @@ void get_screen_dimensions(unsigned int* width, unsigned int* height)
 	*height = h;
 }
 
+unsigned int get_buddy_info(unsigned int* counts, unsigned int n)
+{
+	unsigned int written;
+	__asm__ volatile("int $0x80" : "=a"(written) : "a"(51), "D"(counts), "S"(n) : "memory");
+	return written;
+}
+
+unsigned int get_mem_stats(unsigned int* stats, unsigned int n)
+{
+	unsigned int written;
+	__asm__ volatile("int $0x80" : "=a"(written) : "a"(52), "D"(stats), "S"(n) : "memory");
+	return written;
+}
+
+unsigned int get_slab_info(struct kmem_cache_info* infos, unsigned int n)
+{
+	unsigned int written;
+	__asm__ volatile("int $0x80" : "=a"(written) : "a"(53), "D"(infos), "S"(n) : "memory");
+	return written;
+}
+
+unsigned int get_timer_interrupts()
+{
+	unsigned int count;
+	__asm__ volatile("int $0x80" : "=a"(count) : "a"(61));
+	return count;
+}
+
 void libk_force_link()
 {
 }
@@ -20,6 +20,74 @@ void unlock_framebuffer_flush();
 
 void get_screen_dimensions(unsigned int* width, unsigned int* height);
 
+/**
+ * Gets the number of free physical memory blocks of each order (block of order k spans 2^k frames)
+ * @param counts buffer to write counts in
+ * @param n number of entries in counts
+ * @return number of entries written
+ */
+unsigned int get_buddy_info(unsigned int* counts, unsigned int n);
+
+/** Memory statistics, indices of get_mem_stats' buffer */
+enum mem_stat
+{
+	MEM_STAT_ZERO_FRAME_MAPPINGS, // Pages currently mapping the shared zero frame, ie frames saved
+	MEM_STAT_ZERO_FRAME_FAULTS, // Read faults handled by mapping the shared zero frame
+	MEM_STAT_ZEROED_POOL_FRAMES, // Frames currently in the pre-zeroed frame pool
+	MEM_STAT_ZEROED_POOL_HITS, // Page faults served with a pre-zeroed frame
+	MEM_STAT_ZEROED_POOL_MISSES, // Page faults that had to zero a frame
+	MEM_STAT_FAULT_AROUND_PAGES, // Pages allocated ahead of time by fault-around, ie page faults saved
+	MEM_STAT_PROCESS_PAGE_FAULTS, // Page faults taken by the calling process
+	MEM_STAT_KMALLOC_ALLOCATIONS, // Small kernel blocks allocated from size classes since boot
+	MEM_STAT_KMALLOC_REQUESTED_BYTES, // Bytes asked for by those allocations
+	MEM_STAT_KMALLOC_ALLOCATED_BYTES, // Bytes handed out for those allocations, size class rounding included
+	MEM_STAT_FILE_PAGE_FAULTS, // Faults on file-backed pages (program text and data), each reading a readahead window
+	MEM_STAT_FILE_PAGES_READ, // File-backed pages read from their file, ie program pages actually used
+	MEM_STAT_PAGE_CACHE_PAGES, // File pages currently cached, shared by the processes mapping them
+	MEM_STAT_PAGE_CACHE_HITS, // File pages mapped from the cache, each of them a read and a frame saved
+	MEM_STAT_ELF_IMAGE_CACHE_HITS, // Execs (and their interpreter) that found the ELF already parsed
+	MEM_STAT_ELF_IMAGE_CACHE_MISSES, // ELF files read and parsed upon exec
+	MEM_STAT_KMAP_HITS, // Temporary kernel mappings of frames that were still mapped
+	MEM_STAT_KMAP_FLUSHES, // TLB invalidations of the whole temporary mapping area
+	MEM_STAT_PROCESS_RESIDENT_PAGES, // Pages of the calling process backed by a frame, shared ones included
+	MEM_STAT_SHARED_MEMORY_PAGES, // Frames held by shared memory objects (MAP_SHARED, shm_open)
+	MEM_STAT_SHARED_PAGE_FAULTS, // Faults mapping a page of a shared memory object, no copy involved
+	MEM_STAT_COUNT
+};
+
+/**
+ * Gets memory statistics
+ * @param stats buffer to write statistics in, indexed by mem_stat
+ * @param n number of entries in stats
+ * @return number of entries written
+ */
+unsigned int get_mem_stats(unsigned int* stats, unsigned int n);
+
+/** Information about a kernel object cache */
+struct kmem_cache_info
+{
+	char name[24];
+	unsigned int object_size;
+	unsigned int active_objects; // Objects currently allocated
+	unsigned int pages; // Pages currently used by the cache
+	unsigned int high_water; // Highest number of objects simultaneously allocated
+};
+
+/**
+ * Gets information about kernel object caches
+ * @param infos buffer to write information in
+ * @param n number of entries in infos
+ * @return number of entries written
+ */
+unsigned int get_slab_info(struct kmem_cache_info* infos, unsigned int n);
+
+/**
+ * Gets the number of timer interrupts taken by all processors since boot. Timers are programmed for the next event
+ * only, so the count barely increases while the system is idle
+ * @return number of timer interrupts
+ */
+unsigned int get_timer_interrupts();
+
 // Dummy function to force the linker to link libk. It is referenced in start_program.s
 extern "C" void libk_force_link();
 
@@ -3,7 +3,9 @@
 #include <errno.h>
 #include <mlibc/debug.hpp>
 #include <mlibc/sysdeps.hpp>
+#include <stdint.h>
 #include <stdio.h>
+#include <sys/resource.h>
 #include <sys/statvfs.h>
 
 #define STUB()                                                         \
@@ -130,8 +132,17 @@ int SysdepImpl<VmMap>::operator()(void *hint, size_t size, int prot, int flags,
 }
 
 int SysdepImpl<VmUnmap>::operator()(void *pointer, size_t size) {
-    (void)pointer; (void)size;
-    STUB();
+	const auto ret = do_syscall(54, pointer, size);
+	if (const int e = sc_error(ret); e)
+		return e;
+	return 0;
+}
+
+int SysdepImpl<Madvise>::operator()(void *addr, size_t length, int advice) {
+	const auto ret = do_syscall(55, addr, length, advice);
+	if (const int e = sc_error(ret); e)
+		return e;
+	return 0;
 }
 
 int SysdepImpl<TcbSet>::operator()(void *pointer) {
@@ -282,8 +293,13 @@ void SysdepImpl<ThreadExit>::operator()() {
 
 int SysdepImpl<Unlinkat>::operator()(int fd,
         const char *path, int flags) {
-    (void)fd; (void)path; (void)flags;
-    STUB();
+    (void)fd; // Paths are resolved by the kernel
+    if (flags)
+        return ENOSYS; // Directories cannot be removed
+	const auto ret = do_syscall(57, path);
+	if (const int e = sc_error(ret); e)
+		return e;
+	return 0;
 }
 
 int SysdepImpl<VmProtect>::operator()(void *pointer,
@@ -427,8 +443,10 @@ int SysdepImpl<Fsync>::operator()(int fd) {
 }
 
 int SysdepImpl<Ftruncate>::operator()(int fd, size_t size) {
-    (void)fd; (void)size;
-    STUB();
+	const auto ret = do_syscall(56, fd, size);
+	if (const int e = sc_error(ret); e)
+		return e;
+	return 0;
 }
 
 int SysdepImpl<GetCwd>::operator()(char *buffer, size_t size) {
@@ -550,8 +568,14 @@ int SysdepImpl<Mknodat>::operator()(int dirfd, const char *path, int mode, int d
 }
 
 int SysdepImpl<Nice>::operator()(int nice, int *new_nice) {
-    (void)nice; (void)new_nice;
-    STUB();
+	const auto ret = do_syscall(59, 0);
+	if (const int e = sc_error(ret); e)
+		return e;
+	const int current = 20 - sc_int_result<int>(ret);
+	if (const int e = sc_error(do_syscall(58, 0, current + nice)); e)
+		return e;
+	// The kernel clamps the value
+	return SysdepImpl<GetPriority>{}(PRIO_PROCESS, 0, new_nice);
 }
 
 int SysdepImpl<Openat>::operator()(int dirfd, const char *path, int flags, mode_t mode, int *fd) {
@@ -642,8 +666,15 @@ int SysdepImpl<SetUid>::operator()(uid_t uid) {
 }
 
 int SysdepImpl<Sleep>::operator()(time_t *secs, long *nanos) {
-    (void)secs; (void)nanos;
-    STUB();
+	// Computed in 64 bits, as seconds may not fit in a long once in milliseconds. Round up, sleeping less is not allowed
+	const int64_t ms = (int64_t)*secs * 1000 + (*nanos + 999999) / 1000000;
+	const auto ret = do_syscall(60, (long)(ms < INT32_MAX ? ms : INT32_MAX)); // Longer sleeps are clamped, ~24 days
+	if (const int e = sc_error(ret); e)
+		return e;
+	// Sleeps are not interrupted by signals, there is no time left
+	*secs = 0;
+	*nanos = 0;
+	return 0;
 }
 
 int SysdepImpl<Symlink>::operator()(const char *target_path, const char *link_path) {
@@ -823,9 +854,15 @@ int SysdepImpl<GetParam>::operator()(int, sched_param*)
     STUB();
 }
 
-int SysdepImpl<GetPriority>::operator()(int, unsigned int, int*)
+int SysdepImpl<GetPriority>::operator()(int which, unsigned int who, int* value)
 {
-    STUB();
+    if (which != PRIO_PROCESS)
+        return EINVAL; // Process groups and users are not supported
+	const auto ret = do_syscall(59, who);
+	if (const int e = sc_error(ret); e)
+		return e;
+	*value = 20 - sc_int_result<int>(ret);
+	return 0;
 }
 
 int SysdepImpl<GetRlimit>::operator()(int, rlimit*)
@@ -1028,9 +1065,14 @@ int SysdepImpl<SetParam>::operator()(int, sched_param const*)
     STUB();
 }
 
-int SysdepImpl<SetPriority>::operator()(int, unsigned int, int)
+int SysdepImpl<SetPriority>::operator()(int which, unsigned int who, int prio)
 {
-    STUB();
+    if (which != PRIO_PROCESS)
+        return EINVAL; // Process groups and users are not supported
+	const auto ret = do_syscall(58, who, prio);
+	if (const int e = sc_error(ret); e)
+		return e;
+	return 0;
 }
 
 int SysdepImpl<SetRlimit>::operator()(int, rlimit const*)
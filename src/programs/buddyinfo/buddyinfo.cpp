@@ -0,0 +1,22 @@
+#include <stdio.h>
+
+#include <ksyscalls.h>
+
+#define MAX_ORDERS 32
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[])
+{
+    unsigned int counts[MAX_ORDERS];
+    unsigned int n = get_buddy_info(counts, MAX_ORDERS);
+
+    unsigned int free_frames = 0;
+    printf("order  free blocks\n");
+    for (unsigned int order = 0; order < n; order++)
+    {
+        printf("%5u  %u\n", order, counts[order]);
+        free_frames += counts[order] << order;
+    }
+    printf("free memory: %u KiB\n", free_frames * 4);
+
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define N_ROUND_TRIPS 1000
+
+/**
+ * Measures the average cost of a round trip between two processes ping-ponging a byte over two pipes.
+ * Each round trip involves two address space switches, plus the syscalls and the scheduler work around them.
+ */
+uint64_t measure_round_trip()
+{
+    int to_child[2], to_parent[2];
+    if (pipe(to_child) == -1 || pipe(to_parent) == -1)
+        return 0;
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        char c;
+        for (int i = 0; i < N_ROUND_TRIPS; i++)
+        {
+            read(to_child[0], &c, 1);
+            write(to_parent[1], &c, 1);
+        }
+        _exit(0);
+    }
+
+    char c = 'x';
+    uint64_t start = __builtin_ia32_rdtsc();
+    for (int i = 0; i < N_ROUND_TRIPS; i++)
+    {
+        write(to_child[1], &c, 1);
+        read(to_parent[0], &c, 1);
+    }
+    uint64_t cycles = __builtin_ia32_rdtsc() - start;
+
+    int status;
+    waitpid(pid, &status, 0);
+    close(to_child[0]);
+    close(to_child[1]);
+    close(to_parent[0]);
+    close(to_parent[1]);
+
+    return cycles / N_ROUND_TRIPS;
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[])
+{
+    printf("pipe round trip (2 context switches): %llu cycles\n", measure_round_trip());
+
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <ksyscalls.h>
+
+#define N_EXECS 20
+
+/** Measures the cost of running a program: fork, exec, run and wait for it. Its output is discarded */
+uint64_t measure_exec(char* const argv[])
+{
+    uint64_t start = __builtin_ia32_rdtsc();
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        close(STDOUT_FILENO);
+        execv(argv[0], argv);
+        _exit(1);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+
+    return __builtin_ia32_rdtsc() - start;
+}
+
+/** Runs a program repeatedly, the first run shows the cost of a cold exec, the following ones the cached path */
+void bench(char* const argv[])
+{
+    unsigned int stats_before[MEM_STAT_COUNT]{}, stats_after[MEM_STAT_COUNT]{};
+    get_mem_stats(stats_before, MEM_STAT_COUNT);
+
+    uint64_t first = measure_exec(argv);
+    uint64_t total = 0;
+    for (int i = 1; i < N_EXECS; i++)
+        total += measure_exec(argv);
+
+    get_mem_stats(stats_after, MEM_STAT_COUNT);
+    printf("%s: first exec %llu cycles, then %llu cycles on average (ELF image cache: %u hits, %u misses)\n", argv[0],
+           first, total / (N_EXECS - 1),
+           stats_after[MEM_STAT_ELF_IMAGE_CACHE_HITS] - stats_before[MEM_STAT_ELF_IMAGE_CACHE_HITS],
+           stats_after[MEM_STAT_ELF_IMAGE_CACHE_MISSES] - stats_before[MEM_STAT_ELF_IMAGE_CACHE_MISSES]);
+}
+
+int main(int argc, char* argv[])
+{
+    // Command to bench may be given as arguments, ls and cat are benched otherwise
+    if (argc > 1)
+    {
+        bench(argv + 1);
+        return 0;
+    }
+
+    char ls[] = "/bin/ls";
+    char cat[] = "/bin/cat";
+    char cat_arg[] = "/bin/cat";
+    char* const ls_argv[] = {ls, nullptr};
+    char* const cat_argv[] = {cat, cat_arg, nullptr};
+    bench(ls_argv);
+    bench(cat_argv);
+
+    return 0;
+}
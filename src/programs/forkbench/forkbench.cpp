@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <ksyscalls.h>
+
+#define N_FORKS 100
+#define MAX_ORDERS 32
+
+/** Number of free physical frames */
+unsigned int get_num_free_frames()
+{
+    unsigned int counts[MAX_ORDERS];
+    unsigned int n = get_buddy_info(counts, MAX_ORDERS);
+
+    unsigned int free_frames = 0;
+    for (unsigned int order = 0; order < n; order++)
+        free_frames += counts[order] << order;
+
+    return free_frames;
+}
+
+/** Measures the average cost of a fork followed by the child exiting right away */
+uint64_t measure_fork_exit()
+{
+    uint64_t start = __builtin_ia32_rdtsc();
+    for (int i = 0; i < N_FORKS; i++)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+            _exit(0);
+        int status;
+        waitpid(pid, &status, 0);
+    }
+
+    return (__builtin_ia32_rdtsc() - start) / N_FORKS;
+}
+
+/** Measures how many frames a freshly forked child holds on to */
+unsigned int measure_child_frames()
+{
+    int pipefd[2];
+    if (pipe(pipefd) == -1)
+        return 0;
+
+    unsigned int free_frames_before = get_num_free_frames();
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        char c;
+        read(pipefd[0], &c, 1); // Stay alive until parent is done measuring
+        _exit(0);
+    }
+    unsigned int free_frames_after = get_num_free_frames();
+
+    write(pipefd[1], "x", 1);
+    int status;
+    waitpid(pid, &status, 0);
+    close(pipefd[0]);
+    close(pipefd[1]);
+
+    return free_frames_before - free_frames_after;
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[])
+{
+    printf("fork + exit: %llu cycles\n", measure_fork_exit());
+    printf("forked child memory: %u KiB\n", measure_child_frames() * 4);
+
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+#define N_KEYSTROKES 200
+#define N_HOGS 8 // More than processors, so that the echoing process has to preempt one
+
+struct latency
+{
+    uint64_t average, max;
+};
+
+/** CPU bound work, which touches no memory */
+uint32_t work(uint32_t iterations, uint32_t x)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        // xorshift32
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        __asm__ volatile("" : "+r"(x)); // Keep the loop from being elided
+    }
+
+    return x;
+}
+
+/** CPU bound process, running until killed */
+[[noreturn]] void hog(int nice_increment)
+{
+    if (nice_increment)
+        nice(nice_increment);
+
+    for (uint32_t x = 1;;)
+        x = work(1u << 20, x);
+}
+
+/**
+ * Measures the time it takes for a process blocked in read, as a shell waiting for a key is, to wake up and echo what
+ * it has been sent, while CPU bound processes run
+ * @param n_hogs number of CPU bound processes
+ * @param hog_nice nice increment of CPU bound processes
+ */
+latency measure(int n_hogs, int hog_nice)
+{
+    latency res{};
+    int to_echo[2], from_echo[2];
+    if (pipe(to_echo) == -1 || pipe(from_echo) == -1)
+        return res;
+
+    pid_t echo = fork();
+    if (echo == 0)
+    {
+        char c;
+        for (int i = 0; i < N_KEYSTROKES; i++)
+        {
+            read(to_echo[0], &c, 1);
+            write(from_echo[1], &c, 1);
+        }
+        _exit(0);
+    }
+
+    pid_t hogs[N_HOGS];
+    for (int i = 0; i < n_hogs; i++)
+    {
+        if ((hogs[i] = fork()) == 0)
+            hog(hog_nice);
+    }
+
+    char c = 'x';
+    uint32_t think = 1;
+    uint64_t total = 0;
+    for (int i = 0; i < N_KEYSTROKES; i++)
+    {
+        // Give hogs time to use up their quanta between keystrokes, as a typing user would
+        think = work(1u << 20, think);
+
+        uint64_t start = __builtin_ia32_rdtsc();
+        write(to_echo[1], &c, 1);
+        read(from_echo[0], &c, 1);
+        uint64_t cycles = __builtin_ia32_rdtsc() - start;
+
+        total += cycles;
+        if (cycles > res.max)
+            res.max = cycles;
+    }
+    res.average = total / N_KEYSTROKES;
+
+    int status;
+    for (int i = 0; i < n_hogs; i++)
+    {
+        kill(hogs[i], SIGKILL);
+        waitpid(hogs[i], &status, 0);
+    }
+    waitpid(echo, &status, 0);
+    close(to_echo[0]);
+    close(to_echo[1]);
+    close(from_echo[0]);
+    close(from_echo[1]);
+
+    return res;
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[])
+{
+    printf("keystroke to echo latency over %d keystrokes\n", N_KEYSTROKES);
+
+    latency idle = measure(0, 0);
+    printf("idle:               average %llu cycles, max %llu cycles\n", idle.average, idle.max);
+    latency loaded = measure(N_HOGS, 0);
+    printf("%d hogs:            average %llu cycles, max %llu cycles\n", N_HOGS, loaded.average, loaded.max);
+    latency niced = measure(N_HOGS, 19);
+    printf("%d hogs at nice 19: average %llu cycles, max %llu cycles\n", N_HOGS, niced.average, niced.max);
+
+    return 0;
+}
@@ -0,0 +1,36 @@
+#include <stdio.h>
+
+#include <ksyscalls.h>
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[])
+{
+    unsigned int stats[MEM_STAT_COUNT]{};
+    get_mem_stats(stats, MEM_STAT_COUNT);
+
+    printf("zero frame mappings: %u (%u KiB saved)\n", stats[MEM_STAT_ZERO_FRAME_MAPPINGS],
+           stats[MEM_STAT_ZERO_FRAME_MAPPINGS] * 4);
+    printf("zero frame faults:   %u\n", stats[MEM_STAT_ZERO_FRAME_FAULTS]);
+    printf("zeroed frame pool:   %u frames, %u hits, %u misses\n", stats[MEM_STAT_ZEROED_POOL_FRAMES],
+           stats[MEM_STAT_ZEROED_POOL_HITS], stats[MEM_STAT_ZEROED_POOL_MISSES]);
+    printf("fault-around pages:  %u\n", stats[MEM_STAT_FAULT_AROUND_PAGES]);
+    printf("page faults (self):  %u\n", stats[MEM_STAT_PROCESS_PAGE_FAULTS]);
+    printf("resident (self):     %u pages (%u KiB)\n", stats[MEM_STAT_PROCESS_RESIDENT_PAGES],
+           stats[MEM_STAT_PROCESS_RESIDENT_PAGES] * 4);
+
+    const unsigned int requested = stats[MEM_STAT_KMALLOC_REQUESTED_BYTES];
+    const unsigned int allocated = stats[MEM_STAT_KMALLOC_ALLOCATED_BYTES];
+    printf("kmalloc:             %u allocations, %u/%u bytes used (%u%% lost to rounding)\n",
+           stats[MEM_STAT_KMALLOC_ALLOCATIONS], requested, allocated,
+           allocated >= 100 ? (allocated - requested) / (allocated / 100) : 0);
+    printf("file-backed pages:   %u read (%u KiB), %u faults\n", stats[MEM_STAT_FILE_PAGES_READ],
+           stats[MEM_STAT_FILE_PAGES_READ] * 4, stats[MEM_STAT_FILE_PAGE_FAULTS]);
+    printf("page cache:          %u pages (%u KiB), %u hits\n", stats[MEM_STAT_PAGE_CACHE_PAGES],
+           stats[MEM_STAT_PAGE_CACHE_PAGES] * 4, stats[MEM_STAT_PAGE_CACHE_HITS]);
+    printf("ELF image cache:     %u hits, %u misses\n", stats[MEM_STAT_ELF_IMAGE_CACHE_HITS],
+           stats[MEM_STAT_ELF_IMAGE_CACHE_MISSES]);
+    printf("kmap:                %u hits, %u flushes\n", stats[MEM_STAT_KMAP_HITS], stats[MEM_STAT_KMAP_FLUSHES]);
+    printf("shared memory:       %u pages (%u KiB), %u faults\n", stats[MEM_STAT_SHARED_MEMORY_PAGES],
+           stats[MEM_STAT_SHARED_MEMORY_PAGES] * 4, stats[MEM_STAT_SHARED_PAGE_FAULTS]);
+
+    return 0;
+}
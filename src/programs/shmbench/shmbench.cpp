@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <ksyscalls.h>
+
+#define TOTAL_SIZE (16 * 1024 * 1024) // Bytes sent from the producer to the consumer
+#define CHUNK_SIZE (16 * 1024) // Bytes per pipe write, and per ring slot
+#define N_CHUNKS (TOTAL_SIZE / CHUNK_SIZE)
+#define RING_N_SLOTS 16
+#define SHM_NAME "/shmbench"
+
+/** Ring of chunks in shared memory. Only the producer writes head, only the consumer writes tail */
+struct ring
+{
+    uint32_t head; // Chunks produced
+    uint32_t tail; // Chunks consumed
+    char slots[RING_N_SLOTS][CHUNK_SIZE];
+};
+
+#define RING_MAP_SIZE ((sizeof(ring) + 4095) & ~4095)
+
+/** Fills a chunk with data the consumer can check */
+void produce(char* chunk, uint32_t seq)
+{
+    memset(chunk, (char)seq, CHUNK_SIZE);
+}
+
+/** Reads a whole chunk, returns whether it holds what the producer put in it */
+bool consume(const char* chunk, uint32_t seq)
+{
+    uint32_t sum = 0;
+    for (int i = 0; i < CHUNK_SIZE; i++)
+        sum += (unsigned char)chunk[i];
+
+    return sum == (unsigned char)seq * CHUNK_SIZE;
+}
+
+/** Sends the data through a pipe: each chunk is copied into the pipe buffer, then out of it */
+uint64_t bench_pipe()
+{
+    int fds[2];
+    if (pipe(fds))
+    {
+        perror("pipe");
+        return 0;
+    }
+
+    uint64_t start = __builtin_ia32_rdtsc();
+    if (fork() == 0)
+    {
+        close(fds[0]);
+        static char chunk[CHUNK_SIZE];
+        for (uint32_t seq = 0; seq < N_CHUNKS; seq++)
+        {
+            produce(chunk, seq);
+            for (int written = 0; written < CHUNK_SIZE;)
+                written += write(fds[1], chunk + written, CHUNK_SIZE - written);
+        }
+        _exit(0);
+    }
+
+    close(fds[1]);
+    static char chunk[CHUNK_SIZE];
+    bool ok = true;
+    for (uint32_t seq = 0; seq < N_CHUNKS; seq++)
+    {
+        for (int n = 0; n < CHUNK_SIZE;)
+            n += read(fds[0], chunk + n, CHUNK_SIZE - n);
+        ok &= consume(chunk, seq);
+    }
+    close(fds[0]);
+    int status;
+    wait(&status);
+    if (!ok)
+        printf("FAIL: pipe data corrupted\n");
+
+    return __builtin_ia32_rdtsc() - start;
+}
+
+/** Maps a ring, either from a named shared memory object or anonymous */
+ring* map_ring(bool named)
+{
+    if (!named)
+    {
+        void* r = mmap(nullptr, RING_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        return r == MAP_FAILED ? nullptr : (ring*)r;
+    }
+
+    int fd = shm_open(SHM_NAME, O_CREAT | O_EXCL | O_RDWR, 0777);
+    if (fd == -1)
+        return nullptr;
+    void* r = MAP_FAILED;
+    if (!ftruncate(fd, RING_MAP_SIZE))
+        r = mmap(nullptr, RING_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    shm_unlink(SHM_NAME); // The mapping keeps the object alive
+
+    return r == MAP_FAILED ? nullptr : (ring*)r;
+}
+
+/**
+ * Sends the data through a ring in shared memory: the producer writes chunks right where the consumer reads them.
+ * There is no yield syscall, a side waiting for the other one spins until the end of its quantum
+ */
+uint64_t bench_shm(bool named)
+{
+    ring* r = map_ring(named);
+    if (!r)
+    {
+        perror(named ? "shm_open" : "mmap");
+        return 0;
+    }
+
+    uint64_t start = __builtin_ia32_rdtsc();
+    if (fork() == 0)
+    {
+        for (uint32_t seq = 0; seq < N_CHUNKS; seq++)
+        {
+            while (seq - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) == RING_N_SLOTS) {}
+            produce(r->slots[seq % RING_N_SLOTS], seq);
+            __atomic_store_n(&r->head, seq + 1, __ATOMIC_RELEASE);
+        }
+        _exit(0);
+    }
+
+    bool ok = true;
+    for (uint32_t seq = 0; seq < N_CHUNKS; seq++)
+    {
+        while (__atomic_load_n(&r->head, __ATOMIC_ACQUIRE) == seq) {}
+        ok &= consume(r->slots[seq % RING_N_SLOTS], seq);
+        __atomic_store_n(&r->tail, seq + 1, __ATOMIC_RELEASE);
+    }
+    int status;
+    wait(&status);
+    munmap(r, RING_MAP_SIZE);
+    if (!ok)
+        printf("FAIL: %s ring data corrupted\n", named ? "shm_open" : "anonymous");
+
+    return __builtin_ia32_rdtsc() - start;
+}
+
+int main()
+{
+    unsigned int stats_before[MEM_STAT_COUNT]{}, stats_after[MEM_STAT_COUNT]{};
+
+    printf("sending %u KiB in %u KiB chunks\n", TOTAL_SIZE / 1024, CHUNK_SIZE / 1024);
+    printf("pipe:                 %llu cycles\n", bench_pipe());
+
+    get_mem_stats(stats_before, MEM_STAT_COUNT);
+    printf("shm_open ring:        %llu cycles\n", bench_shm(true));
+    printf("MAP_SHARED anon ring: %llu cycles\n", bench_shm(false));
+    get_mem_stats(stats_after, MEM_STAT_COUNT);
+    printf("shared page faults:   %u\n",
+           stats_after[MEM_STAT_SHARED_PAGE_FAULTS] - stats_before[MEM_STAT_SHARED_PAGE_FAULTS]);
+
+    return 0;
+}
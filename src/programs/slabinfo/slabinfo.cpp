@@ -0,0 +1,21 @@
+#include <stdio.h>
+
+#include <ksyscalls.h>
+
+#define MAX_CACHES 64
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[])
+{
+    kmem_cache_info infos[MAX_CACHES];
+    unsigned int n = get_slab_info(infos, MAX_CACHES);
+
+    printf("%-24s %8s %8s %8s %8s\n", "name", "objsize", "active", "max", "pages");
+    for (unsigned int i = 0; i < n; i++)
+    {
+        const kmem_cache_info& info = infos[i];
+        printf("%-24s %8u %8u %8u %8u\n", info.name, info.object_size, info.active_objects, info.high_water,
+               info.pages);
+    }
+
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define TOTAL_ITERATIONS (1u << 28) // Work split between the workers
+#define MAX_WORKERS 4
+
+/** CPU bound work, which touches no memory so that workers do not slow each other down */
+uint32_t work(uint32_t iterations, uint32_t seed)
+{
+    uint32_t x = seed | 1;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        // xorshift32
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+    }
+
+    return x;
+}
+
+/** Splits the work between n forked workers and waits for all of them */
+uint64_t bench(int n)
+{
+    uint64_t start = __builtin_ia32_rdtsc();
+    for (int i = 0; i < n; i++)
+    {
+        if (fork() == 0)
+            _exit((int)(work(TOTAL_ITERATIONS / n, i + 1) & 0x7F)); // Use the result so that the work is not elided
+    }
+
+    int status;
+    for (int i = 0; i < n; i++)
+        wait(&status);
+
+    return __builtin_ia32_rdtsc() - start;
+}
+
+int main()
+{
+    printf("%u xorshift iterations split between workers\n", TOTAL_ITERATIONS);
+
+    uint64_t single = 0;
+    for (int n = 1; n <= MAX_WORKERS; n *= 2)
+    {
+        uint64_t cycles = bench(n);
+        if (n == 1)
+            single = cycles;
+        printf("%d worker%s %llu cycles, speedup x%llu.%02llu\n", n, n == 1 ? ": " : "s:", cycles,
+               single / cycles, single * 100 / cycles % 100);
+    }
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ksyscalls.h>
+
+#define BUF_SIZE (4 * 1024 * 1024)
+#define PAGE_SIZE 4096
+
+/** Number of pages of the process backed by a frame */
+unsigned int resident_pages()
+{
+    unsigned int stats[MEM_STAT_COUNT]{};
+    get_mem_stats(stats, MEM_STAT_COUNT);
+
+    return stats[MEM_STAT_PROCESS_RESIDENT_PAGES];
+}
+
+int main()
+{
+    const unsigned int base = resident_pages();
+
+    auto buf = (char*)mmap(nullptr, BUF_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf == MAP_FAILED)
+    {
+        perror("mmap");
+        return 1;
+    }
+    memset(buf, 0x42, BUF_SIZE);
+    printf("buffer written:       %u pages resident (+%u)\n", resident_pages(), resident_pages() - base);
+
+    // First half: frames are dropped, pages read as zeroes again
+    if (madvise(buf, BUF_SIZE / 2, MADV_DONTNEED))
+    {
+        perror("madvise");
+        return 1;
+    }
+    printf("madvise(DONTNEED):    %u pages resident (+%u)\n", resident_pages(), resident_pages() - base);
+    for (int i = 0; i < BUF_SIZE / 2; i += PAGE_SIZE)
+    {
+        if (buf[i])
+        {
+            printf("FAIL: page %d not zeroed after madvise\n", i / PAGE_SIZE);
+            return 1;
+        }
+    }
+
+    // Unmap a range in the middle of the second half, then the rest of the buffer, around it
+    char* hole = buf + BUF_SIZE / 2 + BUF_SIZE / 8;
+    if (munmap(hole, BUF_SIZE / 8))
+    {
+        perror("munmap");
+        return 1;
+    }
+    if (hole[-1] != 0x42 || hole[BUF_SIZE / 8] != 0x42)
+    {
+        printf("FAIL: partial munmap touched the rest of the buffer\n");
+        return 1;
+    }
+    printf("partial munmap:       %u pages resident (+%u)\n", resident_pages(), resident_pages() - base);
+    if (munmap(buf, hole - buf) || munmap(hole + BUF_SIZE / 8, buf + BUF_SIZE - (hole + BUF_SIZE / 8)))
+    {
+        perror("munmap");
+        return 1;
+    }
+    printf("munmap:               %u pages resident (+%u)\n", resident_pages(), resident_pages() - base);
+
+    return 0;
+}
@@ -0,0 +1,18 @@
+#include <stdio.h>
+#include <unistd.h>
+
+#include <ksyscalls.h>
+
+#define SAMPLE_SECONDS 5
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[])
+{
+    // Nothing runs while this process sleeps, but the kernel processes (framebuffer refresh...)
+    unsigned int before = get_timer_interrupts();
+    sleep(SAMPLE_SECONDS);
+    unsigned int after = get_timer_interrupts();
+
+    printf("timer interrupts while idle: %u per second\n", (after - before) / SAMPLE_SECONDS);
+
+    return 0;
+}